@@ -46,5 +46,5 @@ struct TempArena
 TempArena TempArenaBegin(Arena* const originalArena);
 void TempArenaEnd(TempArena* const tempArena);
 
-#define PushArray(arena, type, count) (rcast<type*>(ArenaAllocAligned(arena, sizeof(type) * count)))
+#define PushArray(arena, type, count) (rcast<type*>(ArenaAllocAligned(arena, sizeof(type) * (count))))
 #define PushStruct(value, arrPointer, counter) (arrPointer[counter++] = value)
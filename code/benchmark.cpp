@@ -0,0 +1,454 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "log.h"
+#include "fileio.h"
+#include "objparser.h"
+#include "vector.h"
+#include "matrix.h"
+
+// NOTE(sbalse): Every file is parsed this many times and the fastest run is reported, which filters out
+// page faults of the first touch of the mapped file and other noise.
+inline constexpr int OBJ_BENCHMARK_RUNS = 10;
+
+void RunObjBenchmark(Arena* const arena, const char* const directory)
+{
+    LOG_INFO("Benchmarking obj parsing of all files in: %s...", directory);
+
+    std::error_code error;
+    std::filesystem::directory_iterator files(directory, error);
+    if (error)
+    {
+        LOG_ERROR("Failed to open benchmark directory: %s.", directory);
+        return;
+    }
+
+    size_t totalBytes = 0;
+    size_t totalVertices = 0;
+    double totalSeconds = 0.0;
+    int numFiles = 0;
+
+    for (const std::filesystem::directory_entry& entry : files)
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".obj")
+        {
+            continue;
+        }
+
+        const std::string fileName = entry.path().string();
+
+        MappedFile file = {};
+        if (!MapFile(fileName.c_str(), &file))
+        {
+            LOG_ERROR("Failed to open obj file: %s.", fileName.c_str());
+            continue;
+        }
+
+        double bestSeconds = 0.0;
+        size_t verticesCount = 0;
+        size_t facesCount = 0;
+
+        for (int run = 0; run < OBJ_BENCHMARK_RUNS; run++)
+        {
+            TempArena temp = TempArenaBegin(arena);
+
+            const auto startTime = std::chrono::steady_clock::now();
+            const ObjMesh objMesh = ParseObj(temp.m_OriginalArena, rcast<const char*>(file.m_Data), file.m_Size);
+            const std::chrono::duration<double> parseTime = std::chrono::steady_clock::now() - startTime;
+
+            TempArenaEnd(&temp);
+
+            if (run == 0 || parseTime.count() < bestSeconds)
+            {
+                bestSeconds = parseTime.count();
+            }
+            verticesCount = objMesh.m_VerticesCount;
+            facesCount = objMesh.m_FacesCount;
+        }
+
+        LOG_INFO(
+            "%s: %.2f MB, %zu vertices, %zu triangles in %.3f ms. %.1f MB/s, %.2f M vertices/s.",
+            fileName.c_str(),
+            scast<double>(file.m_Size) / (1024.0 * 1024.0),
+            verticesCount,
+            facesCount,
+            bestSeconds * 1000.0,
+            scast<double>(file.m_Size) / (1024.0 * 1024.0) / bestSeconds,
+            scast<double>(verticesCount) / 1000000.0 / bestSeconds
+        );
+
+        totalBytes += file.m_Size;
+        totalVertices += verticesCount;
+        totalSeconds += bestSeconds;
+        numFiles++;
+
+        UnmapFile(&file);
+    }
+
+    if (numFiles == 0 || totalSeconds <= 0.0)
+    {
+        LOG_ERROR("No obj files found in: %s.", directory);
+        return;
+    }
+
+    LOG_INFO(
+        "Total: %d files, %.2f MB, %zu vertices in %.3f ms. %.1f MB/s, %.2f M vertices/s.",
+        numFiles,
+        scast<double>(totalBytes) / (1024.0 * 1024.0),
+        totalVertices,
+        totalSeconds * 1000.0,
+        scast<double>(totalBytes) / (1024.0 * 1024.0) / totalSeconds,
+        scast<double>(totalVertices) / 1000000.0 / totalSeconds
+    );
+}
+
+// NOTE(sbalse): Copies of the math functions as they were before the math moved to the headers: compiled out of
+// line, taking the matrices by value and storing them row-major. The math benchmark compares against them.
+struct RowMajorMat4
+{
+    float m_Values[4][4];
+};
+
+static NOINLINE Vec4 OutOfLineMat4MulVec4(const RowMajorMat4 m, const Vec4 v)
+{
+    Vec4 result = {};
+    result.m_X = m.m_Values[0][0] * v.m_X + m.m_Values[0][1] * v.m_Y + m.m_Values[0][2] * v.m_Z + m.m_Values[0][3] * v.m_W;
+    result.m_Y = m.m_Values[1][0] * v.m_X + m.m_Values[1][1] * v.m_Y + m.m_Values[1][2] * v.m_Z + m.m_Values[1][3] * v.m_W;
+    result.m_Z = m.m_Values[2][0] * v.m_X + m.m_Values[2][1] * v.m_Y + m.m_Values[2][2] * v.m_Z + m.m_Values[2][3] * v.m_W;
+    result.m_W = m.m_Values[3][0] * v.m_X + m.m_Values[3][1] * v.m_Y + m.m_Values[3][2] * v.m_Z + m.m_Values[3][3] * v.m_W;
+    return result;
+}
+
+static NOINLINE RowMajorMat4 OutOfLineMat4MulMat4(const RowMajorMat4 m1, const RowMajorMat4 m2)
+{
+    RowMajorMat4 result = {};
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            result.m_Values[i][j] =
+                m1.m_Values[i][0] * m2.m_Values[0][j]
+                + m1.m_Values[i][1] * m2.m_Values[1][j]
+                + m1.m_Values[i][2] * m2.m_Values[2][j]
+                + m1.m_Values[i][3] * m2.m_Values[3][j];
+        }
+    }
+    return result;
+}
+
+static NOINLINE Vec3 OutOfLineVec3Sub(const Vec3 v1, const Vec3 v2)
+{
+    return { v1.m_X - v2.m_X, v1.m_Y - v2.m_Y, v1.m_Z - v2.m_Z };
+}
+
+static NOINLINE Vec3 OutOfLineVec3Cross(const Vec3 v1, const Vec3 v2)
+{
+    return
+    {
+        v1.m_Y * v2.m_Z - v1.m_Z * v2.m_Y,
+        v1.m_Z * v2.m_X - v1.m_X * v2.m_Z,
+        v1.m_X * v2.m_Y - v1.m_Y * v2.m_X,
+    };
+}
+
+static NOINLINE float OutOfLineVec3Dot(const Vec3 v1, const Vec3 v2)
+{
+    return (v1.m_X * v2.m_X) + (v1.m_Y * v2.m_Y) + (v1.m_Z * v2.m_Z);
+}
+
+static NOINLINE void OutOfLineVec3Normalize(Vec3* const v)
+{
+    const float magnitude = std::sqrtf(OutOfLineVec3Dot(*v, *v));
+    *v = { v->m_X / magnitude, v->m_Y / magnitude, v->m_Z / magnitude };
+}
+
+static RowMajorMat4 RowMajorMat4FromMat4(const Mat4& m)
+{
+    RowMajorMat4 result = {};
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            result.m_Values[row][column] = Mat4Get(m, row, column);
+        }
+    }
+    return result;
+}
+
+static Mat4 Mat4FromRowMajorMat4(const RowMajorMat4& m)
+{
+    Mat4 result = {};
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            Mat4Set(&result, row, column, m.m_Values[row][column]);
+        }
+    }
+    return result;
+}
+
+// NOTE(sbalse): The inputs and outputs of one math benchmark case. Every case runs over all count elements.
+struct MathBenchmarkData
+{
+    size_t m_Count;
+    Mat4 m_Matrix;
+    RowMajorMat4 m_RowMajorMatrix;
+    const Vec4* m_Vectors;
+    const Mat4* m_Matrices;
+    const RowMajorMat4* m_RowMajorMatrices;
+    Vec4* m_OutVectors;
+    Mat4* m_OutMatrices;
+    RowMajorMat4* m_OutRowMajorMatrices;
+    float* m_OutValues;
+};
+
+using MathBenchmarkFunc = void (*)(const MathBenchmarkData& data);
+
+static void TransformVectorsOutOfLine(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i < data.m_Count; i++)
+    {
+        data.m_OutVectors[i] = OutOfLineMat4MulVec4(data.m_RowMajorMatrix, data.m_Vectors[i]);
+    }
+}
+
+static void TransformVectorsInline(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i < data.m_Count; i++)
+    {
+        data.m_OutVectors[i] = data.m_Matrix * data.m_Vectors[i];
+    }
+}
+
+static void MultiplyMatricesOutOfLine(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i < data.m_Count; i++)
+    {
+        data.m_OutRowMajorMatrices[i] = OutOfLineMat4MulMat4(data.m_RowMajorMatrix, data.m_RowMajorMatrices[i]);
+    }
+}
+
+static void MultiplyMatricesInline(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i < data.m_Count; i++)
+    {
+        data.m_OutMatrices[i] = data.m_Matrix * data.m_Matrices[i];
+    }
+}
+
+// NOTE(sbalse): The backface culling math of a triangle: its normal and how much it faces the camera. Every
+// three vectors in a row make up a triangle.
+static void CullTrianglesOutOfLine(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i + 2 < data.m_Count; i += 3)
+    {
+        const Vec3 a = Vec3FromVec4(data.m_Vectors[i]);
+        const Vec3 b = Vec3FromVec4(data.m_Vectors[i + 1]);
+        const Vec3 c = Vec3FromVec4(data.m_Vectors[i + 2]);
+        Vec3 normal = OutOfLineVec3Cross(OutOfLineVec3Sub(b, a), OutOfLineVec3Sub(c, a));
+        OutOfLineVec3Normalize(&normal);
+        data.m_OutValues[i / 3] = OutOfLineVec3Dot(normal, OutOfLineVec3Sub(ORIGIN, a));
+    }
+}
+
+static void CullTrianglesInline(const MathBenchmarkData& data)
+{
+    for (size_t i = 0; i + 2 < data.m_Count; i += 3)
+    {
+        const Vec3 a = Vec3FromVec4(data.m_Vectors[i]);
+        const Vec3 b = Vec3FromVec4(data.m_Vectors[i + 1]);
+        const Vec3 c = Vec3FromVec4(data.m_Vectors[i + 2]);
+        Vec3 normal = Vec3Cross(b - a, c - a);
+        Vec3Normalize(&normal);
+        data.m_OutValues[i / 3] = Vec3Dot(normal, ORIGIN - a);
+    }
+}
+
+// NOTE(sbalse): Every case is run this many times and the fastest run is reported.
+inline constexpr int MATH_BENCHMARK_RUNS = 5;
+
+static double GetBestMathBenchmarkSeconds(const MathBenchmarkFunc func, const MathBenchmarkData& data)
+{
+    double bestSeconds = 0.0;
+    for (int run = 0; run < MATH_BENCHMARK_RUNS; run++)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        func(data);
+        const std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - startTime;
+        if (run == 0 || runTime.count() < bestSeconds)
+        {
+            bestSeconds = runTime.count();
+        }
+    }
+    return bestSeconds;
+}
+
+static void LogMathBenchmarkCase(
+    const char* const name,
+    const size_t numOperations,
+    const double outOfLineSeconds,
+    const double inlineSeconds,
+    const bool isSameResult)
+{
+    LOG_INFO(
+        "%-12s %7.2f ns out of line, %7.2f ns inline per operation (%.2fx faster).",
+        name,
+        outOfLineSeconds * 1e9 / scast<double>(numOperations),
+        inlineSeconds * 1e9 / scast<double>(numOperations),
+        outOfLineSeconds / inlineSeconds
+    );
+    if (!isSameResult)
+    {
+        LOG_ERROR("%s: the out of line and the inline versions give different results.", name);
+    }
+}
+
+// NOTE(sbalse): Small pseudo random values in [-8, 8), the same on every run.
+static float GetMathBenchmarkValue(u32* const state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return scast<float>(*state >> 8) * (16.0f / scast<float>(1u << 24)) - 8.0f;
+}
+
+void RunMathBenchmark(Arena* const arena, const size_t count)
+{
+    LOG_INFO("Benchmarking the vector and matrix math over %zu elements, best of %d runs...", count, MATH_BENCHMARK_RUNS);
+
+    TempArena temp = TempArenaBegin(arena);
+    Arena* const tempArena = temp.m_OriginalArena;
+
+    MathBenchmarkData data = {};
+    data.m_Count = count;
+
+    u32 randomState = 1;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            Mat4Set(&data.m_Matrix, row, column, GetMathBenchmarkValue(&randomState));
+        }
+    }
+    data.m_RowMajorMatrix = RowMajorMat4FromMat4(data.m_Matrix);
+
+    Vec4* const vectors = PushArray(tempArena, Vec4, count);
+    Mat4* const matrices = PushArray(tempArena, Mat4, count);
+    RowMajorMat4* const rowMajorMatrices = PushArray(tempArena, RowMajorMat4, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        vectors[i] =
+        {
+            GetMathBenchmarkValue(&randomState),
+            GetMathBenchmarkValue(&randomState),
+            GetMathBenchmarkValue(&randomState),
+            1.0f,
+        };
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                Mat4Set(&matrices[i], row, column, GetMathBenchmarkValue(&randomState));
+            }
+        }
+        rowMajorMatrices[i] = RowMajorMat4FromMat4(matrices[i]);
+    }
+    data.m_Vectors = vectors;
+    data.m_Matrices = matrices;
+    data.m_RowMajorMatrices = rowMajorMatrices;
+    data.m_OutVectors = PushArray(tempArena, Vec4, count);
+    data.m_OutMatrices = PushArray(tempArena, Mat4, count);
+    data.m_OutRowMajorMatrices = PushArray(tempArena, RowMajorMat4, count);
+    data.m_OutValues = PushArray(tempArena, float, count);
+
+    // NOTE(sbalse): The results of the out of line run are kept so the inline ones can be checked against them.
+    Vec4* const expectedVectors = PushArray(tempArena, Vec4, count);
+    float* const expectedValues = PushArray(tempArena, float, count);
+
+    {
+        const double outOfLineSeconds = GetBestMathBenchmarkSeconds(TransformVectorsOutOfLine, data);
+        std::memcpy(expectedVectors, data.m_OutVectors, count * sizeof(Vec4));
+        const double inlineSeconds = GetBestMathBenchmarkSeconds(TransformVectorsInline, data);
+        const bool isSameResult = std::memcmp(expectedVectors, data.m_OutVectors, count * sizeof(Vec4)) == 0;
+        LogMathBenchmarkCase("Mat4MulVec4", count, outOfLineSeconds, inlineSeconds, isSameResult);
+    }
+
+    {
+        const double outOfLineSeconds = GetBestMathBenchmarkSeconds(MultiplyMatricesOutOfLine, data);
+        const double inlineSeconds = GetBestMathBenchmarkSeconds(MultiplyMatricesInline, data);
+        bool isSameResult = true;
+        for (size_t i = 0; i < count && isSameResult; i++)
+        {
+            const Mat4 expected = Mat4FromRowMajorMat4(data.m_OutRowMajorMatrices[i]);
+            isSameResult = std::memcmp(&expected, &data.m_OutMatrices[i], sizeof(Mat4)) == 0;
+        }
+        LogMathBenchmarkCase("Mat4MulMat4", count, outOfLineSeconds, inlineSeconds, isSameResult);
+    }
+
+    {
+        const size_t numTriangles = count / 3;
+        const double outOfLineSeconds = GetBestMathBenchmarkSeconds(CullTrianglesOutOfLine, data);
+        std::memcpy(expectedValues, data.m_OutValues, numTriangles * sizeof(float));
+        const double inlineSeconds = GetBestMathBenchmarkSeconds(CullTrianglesInline, data);
+        const bool isSameResult = std::memcmp(expectedValues, data.m_OutValues, numTriangles * sizeof(float)) == 0;
+        LogMathBenchmarkCase("Face normal", numTriangles, outOfLineSeconds, inlineSeconds, isSameResult);
+    }
+
+    TempArenaEnd(&temp);
+}
+
+// NOTE(sbalse): No line address is ever all ones, so that marks an empty way.
+inline constexpr u64 CACHE_MODEL_EMPTY_LINE = ~u64(0);
+
+void CreateCacheModel(Arena* const arena, CacheModel* const outCache, const size_t sizeBytes, const int numWays)
+{
+    *outCache = {};
+    outCache->m_NumWays = numWays;
+    outCache->m_NumSets = scast<int>(sizeBytes / (CACHE_MODEL_LINE_SIZE * numWays));
+    outCache->m_Lines = PushArray(arena, u64, scast<size_t>(outCache->m_NumSets) * numWays);
+    ResetCacheModel(outCache);
+}
+
+void ResetCacheModel(CacheModel* const cache)
+{
+    const size_t numLines = scast<size_t>(cache->m_NumSets) * cache->m_NumWays;
+    for (size_t i = 0; i < numLines; i++)
+    {
+        cache->m_Lines[i] = CACHE_MODEL_EMPTY_LINE;
+    }
+    cache->m_NumAccesses = 0;
+    cache->m_NumMisses = 0;
+}
+
+bool AccessCacheModel(CacheModel* const cache, const void* const address)
+{
+    const u64 line = scast<u64>(rcast<std::uintptr_t>(address)) / CACHE_MODEL_LINE_SIZE;
+    u64* const ways = cache->m_Lines + ((line % scast<u64>(cache->m_NumSets)) * cache->m_NumWays);
+
+    cache->m_NumAccesses++;
+
+    // NOTE(sbalse): Move the line to the front, shifting the more recently used ones back by one. A line that
+    // wasn't found is inserted at the front and the least recently used one falls off the end.
+    int way = 0;
+    while (way < cache->m_NumWays - 1 && ways[way] != line)
+    {
+        way++;
+    }
+    const bool isHit = ways[way] == line;
+    for (; way > 0; way--)
+    {
+        ways[way] = ways[way - 1];
+    }
+    ways[0] = line;
+
+    if (!isHit)
+    {
+        cache->m_NumMisses++;
+    }
+    return isHit;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "arena.h"
+
+// NOTE(sbalse): Parse every .obj file in the directory several times and log the parsing speed in MB/s
+// and vertices/s for each file and for all of them together. All memory is temporary arena memory.
+void RunObjBenchmark(Arena* const arena, const char* const directory);
+
+// NOTE(sbalse): Time the inline vector and matrix math against out of line copies of the functions it replaced,
+// over count vectors and matrices each, and log the time per operation of both. All memory is temporary arena
+// memory.
+void RunMathBenchmark(Arena* const arena, const size_t count);
+
+// NOTE(sbalse): A set associative cache with LRU replacement. Estimates the cache misses of a stream of memory
+// accesses the same way on every machine, since the hardware counters can't be read without special drivers.
+struct CacheModel
+{
+    u64* m_Lines; // NOTE(sbalse): The cached line of each way of each set, most recently used way first.
+    int m_NumSets;
+    int m_NumWays;
+    u64 m_NumAccesses;
+    u64 m_NumMisses;
+};
+
+inline constexpr size_t CACHE_MODEL_LINE_SIZE = 64;
+
+void CreateCacheModel(Arena* const arena, CacheModel* const outCache, const size_t sizeBytes, const int numWays);
+// NOTE(sbalse): Empty the cache and reset the counts.
+void ResetCacheModel(CacheModel* const cache);
+// NOTE(sbalse): Returns true if the line of the address was in the cache. It is in the cache after this either way.
+bool AccessCacheModel(CacheModel* const cache, const void* const address);
@@ -1,13 +1,37 @@
 #include "camera.h"
 
 #include <cmath>
+#include <algorithm>
 
+#include "common.h"
 #include "matrix.h"
 
 inline constexpr double M_PI_2 = 1.57079632679489661923;   // pi/2
 
 constinit static Camera g_Camera = {};
 
+// NOTE(sbalse): A point on the scripted camera path.
+struct CameraPathKey
+{
+    Vec3 m_Position;
+    float m_Yaw;
+    float m_Pitch;
+};
+
+// NOTE(sbalse): The keys are evenly spaced in time. The path flies past the jets parked in front of the
+// runway, circles behind them and comes back to the start, so it covers far away, close up and
+// partially clipped views of the meshes.
+inline constexpr CameraPathKey CAMERA_PATH_KEYS[] =
+{
+    { .m_Position = { 0.0f, 0.0f, 0.0f }, .m_Yaw = 0.0f, .m_Pitch = 0.0f },
+    { .m_Position = { 0.0f, 0.3f, 2.5f }, .m_Yaw = 0.0f, .m_Pitch = 0.3f },
+    { .m_Position = { 3.0f, 0.0f, 6.0f }, .m_Yaw = -0.9f, .m_Pitch = 0.1f },
+    { .m_Position = { 2.0f, 1.0f, 13.0f }, .m_Yaw = -2.5f, .m_Pitch = 0.3f },
+    { .m_Position = { -2.0f, 0.5f, 13.0f }, .m_Yaw = -3.6f, .m_Pitch = 0.2f },
+    { .m_Position = { -3.0f, -0.5f, 6.0f }, .m_Yaw = -5.4f, .m_Pitch = -0.1f },
+    { .m_Position = { 0.0f, 0.0f, 0.0f }, .m_Yaw = -6.2831853f, .m_Pitch = 0.0f },
+};
+
 void InitCamera(const Vec3 position, const Vec3 direction)
 {
     g_Camera.m_Position = position;
@@ -96,3 +120,20 @@ Vec3 UpdateCameraAndGetLookAtTarget()
 
     return target;
 }
+
+void MoveCameraAlongPath(const float t)
+{
+    constexpr int NUM_KEYS = scast<int>(sizeof(CAMERA_PATH_KEYS) / sizeof(CAMERA_PATH_KEYS[0]));
+
+    // NOTE(sbalse): Find the two keys around t and linearly interpolate between them.
+    const float keyPosition = std::clamp(t, 0.0f, 1.0f) * (NUM_KEYS - 1);
+    const int keyIndex = std::min(scast<int>(keyPosition), NUM_KEYS - 2);
+    const float factor = keyPosition - scast<float>(keyIndex);
+
+    const CameraPathKey& a = CAMERA_PATH_KEYS[keyIndex];
+    const CameraPathKey& b = CAMERA_PATH_KEYS[keyIndex + 1];
+
+    g_Camera.m_Position = Vec3Add(a.m_Position, Vec3Mul(Vec3Sub(b.m_Position, a.m_Position), factor));
+    g_Camera.m_Yaw = a.m_Yaw + ((b.m_Yaw - a.m_Yaw) * factor);
+    g_Camera.m_Pitch = a.m_Pitch + ((b.m_Pitch - a.m_Pitch) * factor);
+}
@@ -28,3 +28,7 @@ void RotateCameraPitch(const float angle);
 
 // Gets the camera's look at target based on its position and direction.
 Vec3 UpdateCameraAndGetLookAtTarget();
+
+// NOTE(sbalse): Place the camera on a fixed, scripted path through the scene. t goes from 0 (start of the
+// path) to 1 (end of the path). Used instead of the mouse and keyboard to get the same frames every run.
+void MoveCameraAlongPath(const float t);
@@ -204,12 +204,176 @@ void TrianglesFromPolygon(
     }
 }
 
-void ClipPolygon(Polygon* const polygon)
+u8 GetFrustumOutcode(const Vec3 vertex)
 {
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Left);
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Right);
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Top);
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Bottom);
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Near);
-    ClipPolygonAgainstPlane(polygon, FrustumPlane_Far);
+    u8 outcode = 0;
+    for (u32 plane = 0; plane < NUM_PLANES; plane++)
+    {
+        // NOTE(sbalse): Same test as in ClipPolygonAgainstPlane(), where only a positive dot product is
+        // inside.
+        const float dp = Vec3Dot(Vec3Sub(vertex, g_FrustumPlanes[plane].m_Point), g_FrustumPlanes[plane].m_Normal);
+        if (!(dp > 0))
+        {
+            outcode |= scast<u8>(1 << plane);
+        }
+    }
+
+    return outcode;
+}
+
+void ClipPolygon(Polygon* const polygon, const u8 planesToClip)
+{
+    for (u32 plane = 0; plane < NUM_PLANES; plane++)
+    {
+        if (planesToClip & (1 << plane))
+        {
+            ClipPolygonAgainstPlane(polygon, scast<FrustumPlane>(plane));
+        }
+    }
+}
+
+// NOTE(sbalse): How far inside a frustum plane a clip space vertex is, positive when inside. It is linear in
+// the vertex, so along an edge it can be interpolated the same way as the camera space dot products.
+static float GetHomogeneousPlaneDistance(const Vec4 vertex, const FrustumPlane plane, const float sidePlaneScale)
+{
+    const float sideW = sidePlaneScale * vertex.m_W;
+    switch (plane)
+    {
+    case FrustumPlane_Left: return sideW + vertex.m_X;
+    case FrustumPlane_Right: return sideW - vertex.m_X;
+    case FrustumPlane_Top: return sideW - vertex.m_Y;
+    case FrustumPlane_Bottom: return sideW + vertex.m_Y;
+    case FrustumPlane_Near: return vertex.m_Z;
+    case FrustumPlane_Far: return vertex.m_W - vertex.m_Z;
+    default: return 0.0f;
+    }
+}
+
+// NOTE(sbalse): Same as ClipPolygonAgainstPlane() with the clip space plane distances.
+static void ClipHomogeneousPolygonAgainstPlane(
+    HomogeneousPolygon* const polygon,
+    const FrustumPlane plane,
+    const float sidePlaneScale)
+{
+    if (polygon->m_NumVertices <= 0)
+    {
+        return;
+    }
+
+    Vec4 insideVertices[MAX_NUM_POLYGON_VERTICES] = {};
+    Tex2 insideTexCoords[MAX_NUM_POLYGON_VERTICES] = {};
+    int numInsideVertices = 0;
+
+    u32 previousIndex = polygon->m_NumVertices - 1;
+    float previousDistance = GetHomogeneousPlaneDistance(polygon->m_Vertices[previousIndex], plane, sidePlaneScale);
+
+    for (u32 currentIndex = 0; currentIndex < polygon->m_NumVertices; currentIndex++)
+    {
+        const Vec4 previousVertex = polygon->m_Vertices[previousIndex];
+        const Vec4 currentVertex = polygon->m_Vertices[currentIndex];
+        const float currentDistance = GetHomogeneousPlaneDistance(currentVertex, plane, sidePlaneScale);
+
+        // NOTE(sbalse): The edge crosses the plane.
+        if (currentDistance * previousDistance < 0)
+        {
+            const float t = previousDistance / (previousDistance - currentDistance);
+
+            insideVertices[numInsideVertices] =
+            {
+                .m_X = std::lerp(previousVertex.m_X, currentVertex.m_X, t),
+                .m_Y = std::lerp(previousVertex.m_Y, currentVertex.m_Y, t),
+                .m_Z = std::lerp(previousVertex.m_Z, currentVertex.m_Z, t),
+                .m_W = std::lerp(previousVertex.m_W, currentVertex.m_W, t),
+            };
+            insideTexCoords[numInsideVertices] =
+            {
+                .m_U = std::lerp(polygon->m_TexCoords[previousIndex].m_U, polygon->m_TexCoords[currentIndex].m_U, t),
+                .m_V = std::lerp(polygon->m_TexCoords[previousIndex].m_V, polygon->m_TexCoords[currentIndex].m_V, t),
+            };
+            numInsideVertices++;
+        }
+
+        if (currentDistance > 0)
+        {
+            insideVertices[numInsideVertices] = currentVertex;
+            insideTexCoords[numInsideVertices] = polygon->m_TexCoords[currentIndex];
+            numInsideVertices++;
+        }
+
+        previousDistance = currentDistance;
+        previousIndex = currentIndex;
+    }
+
+    for (int i = 0; i < numInsideVertices; i++)
+    {
+        polygon->m_Vertices[i] = insideVertices[i];
+        polygon->m_TexCoords[i] = insideTexCoords[i];
+    }
+    polygon->m_NumVertices = numInsideVertices;
+}
+
+u8 GetHomogeneousOutcode(const Vec4 vertex, const float sidePlaneScale/* = 1.0f*/)
+{
+    u8 outcode = 0;
+    for (u32 plane = 0; plane < NUM_PLANES; plane++)
+    {
+        if (!(GetHomogeneousPlaneDistance(vertex, scast<FrustumPlane>(plane), sidePlaneScale) > 0))
+        {
+            outcode |= scast<u8>(1 << plane);
+        }
+    }
+
+    return outcode;
+}
+
+HomogeneousPolygon CreateHomogeneousPolygonFromTriangle(
+    const Vec4 v0,
+    const Vec4 v1,
+    const Vec4 v2,
+    const Tex2 t0,
+    const Tex2 t1,
+    const Tex2 t2
+)
+{
+    const HomogeneousPolygon result =
+    {
+        .m_Vertices = { v0, v1, v2 },
+        .m_NumVertices = 3,
+        .m_TexCoords = { t0, t1, t2 },
+    };
+
+    return result;
+}
+
+void TrianglesFromHomogeneousPolygon(
+    const HomogeneousPolygon* const polygon,
+    Triangle triangles[],
+    int* numTriangles)
+{
+    *numTriangles = polygon->m_NumVertices - 2;
+    for (int i = 0; i < *numTriangles; i++)
+    {
+        // NOTE(sbalse): A fan around the first vertex, same as TrianglesFromPolygon().
+        triangles[i].m_Points[0] = polygon->m_Vertices[0];
+        triangles[i].m_Points[1] = polygon->m_Vertices[i + 1];
+        triangles[i].m_Points[2] = polygon->m_Vertices[i + 2];
+
+        triangles[i].m_TexCoords[0] = polygon->m_TexCoords[0];
+        triangles[i].m_TexCoords[1] = polygon->m_TexCoords[i + 1];
+        triangles[i].m_TexCoords[2] = polygon->m_TexCoords[i + 2];
+    }
+}
+
+void ClipHomogeneousPolygon(
+    HomogeneousPolygon* const polygon,
+    const u8 planesToClip,
+    const float sidePlaneScale/* = 1.0f*/)
+{
+    for (u32 plane = 0; plane < NUM_PLANES; plane++)
+    {
+        if (planesToClip & (1 << plane))
+        {
+            ClipHomogeneousPolygonAgainstPlane(polygon, scast<FrustumPlane>(plane), sidePlaneScale);
+        }
+    }
 }
@@ -15,6 +15,12 @@ enum FrustumPlane
     FrustumPlane_Count,
 };
 
+// NOTE(sbalse): The outcode bits of the left, right, top and bottom planes.
+inline constexpr u8 FRUSTUM_SIDE_PLANES_MASK = (1 << FrustumPlane_Left)
+    | (1 << FrustumPlane_Right)
+    | (1 << FrustumPlane_Top)
+    | (1 << FrustumPlane_Bottom);
+
 struct Plane
 {
     Vec3 m_Point; // NOTE(sbalse): A point in the plane.
@@ -22,6 +28,12 @@ struct Plane
 };
 
 inline constexpr u32 MAX_NUM_POLYGON_VERTICES = 10;
+// NOTE(sbalse): Clip space side planes of the guard band, as a multiple of the side planes of the view frustum.
+// Triangles inside it are rasterized without side plane clipping, the rasterizer only walks the pixels inside
+// the screen anyway. A triangle inside the guard band is at most 3 x 3 screens big, which keeps twice its area
+// in sub-pixel units (3 * 1024 * 3 * 720 * 16 * 16) below MAX_VECTOR_KERNEL_TRIANGLE_AREA. Bigger triangles
+// would be drawn with the much slower scalar pixel kernels.
+inline constexpr float GUARD_BAND_SCALE = 3.0f;
 inline constexpr u32 MAX_NUM_POLYGON_TRIANGLES = 10; // NOTE(sbalse): Max triangles that a clipped polygon contains.
 
 struct Polygon
@@ -31,6 +43,15 @@ struct Polygon
     Tex2 m_TexCoords[MAX_NUM_POLYGON_VERTICES]; // NOTE(sbalse): The polygon texture UV coordinates.
 };
 
+// NOTE(sbalse): A polygon in homogeneous clip space, that is after the projection matrix but before the
+// perspective divide.
+struct HomogeneousPolygon
+{
+    Vec4 m_Vertices[MAX_NUM_POLYGON_VERTICES];
+    u32 m_NumVertices;
+    Tex2 m_TexCoords[MAX_NUM_POLYGON_VERTICES];
+};
+
 // NOTE(sbalse): Initialize the frustum planes that are used for clipping.
 // fov = fov of view that we're using.
 // znear = value of the Z-Near plane.
@@ -49,4 +70,33 @@ void TrianglesFromPolygon(
     Triangle triangles[],
     int* numTriangles
 );
-void ClipPolygon(Polygon* const polygon);
+// NOTE(sbalse): Bit (1 << plane) is set for every FrustumPlane that the vertex is not inside of. A vertex
+// exactly on a plane counts as outside, the same as in the clipping.
+u8 GetFrustumOutcode(const Vec3 vertex);
+// NOTE(sbalse): Clip the polygon against the planes whose bits are set in planesToClip, in FrustumPlane
+// order. The other planes are skipped, so only pass planes that the polygon can cross.
+void ClipPolygon(Polygon* const polygon, const u8 planesToClip);
+
+// NOTE(sbalse): The homogeneous clip space versions of the functions above. The frustum is -w < x < w,
+// -w < y < w and 0 < z < w. z starts at 0 because the projection matrix maps the near plane to 0, so no
+// frustum planes have to be set up for these. sidePlaneScale moves the left, right, top and bottom planes
+// out to -s * w < x, y < s * w, e.g. GUARD_BAND_SCALE for the guard band.
+u8 GetHomogeneousOutcode(const Vec4 vertex, const float sidePlaneScale = 1.0f);
+HomogeneousPolygon CreateHomogeneousPolygonFromTriangle(
+    const Vec4 v0,
+    const Vec4 v1,
+    const Vec4 v2,
+    const Tex2 t0,
+    const Tex2 t1,
+    const Tex2 t2
+);
+void TrianglesFromHomogeneousPolygon(
+    const HomogeneousPolygon* const polygon,
+    Triangle triangles[],
+    int* numTriangles
+);
+void ClipHomogeneousPolygon(
+    HomogeneousPolygon* const polygon,
+    const u8 planesToClip,
+    const float sidePlaneScale = 1.0f
+);
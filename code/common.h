@@ -2,6 +2,7 @@
 #include <cstdint>
 
 using u8 = std::uint8_t;
+using u16 = std::uint16_t;
 using u32 = std::uint32_t;
 using i32 = std::int32_t;
 using i64 = std::int64_t;
@@ -12,3 +13,22 @@ using u64 = std::uint64_t;
 
 #define KILOBYTES(x) (scast<size_t>(x) * 1024)
 #define MEGABYTES(x) (KILOBYTES(x) * 1024)
+
+// NOTE(sbalse): Keep a function out of line, e.g. for a benchmark that measures the cost of the call.
+#if defined(_MSC_VER)
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+// NOTE(sbalse): Let a function use instructions the rest of the program can't assume, for the kernels that are only
+// called after checking the CPU supports them. MSVC allows the intrinsics in any function.
+#if defined(_MSC_VER)
+#define TARGET_AVX
+#define TARGET_AVX2
+#define TARGET_XSAVE
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_XSAVE __attribute__((target("xsave")))
+#endif
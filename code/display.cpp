@@ -1,10 +1,15 @@
 #include "display.h"
 
+#include <algorithm>
+#include <cassert>
 #include <ctime>
 #include <cmath>
+#include <immintrin.h>
 
 #include "log.h"
 #include "profile.h"
+#include "stats.h"
+#include "threadpool.h"
 
 static constinit SDL_Window* g_Window = nullptr;
 static constinit SDL_Renderer* g_Renderer = nullptr;
@@ -14,24 +19,47 @@ static constinit CullMethod g_CullMethod = {};
 static constinit RenderMethod g_RenderMethod = {};
 static constinit ShadingMethod g_ShadingMethod = {};
 static constinit RenderBufferMethod g_RenderBufferMethod = {};
+static constinit RasterizerMethod g_RasterizerMethod = {};
+static constinit OcclusionCullMethod g_OcclusionCullMethod = {};
+static constinit DepthTestMethod g_DepthTestMethod = {};
+static constinit TriangleSortMethod g_TriangleSortMethod = {};
+static constinit DepthPrepassMethod g_DepthPrepassMethod = {};
+static constinit DepthClearMethod g_DepthClearMethod = {};
+static constinit PixelKernelMethod g_PixelKernelMethod = {};
+static constinit MipLevelMethod g_MipLevelMethod = {};
+static constinit TextureFilterMethod g_TextureFilterMethod = {};
+static constinit ClippingMethod g_ClippingMethod = {};
 
 static constinit int g_WindowWidth = 1024;
 static constinit int g_WindowHeight = 720;
 
-static void UpdateColorBufferAt(const int x, const int y, const u32 color)
+static constinit thread_local ScreenRect g_DrawClipRect = {};
+
+// NOTE(sbalse): Whether the pixels x to x + count - 1 of row y are all inside the window. Only used by the
+// debug asserts of the unchecked span functions.
+static bool IsSpanInsideWindow(const int x, const int y, const int count)
 {
-    if (x < 0 || x >= g_WindowWidth || y < 0 || y >= g_WindowHeight)
-    {
-        return;
-    }
+    return x >= 0 && count >= 0 && x + count <= g_WindowWidth && y >= 0 && y < g_WindowHeight;
+}
+
+static bool IsInsideDrawClipRect(const int x, const int y)
+{
+    return x >= g_DrawClipRect.m_MinX
+        && x < g_DrawClipRect.m_MaxX
+        && y >= g_DrawClipRect.m_MinY
+        && y < g_DrawClipRect.m_MaxY;
+}
 
-    const int position = (g_WindowWidth * y) + x;
-    if (position > g_ColorBuffer.m_Size)
+static void UpdateColorBufferAt(const int x, const int y, const u32 color)
+{
+    // NOTE(sbalse): The clip rect is always inside the window so this also does the window bounds
+    // check.
+    if (!IsInsideDrawClipRect(x, y))
     {
         return;
     }
 
-    g_ColorBuffer.m_Buffer[position] = color;
+    *GetColorBufferSpan(x, y, 1) = color;
 }
 
 int GetWindowWidth()
@@ -44,6 +72,35 @@ int GetWindowHeight()
     return g_WindowHeight;
 }
 
+// NOTE(sbalse): Allocate the color and Z buffers for the current window size.
+static void AllocateFrameBuffers(Arena* const persistentArena)
+{
+    // NOTE(sbalse): Allocate the color buffer.
+    const size_t colorBufferSize = g_WindowWidth * g_WindowHeight;
+    g_ColorBuffer.m_Buffer = PushArray(persistentArena, u32, colorBufferSize);
+    g_ColorBuffer.m_Size = colorBufferSize;
+
+    // NOTE(sbalse): Allocate the z buffer.
+    const size_t zBufferUNormSize = g_WindowWidth * g_WindowHeight;
+    g_ZBuffer.m_BufferUNorm = PushArray(persistentArena, float, zBufferUNormSize);
+    g_ZBuffer.m_BufferUNormSize = zBufferUNormSize;
+
+    // NOTE(sbalse): Allocate the hierarchical Z. Tiles at the right and bottom edges can be partial.
+    g_ZBuffer.m_NumTilesX = (g_WindowWidth + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+    g_ZBuffer.m_NumTilesY = (g_WindowHeight + HIZ_TILE_SIZE - 1) / HIZ_TILE_SIZE;
+    g_ZBuffer.m_TileMaxDepths = PushArray(
+        persistentArena,
+        float,
+        scast<size_t>(g_ZBuffer.m_NumTilesX) * g_ZBuffer.m_NumTilesY
+    );
+    g_ZBuffer.m_TileEpochs = PushArray(
+        persistentArena,
+        u32,
+        scast<size_t>(g_ZBuffer.m_NumTilesX) * g_ZBuffer.m_NumTilesY
+    );
+    g_ZBuffer.m_Epoch = 0;
+}
+
 bool InitializeWindow(Arena* const persistentArena, const char* const windowTitle)
 {
     LOG_INFO("Initializing window...");
@@ -83,10 +140,7 @@ bool InitializeWindow(Arena* const persistentArena, const char* const windowTitl
         return false;
     }
 
-    // NOTE(sbalse): Allocate the color buffer.
-    const size_t colorBufferSize = g_WindowWidth * g_WindowHeight;
-    g_ColorBuffer.m_Buffer = PushArray(persistentArena, u32, colorBufferSize);
-    g_ColorBuffer.m_Size = colorBufferSize;
+    AllocateFrameBuffers(persistentArena);
 
     g_ColorBuffer.m_Texture = SDL_CreateTexture(
         g_Renderer,
@@ -95,15 +149,6 @@ bool InitializeWindow(Arena* const persistentArena, const char* const windowTitl
         g_WindowWidth,
         g_WindowHeight);
 
-    // NOTE(sbalse): Allocate the z buffer.
-    const size_t zBufferUNormSize = g_WindowWidth * g_WindowHeight;
-    g_ZBuffer.m_BufferUNorm = PushArray(persistentArena, float, zBufferUNormSize);
-    g_ZBuffer.m_BufferUNormSize = zBufferUNormSize;
-
-    const size_t zBufferUIntSize = g_WindowWidth * g_WindowHeight;
-    g_ZBuffer.m_BufferUInt = PushArray(persistentArena, u32, zBufferUIntSize);
-    g_ZBuffer.m_BufferUIntSize = zBufferUIntSize;
-
     g_ZBuffer.m_Texture = SDL_CreateTexture(
         g_Renderer,
         SDL_PIXELFORMAT_RGB888,
@@ -112,15 +157,49 @@ bool InitializeWindow(Arena* const persistentArena, const char* const windowTitl
         g_WindowHeight
     );
 
+    ResetDrawClipRect();
+
     LOG_INFO("Successfully initialized window.");
 
     return true;
 }
 
+bool InitializeHeadless(Arena* const persistentArena)
+{
+    LOG_INFO("Initializing headless rendering at %dx%d...", g_WindowWidth, g_WindowHeight);
+
+    AllocateFrameBuffers(persistentArena);
+    ResetDrawClipRect();
+
+    return g_ColorBuffer.m_Buffer && g_ZBuffer.m_BufferUNorm;
+}
+
+bool IsHeadless()
+{
+    return g_Renderer == nullptr;
+}
+
+u64 GetColorBufferHash()
+{
+    // NOTE(sbalse): FNV-1a over the pixels.
+    u64 hash = 14695981039346656037ull;
+    for (size_t i = 0; i < g_ColorBuffer.m_Size; i++)
+    {
+        hash = (hash ^ g_ColorBuffer.m_Buffer[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
 void RenderColorBuffer()
 {
     PROFILE_EVENT();
 
+    // NOTE(sbalse): Headless rendering just leaves the frame in the color buffer.
+    if (IsHeadless())
+    {
+        return;
+    }
+
     SDL_UpdateTexture(
         g_ColorBuffer.m_Texture,
         nullptr,
@@ -136,16 +215,137 @@ void RenderColorBuffer()
     SDL_RenderPresent(g_Renderer);
 }
 
+// NOTE(sbalse): Rows of the Z buffer visualization built by each job. Whole HiZ tile rows, so that the jobs
+// clearing the stale tiles of different bands never touch the same tile.
+inline constexpr int Z_BUFFER_VISUALIZATION_BAND_ROWS = 16;
+static_assert(Z_BUFFER_VISUALIZATION_BAND_ROWS % HIZ_TILE_SIZE == 0);
+
+struct ZBufferVisualization
+{
+    u8* m_Pixels;
+    int m_Pitch;
+};
+
+// NOTE(sbalse): User data of the jobs of one band of the Z buffer visualization.
+struct ZBufferVisualizationBand
+{
+    const ZBufferVisualization* m_Visualization;
+    int m_MinY;
+    int m_MaxY;
+};
+
+// NOTE(sbalse): Thread pool job. Clears the stale tiles of a band of rows before it gets visualized.
+static void ClearStaleZBufferBand(void* userData, const int threadIndex)
+{
+    PROFILE_EVENT();
+
+    const ZBufferVisualizationBand* const band = scast<const ZBufferVisualizationBand*>(userData);
+    ClearStaleZBufferTiles(ScreenRect{ 0, band->m_MinY, g_WindowWidth, band->m_MaxY });
+}
+
+// NOTE(sbalse): Thread pool job. Turns a band of rows of the Z buffer into grayscale. Only the low 8 bits of
+// depth * 255 are kept. We represent the far plane with WHITE color, so objects that are closer to the camera
+// appear darker and objects far away or no geometry appear as white.
+static void BuildZBufferVisualizationBand(void* userData, const int threadIndex)
+{
+    PROFILE_EVENT();
+
+    const ZBufferVisualizationBand* const band = scast<const ZBufferVisualizationBand*>(userData);
+    const ZBufferVisualization* const visualization = band->m_Visualization;
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    const __m128i white = _mm_set1_epi32(scast<int>(WHITE));
+
+    for (int y = band->m_MinY; y < band->m_MaxY; y++)
+    {
+        const float* const depths = GetZBufferSpan(0, y, g_WindowWidth);
+        u32* const pixels = rcast<u32*>(visualization->m_Pixels + (scast<size_t>(visualization->m_Pitch) * y));
+
+        int x = 0;
+        for (; x + 4 <= g_WindowWidth; x += 4)
+        {
+            const __m128 depth = _mm_loadu_ps(depths + x);
+            __m128i grayscale = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(depth, scale)), lowByte);
+            grayscale = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(grayscale, 16), _mm_slli_epi32(grayscale, 8)), grayscale);
+
+            const __m128i isFar = _mm_castps_si128(_mm_cmpge_ps(depth, one));
+            const __m128i result = _mm_or_si128(_mm_and_si128(isFar, white), _mm_andnot_si128(isFar, grayscale));
+            _mm_storeu_si128(rcast<__m128i*>(pixels + x), result);
+        }
+        for (; x < g_WindowWidth; x++)
+        {
+            const u32 grayscale = scast<u32>(scast<int>(depths[x] * 255.0f)) & 0xFF;
+            pixels[x] = (depths[x] >= 1.0f) ? WHITE : ((grayscale << 16) | (grayscale << 8) | grayscale);
+        }
+    }
+}
+
 void RenderZBuffer()
 {
     PROFILE_EVENT();
 
-    SDL_UpdateTexture(
-        g_ZBuffer.m_Texture,
-        nullptr,
-        g_ZBuffer.m_BufferUInt,
-        scast<int>(g_WindowWidth * sizeof(u32))
-    );
+    if (IsHeadless())
+    {
+        return;
+    }
+
+    // NOTE(sbalse): The frame arena is only reset once per update and there can be many renders per update, so
+    // the bands are only kept until all their jobs are done.
+    TempArena temp = TempArenaBegin(GetThreadFrameArena());
+
+    ZBufferVisualization visualization = {};
+    const int numBands = (g_WindowHeight + Z_BUFFER_VISUALIZATION_BAND_ROWS - 1) / Z_BUFFER_VISUALIZATION_BAND_ROWS;
+    ZBufferVisualizationBand* const bands = PushArray(temp.m_OriginalArena, ZBufferVisualizationBand, numBands);
+    for (int i = 0; i < numBands; i++)
+    {
+        bands[i].m_Visualization = &visualization;
+        bands[i].m_MinY = i * Z_BUFFER_VISUALIZATION_BAND_ROWS;
+        bands[i].m_MaxY = std::min(bands[i].m_MinY + Z_BUFFER_VISUALIZATION_BAND_ROWS, g_WindowHeight);
+    }
+
+    // NOTE(sbalse): Tiles that weren't drawn to this frame still hold old depths when epoch tagged. They get
+    // cleared on the pool threads while this thread locks the texture.
+    JobCounter clearCounter = {};
+    if (g_DepthClearMethod == DepthClearMethod::EpochTagged)
+    {
+        for (int i = 0; i < numBands; i++)
+        {
+            ThreadPoolRunJob(ClearStaleZBufferBand, &bands[i], &clearCounter);
+        }
+    }
+
+    void* pixels = nullptr;
+    int pitch = 0;
+    const bool isLocked = SDL_LockTexture(g_ZBuffer.m_Texture, nullptr, &pixels, &pitch) == 0;
+    if (isLocked)
+    {
+        visualization = { scast<u8*>(pixels), pitch };
+
+        // NOTE(sbalse): The bands are only visualized once the clear jobs are done. They start right away when the
+        // clears finished while the texture was being locked, otherwise they wait on the counter.
+        JobCounter visualizationCounter = {};
+        for (int i = 0; i < numBands; i++)
+        {
+            ThreadPoolRunJob(BuildZBufferVisualizationBand, &bands[i], &visualizationCounter, &clearCounter);
+        }
+        ThreadPoolWaitForCounter(&visualizationCounter);
+    }
+
+    // NOTE(sbalse): The clear jobs use the bands and the counter, so they have to be done even when the
+    // texture couldn't be locked.
+    ThreadPoolWaitForCounter(&clearCounter);
+    TempArenaEnd(&temp);
+
+    if (!isLocked)
+    {
+        LOG_ERROR("Failed to lock the Z buffer texture: %s", SDL_GetError());
+        return;
+    }
+
+    SDL_UnlockTexture(g_ZBuffer.m_Texture);
+
     SDL_RenderCopy(
         g_Renderer,
         g_ZBuffer.m_Texture,
@@ -195,94 +395,345 @@ void SetRenderBufferMethod(const RenderBufferMethod newRenderBufferMethod)
     g_RenderBufferMethod = newRenderBufferMethod;
 }
 
-// NOTE(sbalse): Clear our custom color buffer to the given color.
-void ClearColorBuffer(const u32 color)
+RasterizerMethod GetRasterizerMethod()
 {
-    PROFILE_EVENT();
+    return g_RasterizerMethod;
+}
+
+void SetRasterizerMethod(const RasterizerMethod newRasterizerMethod)
+{
+    g_RasterizerMethod = newRasterizerMethod;
+}
+
+OcclusionCullMethod GetOcclusionCullMethod()
+{
+    return g_OcclusionCullMethod;
+}
+
+void SetOcclusionCullMethod(const OcclusionCullMethod newOcclusionCullMethod)
+{
+    g_OcclusionCullMethod = newOcclusionCullMethod;
+}
+
+DepthTestMethod GetDepthTestMethod()
+{
+    return g_DepthTestMethod;
+}
+
+void SetDepthTestMethod(const DepthTestMethod newDepthTestMethod)
+{
+    g_DepthTestMethod = newDepthTestMethod;
+}
+
+TriangleSortMethod GetTriangleSortMethod()
+{
+    return g_TriangleSortMethod;
+}
+
+void SetTriangleSortMethod(const TriangleSortMethod newTriangleSortMethod)
+{
+    g_TriangleSortMethod = newTriangleSortMethod;
+}
+
+DepthClearMethod GetDepthClearMethod()
+{
+    return g_DepthClearMethod;
+}
+
+void SetDepthClearMethod(const DepthClearMethod newDepthClearMethod)
+{
+    g_DepthClearMethod = newDepthClearMethod;
+}
+
+DepthPrepassMethod GetDepthPrepassMethod()
+{
+    return g_DepthPrepassMethod;
+}
 
-    const size_t size = g_ColorBuffer.m_Size;
-    for (int i = 0; i < size; i++)
+void SetDepthPrepassMethod(const DepthPrepassMethod newDepthPrepassMethod)
+{
+    g_DepthPrepassMethod = newDepthPrepassMethod;
+}
+
+PixelKernelMethod GetPixelKernelMethod()
+{
+    return g_PixelKernelMethod;
+}
+
+void SetPixelKernelMethod(const PixelKernelMethod newPixelKernelMethod)
+{
+    g_PixelKernelMethod = newPixelKernelMethod;
+}
+
+MipLevelMethod GetMipLevelMethod()
+{
+    return g_MipLevelMethod;
+}
+
+void SetMipLevelMethod(const MipLevelMethod newMipLevelMethod)
+{
+    g_MipLevelMethod = newMipLevelMethod;
+}
+
+TextureFilterMethod GetTextureFilterMethod()
+{
+    return g_TextureFilterMethod;
+}
+
+void SetTextureFilterMethod(const TextureFilterMethod newTextureFilterMethod)
+{
+    g_TextureFilterMethod = newTextureFilterMethod;
+}
+
+ClippingMethod GetClippingMethod()
+{
+    return g_ClippingMethod;
+}
+
+void SetClippingMethod(const ClippingMethod newClippingMethod)
+{
+    g_ClippingMethod = newClippingMethod;
+}
+
+ScreenRect GetDrawClipRect()
+{
+    return g_DrawClipRect;
+}
+
+void SetDrawClipRect(const ScreenRect rect)
+{
+    g_DrawClipRect =
     {
-        g_ColorBuffer.m_Buffer[i] = color;
-    }
+        .m_MinX = std::max(rect.m_MinX, 0),
+        .m_MinY = std::max(rect.m_MinY, 0),
+        .m_MaxX = std::min(rect.m_MaxX, g_WindowWidth),
+        .m_MaxY = std::min(rect.m_MaxY, g_WindowHeight),
+    };
 }
 
-void ClearZBuffer()
+void ResetDrawClipRect()
+{
+    g_DrawClipRect =
+    {
+        .m_MinX = 0,
+        .m_MinY = 0,
+        .m_MaxX = g_WindowWidth,
+        .m_MaxY = g_WindowHeight,
+    };
+}
+
+// NOTE(sbalse): Clear our custom color buffer to the given color.
+// NOTE(sbalse): The buffers come from the arena so they are 16 byte aligned and every group of 4 pixels
+// can be cleared with one aligned store.
+inline constexpr size_t CLEAR_GROUP_PIXELS = 4;
+// NOTE(sbalse): Pixels cleared by each parallel for index. A multiple of CLEAR_GROUP_PIXELS so that every
+// band starts on an aligned group.
+inline constexpr size_t CLEAR_BAND_PIXELS = 64 * 1024;
+
+struct FrameBufferClear
+{
+    u32 m_Color;
+    bool m_IsDepthCleared;
+};
+
+// NOTE(sbalse): Thread pool callback. Clears a band of pixels of the color buffer and, when requested, the
+// Z buffer.
+static void ClearFrameBufferBand(void* userData, const int bandIndex, const int threadIndex)
 {
     PROFILE_EVENT();
 
-    const size_t size = g_ZBuffer.m_BufferUNormSize;
-    for (int i = 0; i < size; i++)
+    const FrameBufferClear* const clear = scast<const FrameBufferClear*>(userData);
+
+    // NOTE(sbalse): Clear z-buffer to "1". "0" is the near plane and "1" is the far plane. So z-buffer
+    // being 1 after clearing means that it is infinitely far away right by default.
+    const __m128i colors = _mm_set1_epi32(scast<int>(clear->m_Color));
+    const __m128 depths = _mm_set1_ps(1.0f);
+
+    // NOTE(sbalse): All the buffers have the same number of pixels.
+    const size_t begin = scast<size_t>(bandIndex) * CLEAR_BAND_PIXELS;
+    const size_t end = std::min(begin + CLEAR_BAND_PIXELS, g_ColorBuffer.m_Size);
+    const size_t groupsEnd = end - ((end - begin) % CLEAR_GROUP_PIXELS);
+
+    size_t i = begin;
+    for (; i < groupsEnd; i += CLEAR_GROUP_PIXELS)
     {
-        // NOTE(sbalse): Clear z-buffer to "1". "0" is the near plane and "1" is the far plane.
-        // So z-buffer being 1 after clearing means that it is infinitely far away right by
-        // default.
-        g_ZBuffer.m_BufferUNorm[i] = 1.0;
-
-        // NOTE(sbalse): We represent the far plane with WHITE color. This means, objects that
-        // are closer to the camera appear darker and objects far away or no geometry appears as
-        // white in the z-buffer visualization.
-        g_ZBuffer.m_BufferUInt[i] = WHITE;
+        _mm_store_si128(rcast<__m128i*>(g_ColorBuffer.m_Buffer + i), colors);
+        if (clear->m_IsDepthCleared)
+        {
+            _mm_store_ps(g_ZBuffer.m_BufferUNorm + i, depths);
+        }
+    }
+    for (; i < end; i++)
+    {
+        g_ColorBuffer.m_Buffer[i] = clear->m_Color;
+        if (clear->m_IsDepthCleared)
+        {
+            g_ZBuffer.m_BufferUNorm[i] = 1.0f;
+        }
     }
 }
 
-float GetZBufferAt(const int x, const int y)
+void ClearFrameBuffers(const u32 color)
 {
-    if (x < 0 || x >= g_WindowWidth || y < 0 || y > g_WindowHeight)
+    PROFILE_EVENT();
+
+    const bool isDepthCleared = g_DepthClearMethod == DepthClearMethod::Full;
+
+    FrameBufferClear clear = { color, isDepthCleared };
+    const size_t numBands = (g_ColorBuffer.m_Size + CLEAR_BAND_PIXELS - 1) / CLEAR_BAND_PIXELS;
+    ThreadPoolParallelFor(scast<int>(numBands), ClearFrameBufferBand, &clear);
+
+    const size_t numTiles = scast<size_t>(g_ZBuffer.m_NumTilesX) * g_ZBuffer.m_NumTilesY;
+    if (isDepthCleared)
     {
-        return 1.0f;
+        std::fill_n(g_ZBuffer.m_TileMaxDepths, numTiles, 1.0f);
+        return;
     }
 
-    const size_t position = scast<size_t>(g_WindowWidth * y) + x;
-    if (position >= g_ZBuffer.m_BufferUNormSize)
+    // NOTE(sbalse): Start a new epoch, which makes every tile stale. When the epoch wraps around the tags
+    // are reset so that no old tag can match the new epoch.
+    g_ZBuffer.m_Epoch++;
+    if (g_ZBuffer.m_Epoch == 0)
     {
-        return 1.0f;
+        std::fill_n(g_ZBuffer.m_TileEpochs, numTiles, 0);
+        g_ZBuffer.m_Epoch = 1;
     }
+}
 
-    return g_ZBuffer.m_BufferUNorm[position];
+static bool IsZBufferTileStale(const size_t tileIndex)
+{
+    return g_DepthClearMethod == DepthClearMethod::EpochTagged
+        && g_ZBuffer.m_TileEpochs[tileIndex] != g_ZBuffer.m_Epoch;
 }
 
-void UpdateNormalizedZBufferAt(const int x, const int y, const float value)
+void ClearStaleZBufferTiles(const ScreenRect rect)
 {
-    if (x < 0 || x >= g_WindowWidth || y < 0 || y > g_WindowHeight)
+    if (g_DepthClearMethod != DepthClearMethod::EpochTagged || rect.m_MinX >= rect.m_MaxX || rect.m_MinY >= rect.m_MaxY)
     {
         return;
     }
 
-    const size_t position = scast<size_t>(g_WindowWidth * y) + x;
-    if (position >= g_ZBuffer.m_BufferUIntSize)
+    const int minTileX = rect.m_MinX / HIZ_TILE_SIZE;
+    const int minTileY = rect.m_MinY / HIZ_TILE_SIZE;
+    const int maxTileX = (rect.m_MaxX - 1) / HIZ_TILE_SIZE;
+    const int maxTileY = (rect.m_MaxY - 1) / HIZ_TILE_SIZE;
+
+    u64 numTilesCleared = 0;
+    for (int tileY = minTileY; tileY <= maxTileY; tileY++)
     {
-        return;
+        for (int tileX = minTileX; tileX <= maxTileX; tileX++)
+        {
+            const size_t tileIndex = (scast<size_t>(tileY) * g_ZBuffer.m_NumTilesX) + tileX;
+            if (!IsZBufferTileStale(tileIndex))
+            {
+                continue;
+            }
+
+            const int minX = tileX * HIZ_TILE_SIZE;
+            const int minY = tileY * HIZ_TILE_SIZE;
+            const int count = std::min(minX + HIZ_TILE_SIZE, g_WindowWidth) - minX;
+            const int maxY = std::min(minY + HIZ_TILE_SIZE, g_WindowHeight);
+            for (int y = minY; y < maxY; y++)
+            {
+                std::fill_n(GetZBufferSpan(minX, y, count), count, 1.0f);
+            }
+
+            g_ZBuffer.m_TileMaxDepths[tileIndex] = 1.0f;
+            g_ZBuffer.m_TileEpochs[tileIndex] = g_ZBuffer.m_Epoch;
+            numTilesCleared++;
+        }
+    }
+
+    if (numTilesCleared > 0)
+    {
+        AddFrameCounter(FrameCounter_ZTilesLazilyCleared, numTilesCleared);
     }
+}
+
+u32* GetColorBufferSpan(const int x, const int y, const int count)
+{
+    assert(IsSpanInsideWindow(x, y, count) && "ERROR: Color buffer span is outside the window.");
+    return g_ColorBuffer.m_Buffer + (scast<size_t>(g_WindowWidth) * y) + x;
+}
+
+float* GetZBufferSpan(const int x, const int y, const int count)
+{
+    assert(IsSpanInsideWindow(x, y, count) && "ERROR: Z buffer span is outside the window.");
+    return g_ZBuffer.m_BufferUNorm + (scast<size_t>(g_WindowWidth) * y) + x;
+}
 
-    g_ZBuffer.m_BufferUNorm[position] = value;
+float GetHiZTileMaxDepth(const int tileX, const int tileY)
+{
+    return g_ZBuffer.m_TileMaxDepths[(tileY * g_ZBuffer.m_NumTilesX) + tileX];
 }
 
-void UpdateDisplayableZBufferAt(const int x, const int y, const u32 value)
+void UpdateHiZTile(const int tileX, const int tileY)
 {
-    if (x < 0 || x >= g_WindowWidth || y < 0 || y > g_WindowHeight)
+    const int minX = tileX * HIZ_TILE_SIZE;
+    const int minY = tileY * HIZ_TILE_SIZE;
+    const int maxX = std::min(minX + HIZ_TILE_SIZE, g_WindowWidth);
+    const int maxY = std::min(minY + HIZ_TILE_SIZE, g_WindowHeight);
+
+    float maxDepth = -INFINITY;
+    for (int y = minY; y < maxY; y++)
     {
-        return;
+        const float* const depths = GetZBufferSpan(minX, y, maxX - minX);
+        for (int i = 0; i < maxX - minX; i++)
+        {
+            maxDepth = std::max(maxDepth, depths[i]);
+        }
     }
 
-    const size_t position = scast<size_t>(g_WindowWidth * y) + x;
-    if (position >= g_ZBuffer.m_BufferUIntSize)
+    g_ZBuffer.m_TileMaxDepths[(tileY * g_ZBuffer.m_NumTilesX) + tileX] = maxDepth;
+}
+
+size_t CountCoveredPixels()
+{
+    PROFILE_EVENT();
+
+    size_t numCovered = 0;
+    for (int tileY = 0; tileY < g_ZBuffer.m_NumTilesY; tileY++)
     {
-        return;
-    }
+        for (int tileX = 0; tileX < g_ZBuffer.m_NumTilesX; tileX++)
+        {
+            // NOTE(sbalse): Stale tiles hold the depths of an old frame, nothing was drawn to them this frame.
+            if (IsZBufferTileStale((scast<size_t>(tileY) * g_ZBuffer.m_NumTilesX) + tileX))
+            {
+                continue;
+            }
 
-    g_ZBuffer.m_BufferUInt[position] = value;
+            const int minX = tileX * HIZ_TILE_SIZE;
+            const int minY = tileY * HIZ_TILE_SIZE;
+            const int count = std::min(minX + HIZ_TILE_SIZE, g_WindowWidth) - minX;
+            const int maxY = std::min(minY + HIZ_TILE_SIZE, g_WindowHeight);
+            for (int y = minY; y < maxY; y++)
+            {
+                const float* const depths = GetZBufferSpan(minX, y, count);
+                for (int i = 0; i < count; i++)
+                {
+                    numCovered += (depths[i] < 1.0f) ? 1 : 0;
+                }
+            }
+        }
+    }
+    return numCovered;
 }
 
 void DrawGrid()
 {
-    for (int y = 0; y < g_WindowHeight; y++)
+    // NOTE(sbalse): Clip to the clip rect once per row instead of checking every pixel.
+    const ScreenRect clipRect = g_DrawClipRect;
+    const int count = clipRect.m_MaxX - clipRect.m_MinX;
+
+    for (int y = clipRect.m_MinY; y < clipRect.m_MaxY; y++)
     {
-        for (int x = 0; x < g_WindowWidth; x++)
+        u32* const row = GetColorBufferSpan(clipRect.m_MinX, y, count);
+        for (int i = 0; i < count; i++)
         {
+            const int x = clipRect.m_MinX + i;
             if (x % 10 == 0 || y % 10 == 0)
             {
-                UpdateColorBufferAt(x, y, GRAY);
+                row[i] = GRAY;
             }
         }
     }
@@ -300,14 +751,19 @@ void DrawRectangle(
     const int height,
     const u32 color)
 {
-    for (int i = 0; i < width; i++)
+    // NOTE(sbalse): Clip the rectangle to the clip rect once, then every row is an unchecked span.
+    const int minX = std::max(x, g_DrawClipRect.m_MinX);
+    const int minY = std::max(y, g_DrawClipRect.m_MinY);
+    const int maxX = std::min(x + width, g_DrawClipRect.m_MaxX);
+    const int maxY = std::min(y + height, g_DrawClipRect.m_MaxY);
+    if (minX >= maxX)
     {
-        for (int j = 0; j < height; j++)
-        {
-            const int currentX = x + i;
-            const int currentY = y + j;
-            DrawPixel(currentX, currentY, color);
-        }
+        return;
+    }
+
+    for (int currentY = minY; currentY < maxY; currentY++)
+    {
+        std::fill_n(GetColorBufferSpan(minX, currentY, maxX - minX), maxX - minX, color);
     }
 }
 
@@ -337,6 +793,11 @@ void TakeScreenshot(const char* const fileNamePrefix)
 {
     PROFILE_EVENT();
 
+    if (IsHeadless())
+    {
+        return;
+    }
+
     LOG_INFO("Taking screenshot...");
 
     // NOTE(sbalse): Get current Unix timestamp.
@@ -373,6 +834,13 @@ void TakeScreenshot(const char* const fileNamePrefix)
 
 void DestroyWindow()
 {
+    if (IsHeadless())
+    {
+        g_ColorBuffer = {};
+        g_ZBuffer = {};
+        return;
+    }
+
     SDL_DestroyTexture(g_ColorBuffer.m_Texture);
     g_ColorBuffer = {};
 
@@ -383,3 +851,4 @@ void DestroyWindow()
     SDL_DestroyWindow(g_Window);
     SDL_Quit();
 }
+
@@ -16,11 +16,26 @@ struct ZBuffer
 {
     float* m_BufferUNorm; // NOTE(sbalse): Color values are between 0.0f and 1.0f in this.
     size_t m_BufferUNormSize;
-    u32* m_BufferUInt; // NOTE(sbalse): Color values are between 0 to 255 in this.
-    size_t m_BufferUIntSize;
+    // NOTE(sbalse): The grayscale visualization of m_BufferUNorm. Only written by RenderZBuffer(), straight
+    // into the locked texture, so there is no CPU side copy of it.
     SDL_Texture* m_Texture;
+
+    // NOTE(sbalse): Hierarchical Z. The largest (furthest) depth of each HIZ_TILE_SIZE x HIZ_TILE_SIZE tile
+    // of m_BufferUNorm. It is allowed to be larger than the real max depth of the tile, so it only has to
+    // be updated after drawing to the tile to make it tighter.
+    float* m_TileMaxDepths;
+    int m_NumTilesX;
+    int m_NumTilesY;
+
+    // NOTE(sbalse): Only used with DepthClearMethod::EpochTagged. The frame a tile of m_BufferUNorm was last
+    // cleared in. Tiles tagged with an older epoch hold the depths of an old frame and get cleared the
+    // first time a triangle touches them this frame.
+    u32* m_TileEpochs;
+    u32 m_Epoch;
 };
 
+inline constexpr int HIZ_TILE_SIZE = 8;
+
 enum class CullMethod
 {
     None,
@@ -49,7 +64,90 @@ enum class ShadingMethod
     FlatShading
 };
 
+enum class RasterizerMethod
+{
+    Serial, // NOTE(sbalse): Draw all the triangles one after the other on the main thread.
+    Tiled, // NOTE(sbalse): Bin the triangles into screen tiles and draw the tiles in parallel.
+};
+
+enum class OcclusionCullMethod
+{
+    None,
+    HiZ, // NOTE(sbalse): Skip the tiles of a triangle that are hidden according to the hierarchical Z.
+};
+
+// NOTE(sbalse): The compare of the depth test. A pixel is drawn when its depth compares true against the
+// one in the Z buffer. LessEqual is used by the shading pass after a depth pre-pass, since the pre-pass
+// has already left the exact depth of the visible pixels in the Z buffer.
+enum class DepthTestMethod
+{
+    Less,
+    LessEqual,
+};
+
+// NOTE(sbalse): The order in which the triangles are rasterized.
+enum class TriangleSortMethod
+{
+    None, // NOTE(sbalse): Submission order, meshes front to back and the faces of a mesh in file order.
+    FrontToBack, // NOTE(sbalse): Radix sorted by the quantized depth of each triangle, nearest first.
+};
+
+enum class DepthPrepassMethod
+{
+    None,
+    DepthOnly, // NOTE(sbalse): Draw the depth of all triangles first so each pixel is only shaded once.
+};
+
+enum class DepthClearMethod
+{
+    Full, // NOTE(sbalse): Clear the whole Z buffer every frame.
+    EpochTagged, // NOTE(sbalse): Only clear the Z buffer tiles that get drawn to, on first touch.
+};
+
+enum class PixelKernelMethod
+{
+    Scalar, // NOTE(sbalse): One pixel at a time.
+    SSE2, // NOTE(sbalse): 4 pixels at a time.
+    AVX2, // NOTE(sbalse): 8 pixels at a time, with gathered texel fetches.
+};
+
+// NOTE(sbalse): How the mip level that a textured pixel is sampled from is picked.
+enum class MipLevelMethod
+{
+    None, // NOTE(sbalse): Always the full size level.
+    PerTriangle, // NOTE(sbalse): One level for the whole triangle from the ratio of its texture and screen areas.
+    PerPixel, // NOTE(sbalse): From the screen space derivatives of the texture coordinates at each pixel.
+};
+
+// NOTE(sbalse): How a textured pixel is sampled from its mip level.
+enum class TextureFilterMethod
+{
+    Nearest, // NOTE(sbalse): The texel the pixel center falls in.
+    Bilinear, // NOTE(sbalse): The four texels around the pixel center blended with 8 bit fixed point weights.
+};
+
+// NOTE(sbalse): The space the triangles are clipped against the view frustum in.
+enum class ClippingMethod
+{
+    CameraSpace, // NOTE(sbalse): Against the frustum planes in camera space, projected per clipped triangle after.
+    Homogeneous, // NOTE(sbalse): Against -w < x, y < w and 0 < z < w after projecting every vertex once.
+    GuardBand, // NOTE(sbalse): Homogeneous, with the side planes only clipped outside of a guard band around the screen.
+};
+
+// NOTE(sbalse): A rectangle in screen space. Min is inclusive and max is exclusive.
+struct ScreenRect
+{
+    int m_MinX;
+    int m_MinY;
+    int m_MaxX;
+    int m_MaxY;
+};
+
 bool InitializeWindow(Arena* const frameArena, const char* const windowTitle);
+// NOTE(sbalse): Allocate the color and Z buffers without creating a window, for rendering on machines
+// without a display. Presenting does nothing in headless mode.
+bool InitializeHeadless(Arena* const persistentArena);
+bool IsHeadless();
 void DestroyWindow();
 
 int GetWindowWidth();
@@ -67,17 +165,39 @@ void DrawRectangle(
 void DrawLine(const int x0, const int y0, const int x1, const int y1, const u32 color);
 void TakeScreenshot(const char* const fileNamePrefix);
 
+// NOTE(sbalse): All drawing on the calling thread is restricted to the clip rect. Each thread has its
+// own clip rect so that the tiled rasterizer can draw different tiles on different threads.
+ScreenRect GetDrawClipRect();
+void SetDrawClipRect(const ScreenRect rect);
+void ResetDrawClipRect(); // NOTE(sbalse): Reset the clip rect back to the full window.
+
+// NOTE(sbalse): Hash of the color buffer contents, to check that two runs drew exactly the same frame.
+u64 GetColorBufferHash();
+
 void RenderColorBuffer();
+// NOTE(sbalse): Present a grayscale visualization of the Z buffer, built from it in one pass.
 void RenderZBuffer();
-void ClearColorBuffer(const u32 color);
-void ClearZBuffer();
+// NOTE(sbalse): Clear the color buffer to the color and the Z buffer to the far plane in a single pass.
+// With DepthClearMethod::EpochTagged the Z buffer is not cleared here at all, see ClearStaleZBufferTiles().
+void ClearFrameBuffers(const u32 color);
+// NOTE(sbalse): Clear the Z buffer tiles overlapping the rect that haven't been cleared this frame. Has to
+// be called before touching the Z buffer inside the rect. Does nothing with DepthClearMethod::Full.
+void ClearStaleZBufferTiles(const ScreenRect rect);
+
+// NOTE(sbalse): Pointers to pixels x to x + count - 1 of row y of the buffers, for code that writes whole
+// runs of pixels at a time. The caller clips the span to the clip rect once per row, so these do no bounds
+// checking. Debug builds assert that the span is inside the window.
+u32* GetColorBufferSpan(const int x, const int y, const int count);
+// NOTE(sbalse): The normalized Z buffer is the one actually used for depth testing.
+float* GetZBufferSpan(const int x, const int y, const int count);
 
-float GetZBufferAt(const int x, const int y);
-// NOTE(sbalse): Normalized Z-Buffer is the array that's actually used for depth-testing.
-void UpdateNormalizedZBufferAt(const int x, const int y, const float value);
-// NOTE(sbalse): Displayable Z-Buffer is the array that contains the grayscale value used to display
-// and visualize the z-buffer.
-void UpdateDisplayableZBufferAt(const int x, const int y, const u32 value);
+// NOTE(sbalse): Max depth of a hierarchical Z tile. Every depth in the tile is <= this.
+float GetHiZTileMaxDepth(const int tileX, const int tileY);
+// NOTE(sbalse): Recompute the max depth of a hierarchical Z tile from the Z buffer after drawing to it.
+void UpdateHiZTile(const int tileX, const int tileY);
+// NOTE(sbalse): Number of pixels drawn to since the last ClearFrameBuffers(), that is the ones with a depth
+// nearer than the far plane.
+size_t CountCoveredPixels();
 
 CullMethod GetCullMethod();
 void SetCullMethod(const CullMethod newCullMethod);
@@ -87,3 +207,23 @@ ShadingMethod GetShadingMethod();
 void SetShadingMethod(const ShadingMethod newShadingMethod);
 RenderBufferMethod GetRenderBufferMethod();
 void SetRenderBufferMethod(const RenderBufferMethod newRenderBufferMethod);
+RasterizerMethod GetRasterizerMethod();
+void SetRasterizerMethod(const RasterizerMethod newRasterizerMethod);
+OcclusionCullMethod GetOcclusionCullMethod();
+void SetOcclusionCullMethod(const OcclusionCullMethod newOcclusionCullMethod);
+DepthTestMethod GetDepthTestMethod();
+void SetDepthTestMethod(const DepthTestMethod newDepthTestMethod);
+TriangleSortMethod GetTriangleSortMethod();
+void SetTriangleSortMethod(const TriangleSortMethod newTriangleSortMethod);
+DepthClearMethod GetDepthClearMethod();
+void SetDepthClearMethod(const DepthClearMethod newDepthClearMethod);
+DepthPrepassMethod GetDepthPrepassMethod();
+void SetDepthPrepassMethod(const DepthPrepassMethod newDepthPrepassMethod);
+PixelKernelMethod GetPixelKernelMethod();
+void SetPixelKernelMethod(const PixelKernelMethod newPixelKernelMethod);
+MipLevelMethod GetMipLevelMethod();
+void SetMipLevelMethod(const MipLevelMethod newMipLevelMethod);
+TextureFilterMethod GetTextureFilterMethod();
+void SetTextureFilterMethod(const TextureFilterMethod newTextureFilterMethod);
+ClippingMethod GetClippingMethod();
+void SetClippingMethod(const ClippingMethod newClippingMethod);
@@ -0,0 +1,169 @@
+#include "fileio.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool MapFile(const char* const fileName, MappedFile* const outFile)
+{
+    *outFile = {};
+
+    const HANDLE file = CreateFileA(
+        fileName,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // NOTE(sbalse): Empty files can't be mapped, but they are still valid files.
+    if (fileSize.QuadPart == 0)
+    {
+        outFile->m_FileHandle = file;
+        return true;
+    }
+
+    const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* const data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    outFile->m_Data = scast<const u8*>(data);
+    outFile->m_Size = scast<size_t>(fileSize.QuadPart);
+    outFile->m_FileHandle = file;
+    outFile->m_MappingHandle = mapping;
+    return true;
+}
+
+void UnmapFile(MappedFile* const file)
+{
+    if (file->m_Data)
+    {
+        UnmapViewOfFile(file->m_Data);
+    }
+    if (file->m_MappingHandle)
+    {
+        CloseHandle(file->m_MappingHandle);
+    }
+    if (file->m_FileHandle)
+    {
+        CloseHandle(file->m_FileHandle);
+    }
+
+    *file = {};
+}
+
+bool GetFileStamp(const char* const fileName, FileStamp* const outStamp)
+{
+    *outStamp = {};
+
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+    if (!GetFileAttributesExA(fileName, GetFileExInfoStandard, &attributes))
+    {
+        return false;
+    }
+
+    outStamp->m_ModificationTime = scast<i64>(
+        (scast<u64>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime
+    );
+    outStamp->m_Size = (scast<u64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+    return true;
+}
+
+#else
+
+bool MapFile(const char* const fileName, MappedFile* const outFile)
+{
+    *outFile = {};
+
+    const int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // NOTE(sbalse): The mapping stays valid after closing the file descriptor.
+    const size_t fileSize = scast<size_t>(fileStat.st_size);
+    void* data = nullptr;
+    if (fileSize > 0)
+    {
+        data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+
+    outFile->m_Data = scast<const u8*>(data);
+    outFile->m_Size = fileSize;
+    return true;
+}
+
+void UnmapFile(MappedFile* const file)
+{
+    if (file->m_Data)
+    {
+        munmap(const_cast<u8*>(file->m_Data), file->m_Size);
+    }
+
+    *file = {};
+}
+
+bool GetFileStamp(const char* const fileName, FileStamp* const outStamp)
+{
+    *outStamp = {};
+
+    struct stat fileStat = {};
+    if (stat(fileName, &fileStat) != 0)
+    {
+        return false;
+    }
+
+    outStamp->m_ModificationTime = scast<i64>(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+    outStamp->m_Size = scast<u64>(fileStat.st_size);
+    return true;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include "common.h"
+
+// NOTE(sbalse): A read only file mapped into memory. The OS pages the contents in on demand, so the file
+// can be parsed in place without copying it into our own buffers first.
+struct MappedFile
+{
+    const u8* m_Data; // NOTE(sbalse): nullptr for empty files.
+    size_t m_Size;
+
+    // NOTE(sbalse): OS handles needed to unmap the file.
+    void* m_FileHandle;
+    void* m_MappingHandle;
+};
+
+bool MapFile(const char* const fileName, MappedFile* const outFile);
+void UnmapFile(MappedFile* const file);
+
+// NOTE(sbalse): Identifies a version of a file. If either value changes the file has changed.
+struct FileStamp
+{
+    i64 m_ModificationTime; // NOTE(sbalse): In OS specific units, only useful for comparisons.
+    u64 m_Size;
+};
+
+bool GetFileStamp(const char* const fileName, FileStamp* const outStamp);
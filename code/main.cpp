@@ -1,6 +1,9 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
 #include <SDL.h>
 extern "C"
 {
@@ -19,6 +22,12 @@ extern "C"
 #include "camera.h"
 #include "clipping.h"
 #include "triangle.h"
+#include "rasterizer.h"
+#include "pixelkernels.h"
+#include "vertexkernels.h"
+#include "threadpool.h"
+#include "benchmark.h"
+#include "stats.h"
 #include "profile.h"
 
 constinit static bool g_IsRunning = false;
@@ -27,6 +36,11 @@ inline constexpr size_t MAX_NUM_TRIANGLES_TO_RENDER = 10000;
 constinit static size_t g_NumTrianglesToRender = 0;
 constinit static Triangle* g_TrianglesToRender = nullptr;
 
+// NOTE(sbalse): The geometry stage splits the meshes into chunks of this many vertices and faces, so that
+// meshes of any size are spread over all the threads.
+inline constexpr size_t GEOMETRY_VERTEX_CHUNK_SIZE = 1024;
+inline constexpr size_t GEOMETRY_FACE_CHUNK_SIZE = 256;
+
 // TODO(sbalse): IMGUI
 constinit static bool g_Paused = false;
 constinit static bool g_PrintFPS = false;
@@ -34,7 +48,6 @@ constinit static bool g_DisplayGrid = false;
 
 constinit static int g_UpdateCallCount = 0;
 
-constinit static Mat4 g_WorldMatrix = {};
 constinit static Mat4 g_ProjMatrix = {};
 constinit static Mat4 g_ViewMatrix = {};
 
@@ -44,14 +57,27 @@ inline constexpr Vec3 CAMERA_UP_DIRECTION = { 0, 1, 0 };
 inline constexpr u32 TARGET_UPDATES_PER_SECOND = 30;
 inline constexpr float FIXED_UPDATE_TIMESTEP = 1.0f / TARGET_UPDATES_PER_SECOND;
 
-static void Setup(Arena* frameArena, Arena* persistentArena)
+static void Setup(Arena* frameArena, Arena* persistentArena, const TextureLayout textureLayout)
 {
-    SDL_SetRelativeMouseMode(SDL_TRUE);
+    if (!IsHeadless())
+    {
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+    }
 
     // NOTE(sbalse): Init the render mode, triangle culling method and shading method.
     SetCullMethod(CullMethod::Backface);
     SetRenderMethod(RenderMethod::Textured);
     SetShadingMethod(ShadingMethod::FlatShading);
+    SetRasterizerMethod(RasterizerMethod::Tiled);
+    SetOcclusionCullMethod(OcclusionCullMethod::HiZ);
+    SetTriangleSortMethod(TriangleSortMethod::FrontToBack);
+    SetDepthPrepassMethod(DepthPrepassMethod::None);
+    SetDepthClearMethod(DepthClearMethod::Full);
+    SetMipLevelMethod(MipLevelMethod::PerPixel);
+    SetTextureFilterMethod(TextureFilterMethod::Nearest);
+    SetClippingMethod(ClippingMethod::Homogeneous);
+    SetPixelKernelMethod(GetBestPixelKernelMethod());
+    LOG_INFO("Using the \"%s\" pixel kernels.", GetPixelKernelMethodName(GetPixelKernelMethod()));
 
     // NOTE(sbalse): Init the light direction. Z = 1 means light goes from camera into the screen.
     InitLight(Vec3{ .m_Z = 1 });
@@ -71,7 +97,11 @@ static void Setup(Arena* frameArena, Arena* persistentArena)
     // NOTE(sbalse): Initialize clipping frustum planes with a point and a normal.
     InitFrustumPlanes(fovXRadians, FOV_Y_RADIANS, Z_NEAR, Z_FAR);
 
-    g_TrianglesToRender = PushArray(frameArena, Triangle, MAX_NUM_TRIANGLES_TO_RENDER);
+    // NOTE(sbalse): The triangles are rebuilt every update but the array itself lives for the whole
+    // program, so allocate it from the persistent arena. The frame arena gets freed every update.
+    g_TrianglesToRender = PushArray(persistentArena, Triangle, MAX_NUM_TRIANGLES_TO_RENDER);
+
+    LOG_INFO("Using the \"%s\" texture layout.", GetTextureLayoutName(textureLayout));
 
     LoadMesh(
         persistentArena,
@@ -79,7 +109,8 @@ static void Setup(Arena* frameArena, Arena* persistentArena)
         "assets/runway.png",
         Vec3{ 0, -1.5, +23 },
         Vec3{ 1, 1, 1 },
-        Vec3{}
+        Vec3{},
+        textureLayout
     );
     LoadMesh(
         persistentArena,
@@ -87,7 +118,8 @@ static void Setup(Arena* frameArena, Arena* persistentArena)
         "assets/f22.png",
         Vec3{ 0, -1.3, +5 },
         Vec3{ 1, 1, 1 },
-        Vec3{ 0, -M_PI / 2, 0 }
+        Vec3{ 0, -M_PI / 2, 0 },
+        textureLayout
     );
     LoadMesh(
         persistentArena,
@@ -95,7 +127,8 @@ static void Setup(Arena* frameArena, Arena* persistentArena)
         "assets/efa.png",
         Vec3{ -2, -1.3, +9 },
         Vec3{ 1, 1, 1 },
-        Vec3{ 0, -M_PI / 2, 0 }
+        Vec3{ 0, -M_PI / 2, 0 },
+        textureLayout
     );
     LoadMesh(
         persistentArena,
@@ -103,10 +136,43 @@ static void Setup(Arena* frameArena, Arena* persistentArena)
         "assets/f117.png",
         Vec3{ +2, -1.3, +9 },
         Vec3{ 1, 1, 1 },
-        Vec3{ 0, -M_PI / 2, 0 }
+        Vec3{ 0, -M_PI / 2, 0 },
+        textureLayout
     );
 }
 
+static const char* GetMipLevelMethodName(const MipLevelMethod method)
+{
+    switch (method)
+    {
+    case MipLevelMethod::None: return "None";
+    case MipLevelMethod::PerTriangle: return "PerTriangle";
+    case MipLevelMethod::PerPixel: return "PerPixel";
+    default: return "Unknown";
+    }
+}
+
+static const char* GetTextureFilterMethodName(const TextureFilterMethod method)
+{
+    switch (method)
+    {
+    case TextureFilterMethod::Nearest: return "Nearest";
+    case TextureFilterMethod::Bilinear: return "Bilinear";
+    default: return "Unknown";
+    }
+}
+
+static const char* GetClippingMethodName(const ClippingMethod method)
+{
+    switch (method)
+    {
+    case ClippingMethod::CameraSpace: return "CameraSpace";
+    case ClippingMethod::Homogeneous: return "Homogeneous";
+    case ClippingMethod::GuardBand: return "GuardBand";
+    default: return "Unknown";
+    }
+}
+
 static void ProcessInput()
 {
     PROFILE_EVENT();
@@ -233,6 +299,132 @@ static void ProcessInput()
                 SetRenderMethod(RenderMethod::WireTextured);
                 LOG_INFO("Set render method to \"WireTextured\".");
             }
+            // NOTE(sbalse): t to toggle between the serial and the tiled rasterizer.
+            else if (event.key.keysym.sym == SDLK_t)
+            {
+                if (GetRasterizerMethod() == RasterizerMethod::Tiled)
+                {
+                    SetRasterizerMethod(RasterizerMethod::Serial);
+                    LOG_INFO("Set rasterizer method to \"Serial\".");
+                }
+                else
+                {
+                    SetRasterizerMethod(RasterizerMethod::Tiled);
+                    LOG_INFO("Set rasterizer method to \"Tiled\".");
+                }
+            }
+            // NOTE(sbalse): h to toggle the hierarchical Z occlusion culling.
+            else if (event.key.keysym.sym == SDLK_h)
+            {
+                if (GetOcclusionCullMethod() == OcclusionCullMethod::HiZ)
+                {
+                    SetOcclusionCullMethod(OcclusionCullMethod::None);
+                    LOG_INFO("Set occlusion cull method to \"None\".");
+                }
+                else
+                {
+                    SetOcclusionCullMethod(OcclusionCullMethod::HiZ);
+                    LOG_INFO("Set occlusion cull method to \"HiZ\".");
+                }
+            }
+            // NOTE(sbalse): o to toggle sorting the triangles front to back.
+            else if (event.key.keysym.sym == SDLK_o)
+            {
+                if (GetTriangleSortMethod() == TriangleSortMethod::FrontToBack)
+                {
+                    SetTriangleSortMethod(TriangleSortMethod::None);
+                    LOG_INFO("Set triangle sort method to \"None\".");
+                }
+                else
+                {
+                    SetTriangleSortMethod(TriangleSortMethod::FrontToBack);
+                    LOG_INFO("Set triangle sort method to \"FrontToBack\".");
+                }
+            }
+            // NOTE(sbalse): x to toggle the depth pre-pass.
+            else if (event.key.keysym.sym == SDLK_x)
+            {
+                if (GetDepthPrepassMethod() == DepthPrepassMethod::DepthOnly)
+                {
+                    SetDepthPrepassMethod(DepthPrepassMethod::None);
+                    LOG_INFO("Set depth pre-pass method to \"None\".");
+                }
+                else
+                {
+                    SetDepthPrepassMethod(DepthPrepassMethod::DepthOnly);
+                    LOG_INFO("Set depth pre-pass method to \"DepthOnly\".");
+                }
+            }
+            // NOTE(sbalse): j to toggle between clearing the whole Z buffer and epoch tagged Z buffer tiles.
+            else if (event.key.keysym.sym == SDLK_j)
+            {
+                if (GetDepthClearMethod() == DepthClearMethod::EpochTagged)
+                {
+                    SetDepthClearMethod(DepthClearMethod::Full);
+                    LOG_INFO("Set depth clear method to \"Full\".");
+                }
+                else
+                {
+                    SetDepthClearMethod(DepthClearMethod::EpochTagged);
+                    LOG_INFO("Set depth clear method to \"EpochTagged\".");
+                }
+            }
+            // NOTE(sbalse): m to cycle through the mip level methods.
+            else if (event.key.keysym.sym == SDLK_m)
+            {
+                const MipLevelMethod method = (GetMipLevelMethod() == MipLevelMethod::PerPixel)
+                    ? MipLevelMethod::None
+                    : scast<MipLevelMethod>(scast<int>(GetMipLevelMethod()) + 1);
+
+                SetMipLevelMethod(method);
+                LOG_INFO("Set mip level method to \"%s\".", GetMipLevelMethodName(method));
+            }
+            // NOTE(sbalse): b to toggle between nearest and bilinear texture filtering.
+            else if (event.key.keysym.sym == SDLK_b)
+            {
+                const TextureFilterMethod method = (GetTextureFilterMethod() == TextureFilterMethod::Bilinear)
+                    ? TextureFilterMethod::Nearest
+                    : TextureFilterMethod::Bilinear;
+
+                SetTextureFilterMethod(method);
+                LOG_INFO("Set texture filter method to \"%s\".", GetTextureFilterMethodName(method));
+            }
+            // NOTE(sbalse): v to cycle through the clipping methods.
+            else if (event.key.keysym.sym == SDLK_v)
+            {
+                const ClippingMethod method = (GetClippingMethod() == ClippingMethod::GuardBand)
+                    ? ClippingMethod::CameraSpace
+                    : scast<ClippingMethod>(scast<int>(GetClippingMethod()) + 1);
+
+                SetClippingMethod(method);
+                LOG_INFO("Set clipping method to \"%s\".", GetClippingMethodName(method));
+            }
+            // NOTE(sbalse): k to cycle through the pixel kernels supported by this CPU.
+            else if (event.key.keysym.sym == SDLK_k)
+            {
+                PixelKernelMethod method = GetPixelKernelMethod();
+                do
+                {
+                    method = (method == PixelKernelMethod::AVX2)
+                        ? PixelKernelMethod::Scalar
+                        : scast<PixelKernelMethod>(scast<int>(method) + 1);
+                } while (!IsPixelKernelMethodSupported(method));
+
+                SetPixelKernelMethod(method);
+                LOG_INFO("Set pixel kernel method to \"%s\".", GetPixelKernelMethodName(method));
+            }
+            // NOTE(sbalse): - and = to decrease/increase the number of threads used by the tiled
+            // rasterizer.
+            else if (event.key.keysym.sym == SDLK_MINUS || event.key.keysym.sym == SDLK_EQUALS)
+            {
+                const int change = (event.key.keysym.sym == SDLK_MINUS) ? -1 : 1;
+                SetThreadPoolThreadCount(GetThreadPoolThreadCount() + change);
+                LOG_INFO(
+                    "Using %d of %d threads.",
+                    GetThreadPoolThreadCount(),
+                    GetThreadPoolMaxThreadCount()
+                );
+            }
             // NOTE(sbalse): c to toggle backface culling.
             else if (event.key.keysym.sym == SDLK_c)
             {
@@ -298,95 +490,158 @@ static void ProcessInput()
     RotateCameraPitch(mouseY * cameraSensitivity);
 }
 
-// NOTE(sbalse): Process the graphics pipeline stages for all the mesh triangles.
-//
-// Model space   <-- original mesh vertices
-// |
-// |---> World space   <-- multiply by world matrix
-//      |
-//      |---> Camera space   <-- multiply by view matrix
-//          |
-//          |---> Clipping      <-- clip against the 6 frustum planes
-//                |
-//                |---> Projection   <-- multiply by projection matrix
-//                      |
-//                      |---> Image space  <-- apply perspective divide
-//                            |
-//                            |---> Screen space   <-- ready to render
-//
-static void ProcessGraphicsPipelineStages(const Mesh* const mesh)
+// NOTE(sbalse): Update the camera and create the view matrix shared by all the meshes of this frame.
+static void SetupCameraView()
 {
-    PROFILE_EVENT_SCOPED_BEGIN(_, "ProcessGraphicsPipelineStages");
-
-    // NOTE(sbalse): Create scale, translation, and rotation matrices that will be
-    // multiplied with our mesh vertices.
-    const Mat4 scaleMatrix = Mat4MakeScale(
-        mesh->m_Scale.m_X,
-        mesh->m_Scale.m_Y,
-        mesh->m_Scale.m_Z
-    );
-    const Mat4 translationMatrix = Mat4MakeTranslation(
-        mesh->m_Translation.m_X,
-        mesh->m_Translation.m_Y,
-        mesh->m_Translation.m_Z
-    );
-    const Mat4 rotationMatrixX = Mat4MakeRotationX(mesh->m_Rotation.m_X);
-    const Mat4 rotationMatrixY = Mat4MakeRotationY(mesh->m_Rotation.m_Y);
-    const Mat4 rotationMatrixZ = Mat4MakeRotationZ(mesh->m_Rotation.m_Z);
-
-    // NOTE(sbalse): Create a "World Matrix" combining scale, rotation and translation
-    // matrices of the mesh.
-    g_WorldMatrix = MAT4_IDENTITY;
-    g_WorldMatrix = Mat4MulMat4(scaleMatrix, g_WorldMatrix);
-    g_WorldMatrix = Mat4MulMat4(rotationMatrixX, g_WorldMatrix);
-    g_WorldMatrix = Mat4MulMat4(rotationMatrixY, g_WorldMatrix);
-    g_WorldMatrix = Mat4MulMat4(rotationMatrixZ, g_WorldMatrix);
-    g_WorldMatrix = Mat4MulMat4(translationMatrix, g_WorldMatrix);
+    PROFILE_EVENT();
 
     // NOTE(sbalse): Update camera look at target to create a view matrix
     const Vec3 cameraTarget = UpdateCameraAndGetLookAtTarget();
 
     // NOTE(sbalse): Create the view matrix.
     g_ViewMatrix = Mat4LookAt(GetCameraPosition(), cameraTarget, CAMERA_UP_DIRECTION);
+}
 
-    // NOTE(sbalse): Loop all faces of our mesh.
-    for (size_t meshFaceIndex = 0; meshFaceIndex < mesh->m_FacesCount; meshFaceIndex++)
-    {
-        const Face meshFace = mesh->m_Faces[meshFaceIndex];
-
-        // NOTE(sbalse): The 3 vertices that make up a triangle of a face.
-        const Vec3 faceVertices[3] =
-        {
-            mesh->m_Vertices[meshFace.m_A],
-            mesh->m_Vertices[meshFace.m_B],
-            mesh->m_Vertices[meshFace.m_C],
-        };
+// NOTE(sbalse): A mesh going through the geometry stage this frame.
+struct GeometryMesh
+{
+    const Mesh* m_Mesh;
+    Mat4 m_ModelViewMatrix;
+    Mat4 m_ModelViewProjectionMatrix;
+    Vec3Streams m_CameraSpaceVertices;
+    // NOTE(sbalse): Only with ClippingMethod::Homogeneous. Every vertex is projected once here and the faces
+    // that share it look it up.
+    Vec4Streams m_ClipSpaceVertices;
+    // NOTE(sbalse): The frustum outcode of each vertex, in the space that ClippingMethod clips in.
+    u8* m_VertexOutcodes;
+    // NOTE(sbalse): Only with ClippingMethod::GuardBand. The outcode of each vertex against the guard band
+    // side planes and the near and far planes.
+    u8* m_VertexGuardBandOutcodes;
+};
+
+// NOTE(sbalse): A range of the vertices or the faces of a mesh that one thread processes in one go. Every face
+// chunk has room for MAX_NUM_POLYGON_TRIANGLES triangles per face, so none of its triangles ever get dropped.
+struct GeometryChunk
+{
+    const GeometryMesh* m_GeometryMesh;
+    size_t m_First;
+    size_t m_Count;
+    Triangle* m_Triangles;
+    size_t m_NumTriangles;
+};
+
+// NOTE(sbalse): Transform a chunk of the vertices of a mesh to camera space. A vertex is usually shared by
+// several faces, so the faces look their vertices up by index instead of transforming them again for every
+// face they are part of.
+static void TransformVertexChunk(void* userData, const int chunkIndex, const int threadIndex)
+{
+    PROFILE_EVENT();
 
-        Vec4 transformedVertices[3] = {};
+    const GeometryChunk& chunk = scast<const GeometryChunk*>(userData)[chunkIndex];
+    const GeometryMesh& geometryMesh = *chunk.m_GeometryMesh;
+    const Vec3Streams& vertices = geometryMesh.m_Mesh->m_VertexStreams;
+    const ClippingMethod clippingMethod = GetClippingMethod();
+
+    // NOTE(sbalse): Transform our vertices to camera space by multiplying them with the model-view matrix.
+    TransformPointStreams(
+        geometryMesh.m_ModelViewMatrix,
+        vertices,
+        chunk.m_First,
+        chunk.m_Count,
+        geometryMesh.m_CameraSpaceVertices
+    );
 
-        // NOTE(sbalse): Loop over vertices of the face.
-        for (int vertexIndex = 0; vertexIndex < 3; vertexIndex++)
+    if (clippingMethod != ClippingMethod::CameraSpace)
+    {
+        // NOTE(sbalse): The camera space vertices are still needed for the face normals, so project the
+        // model space vertices with the full model-view-projection matrix.
+        ProjectPointStreams(
+            geometryMesh.m_ModelViewProjectionMatrix,
+            vertices,
+            chunk.m_First,
+            chunk.m_Count,
+            geometryMesh.m_ClipSpaceVertices
+        );
+        GetHomogeneousOutcodeStreams(
+            geometryMesh.m_ClipSpaceVertices,
+            chunk.m_First,
+            chunk.m_Count,
+            1.0f,
+            geometryMesh.m_VertexOutcodes
+        );
+        if (clippingMethod == ClippingMethod::GuardBand)
         {
-            Vec4 transformedVertex = Vec4FromVec3(faceVertices[vertexIndex]);
+            GetHomogeneousOutcodeStreams(
+                geometryMesh.m_ClipSpaceVertices,
+                chunk.m_First,
+                chunk.m_Count,
+                GUARD_BAND_SCALE,
+                geometryMesh.m_VertexGuardBandOutcodes
+            );
+
+            // NOTE(sbalse): A vertex inside all the side planes of the frustum is inside the guard band too.
+            for (size_t vertexIndex = chunk.m_First; vertexIndex < chunk.m_First + chunk.m_Count; vertexIndex++)
+            {
+                const u8 outcode = geometryMesh.m_VertexOutcodes[vertexIndex];
+                if (!(outcode & FRUSTUM_SIDE_PLANES_MASK))
+                {
+                    geometryMesh.m_VertexGuardBandOutcodes[vertexIndex] = outcode;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (size_t vertexIndex = chunk.m_First; vertexIndex < chunk.m_First + chunk.m_Count; vertexIndex++)
+        {
+            geometryMesh.m_VertexOutcodes[vertexIndex] = GetFrustumOutcode(
+                GetVec3FromStreams(geometryMesh.m_CameraSpaceVertices, vertexIndex)
+            );
+        }
+    }
+}
 
-            // NOTE(sbalse): Transform our vertex by multiplying it with our world matrix.
-            transformedVertex = Mat4MulVec4(g_WorldMatrix, transformedVertex);
+// NOTE(sbalse): Cull, clip and project a chunk of the faces of a mesh and store the resulting triangles in the
+// chunk. Which thread runs the chunk doesn't change its triangles.
+static void AssembleFaceChunk(void* userData, const int chunkIndex, const int threadIndex)
+{
+    PROFILE_EVENT();
 
-            // NOTE(sbalse): Multiply the view matrix by the original vector to transform
-            // our scene to camera space.
-            transformedVertex = Mat4MulVec4(g_ViewMatrix, transformedVertex);
+    GeometryChunk& chunk = scast<GeometryChunk*>(userData)[chunkIndex];
+    const Mesh* const mesh = chunk.m_GeometryMesh->m_Mesh;
+    const Vec3Streams& cameraSpaceVertices = chunk.m_GeometryMesh->m_CameraSpaceVertices;
+    const Vec4Streams& clipSpaceVertices = chunk.m_GeometryMesh->m_ClipSpaceVertices;
+    const u8* const vertexOutcodes = chunk.m_GeometryMesh->m_VertexOutcodes;
+    const u8* const vertexGuardBandOutcodes = chunk.m_GeometryMesh->m_VertexGuardBandOutcodes;
+    const ClippingMethod clippingMethod = GetClippingMethod();
+    const bool isHomogeneousClipping = clippingMethod != ClippingMethod::CameraSpace;
+
+    // NOTE(sbalse): Counted locally and added to the frame counters once per chunk.
+    u64 numTriviallyAccepted = 0;
+    u64 numGuardBandAccepted = 0;
+    u64 numTriviallyRejected = 0;
+    u64 numClipped = 0;
+
+    chunk.m_NumTriangles = 0;
+
+    // NOTE(sbalse): Loop all faces of the chunk.
+    for (size_t meshFaceIndex = chunk.m_First; meshFaceIndex < chunk.m_First + chunk.m_Count; meshFaceIndex++)
+    {
+        const Face meshFace = mesh->m_Faces[meshFaceIndex];
 
-            // NOTE(sbalse): Save the transformed vertex.
-            transformedVertices[vertexIndex] = transformedVertex;
-        }
+        // NOTE(sbalse): The 3 camera space vertices that make up a triangle of a face.
+        const Vec4 transformedVertices[3] =
+        {
+            Vec4FromVec3(GetVec3FromStreams(cameraSpaceVertices, meshFace.m_A)),
+            Vec4FromVec3(GetVec3FromStreams(cameraSpaceVertices, meshFace.m_B)),
+            Vec4FromVec3(GetVec3FromStreams(cameraSpaceVertices, meshFace.m_C)),
+        };
 
         const Vec3 faceNormal = GetTriangleNormal(transformedVertices);
 
         // NOTE(sbalse): Do backface culling.
         if (GetCullMethod() == CullMethod::Backface)
         {
-            // NOTE(sbalse): Calculate the triangle face normal.
-
             // NOTE(sbalse): Find the vector between a point in the triangle and the camera origin.
             // We directly use ORIGIN here [i.e. (0, 0, 0)] since our camera is always meant to be the
             // origin of our world.
@@ -405,24 +660,111 @@ static void ProcessGraphicsPipelineStages(const Mesh* const mesh)
         }
 
         // NOTE(sbalse): Do clipping before projecting the vertices.
-        // NOTE(sbalse): Create a polygon to be clipped from the original transformed vertices.
-        Polygon polygon = CreatePolygonFromTriangle(
-            Vec3FromVec4(transformedVertices[0]),
-            Vec3FromVec4(transformedVertices[1]),
-            Vec3FromVec4(transformedVertices[2]),
-            meshFace.m_AUV,
-            meshFace.m_BUV,
-            meshFace.m_CUV
-        );
+        const u8 outcodes[3] =
+        {
+            vertexOutcodes[meshFace.m_A],
+            vertexOutcodes[meshFace.m_B],
+            vertexOutcodes[meshFace.m_C],
+        };
 
-        // NOTE(sbalse): Clip the polygon and get a new polygon with potentially new vertices.
-        ClipPolygon(&polygon);
+        // NOTE(sbalse): All 3 vertices are outside of the same plane, so the whole triangle is too.
+        if (outcodes[0] & outcodes[1] & outcodes[2])
+        {
+            numTriviallyRejected++;
+            continue;
+        }
 
         Triangle trianglesAfterClipping[MAX_NUM_POLYGON_TRIANGLES] = {};
         int numTrianglesAfterClipping = 0;
 
-        // NOTE(sbalse): After clipping, we need to break the clipping polygon back into triangles.
-        TrianglesFromPolygon(&polygon, trianglesAfterClipping, &numTrianglesAfterClipping);
+        // NOTE(sbalse): The triangle can only cross the planes that at least one of its vertices is outside of.
+        const u8 frustumPlanesCrossed = outcodes[0] | outcodes[1] | outcodes[2];
+        u8 planesToClip = frustumPlanesCrossed;
+        float sidePlaneScale = 1.0f;
+        if (clippingMethod == ClippingMethod::GuardBand)
+        {
+            // NOTE(sbalse): Triangles that only poke out of the sides of the screen are rasterized as they are,
+            // only the parts outside of the guard band are clipped away.
+            planesToClip = vertexGuardBandOutcodes[meshFace.m_A]
+                | vertexGuardBandOutcodes[meshFace.m_B]
+                | vertexGuardBandOutcodes[meshFace.m_C];
+            sidePlaneScale = GUARD_BAND_SCALE;
+        }
+
+        if (isHomogeneousClipping)
+        {
+            const Vec4 clipSpaceTriangle[3] =
+            {
+                GetVec4FromStreams(clipSpaceVertices, meshFace.m_A),
+                GetVec4FromStreams(clipSpaceVertices, meshFace.m_B),
+                GetVec4FromStreams(clipSpaceVertices, meshFace.m_C),
+            };
+
+            if (planesToClip == 0)
+            {
+                // NOTE(sbalse): Completely inside the frustum, clipping wouldn't change anything.
+                trianglesAfterClipping[0].m_Points[0] = clipSpaceTriangle[0];
+                trianglesAfterClipping[0].m_Points[1] = clipSpaceTriangle[1];
+                trianglesAfterClipping[0].m_Points[2] = clipSpaceTriangle[2];
+                trianglesAfterClipping[0].m_TexCoords[0] = meshFace.m_AUV;
+                trianglesAfterClipping[0].m_TexCoords[1] = meshFace.m_BUV;
+                trianglesAfterClipping[0].m_TexCoords[2] = meshFace.m_CUV;
+                numTrianglesAfterClipping = 1;
+                if (frustumPlanesCrossed == 0)
+                {
+                    numTriviallyAccepted++;
+                }
+                else
+                {
+                    numGuardBandAccepted++;
+                }
+            }
+            else
+            {
+                HomogeneousPolygon polygon = CreateHomogeneousPolygonFromTriangle(
+                    clipSpaceTriangle[0],
+                    clipSpaceTriangle[1],
+                    clipSpaceTriangle[2],
+                    meshFace.m_AUV,
+                    meshFace.m_BUV,
+                    meshFace.m_CUV
+                );
+                ClipHomogeneousPolygon(&polygon, planesToClip, sidePlaneScale);
+                TrianglesFromHomogeneousPolygon(&polygon, trianglesAfterClipping, &numTrianglesAfterClipping);
+                numClipped++;
+            }
+        }
+        else if (planesToClip == 0)
+        {
+            // NOTE(sbalse): Completely inside the frustum, clipping wouldn't change anything.
+            trianglesAfterClipping[0].m_Points[0] = transformedVertices[0];
+            trianglesAfterClipping[0].m_Points[1] = transformedVertices[1];
+            trianglesAfterClipping[0].m_Points[2] = transformedVertices[2];
+            trianglesAfterClipping[0].m_TexCoords[0] = meshFace.m_AUV;
+            trianglesAfterClipping[0].m_TexCoords[1] = meshFace.m_BUV;
+            trianglesAfterClipping[0].m_TexCoords[2] = meshFace.m_CUV;
+            numTrianglesAfterClipping = 1;
+            numTriviallyAccepted++;
+        }
+        else
+        {
+            // NOTE(sbalse): Create a polygon to be clipped from the original transformed vertices.
+            Polygon polygon = CreatePolygonFromTriangle(
+                Vec3FromVec4(transformedVertices[0]),
+                Vec3FromVec4(transformedVertices[1]),
+                Vec3FromVec4(transformedVertices[2]),
+                meshFace.m_AUV,
+                meshFace.m_BUV,
+                meshFace.m_CUV
+            );
+
+            // NOTE(sbalse): Clip the polygon and get a new polygon with potentially new vertices.
+            ClipPolygon(&polygon, planesToClip);
+
+            // NOTE(sbalse): After clipping, we need to break the clipping polygon back into triangles.
+            TrianglesFromPolygon(&polygon, trianglesAfterClipping, &numTrianglesAfterClipping);
+            numClipped++;
+        }
 
         // NOTE(sbalse): Loop all the assembled triangles after clipping.
         for (int t = 0; t < numTrianglesAfterClipping; t++)
@@ -434,11 +776,19 @@ static void ProcessGraphicsPipelineStages(const Mesh* const mesh)
             // NOTE(sbalse): Project vertices of the face.
             for (int vertexIndex = 0; vertexIndex < 3; vertexIndex++)
             {
-                // NOTE(sbalse): Project the current vertex.
-                projectedPoints[vertexIndex] = Mat4MulVec4Project(
-                    g_ProjMatrix,
-                    triangleAfterClipping.m_Points[vertexIndex]
-                );
+                // NOTE(sbalse): Project the current vertex. Homogeneous clipping leaves it in clip space
+                // already, so it only needs the perspective divide.
+                if (isHomogeneousClipping)
+                {
+                    projectedPoints[vertexIndex] = Vec4PerspectiveDivide(triangleAfterClipping.m_Points[vertexIndex]);
+                }
+                else
+                {
+                    projectedPoints[vertexIndex] = Mat4MulVec4Project(
+                        g_ProjMatrix,
+                        triangleAfterClipping.m_Points[vertexIndex]
+                    );
+                }
 
                 // NOTE(sbalse): Invert the y values to account for our flipped y axis.
                 projectedPoints[vertexIndex].m_Y *= -1;
@@ -495,16 +845,169 @@ static void ProcessGraphicsPipelineStages(const Mesh* const mesh)
                     { triangleAfterClipping.m_TexCoords[2] },
                 },
                 .m_Color = triangleColor,
-                .m_Texture = mesh->m_Texture,
+                .m_Texture = &mesh->m_Texture,
             };
 
-            if (g_NumTrianglesToRender < MAX_NUM_TRIANGLES_TO_RENDER)
-            {
-                // NOTE(sbalse): Save the projected triangle in the array of triangles to render.
-                PushStruct(triangleToRender, g_TrianglesToRender, g_NumTrianglesToRender);
-            }
+            // NOTE(sbalse): Save the projected triangle in the chunk.
+            assert(chunk.m_NumTriangles < chunk.m_Count * MAX_NUM_POLYGON_TRIANGLES);
+            PushStruct(triangleToRender, chunk.m_Triangles, chunk.m_NumTriangles);
+        }
+    }
+
+    AddFrameCounter(FrameCounter_TrianglesTriviallyAccepted, numTriviallyAccepted);
+    AddFrameCounter(FrameCounter_TrianglesGuardBandAccepted, numGuardBandAccepted);
+    AddFrameCounter(FrameCounter_TrianglesTriviallyRejected, numTriviallyRejected);
+    AddFrameCounter(FrameCounter_TrianglesClipped, numClipped);
+}
+
+// NOTE(sbalse): Split count items into chunks of chunkSize, appended to chunks.
+static void AddGeometryChunks(
+    const GeometryMesh* const geometryMesh,
+    const size_t count,
+    const size_t chunkSize,
+    GeometryChunk* const chunks,
+    int* const numChunks)
+{
+    for (size_t first = 0; first < count; first += chunkSize)
+    {
+        chunks[*numChunks] =
+        {
+            .m_GeometryMesh = geometryMesh,
+            .m_First = first,
+            .m_Count = std::min(chunkSize, count - first),
+        };
+        (*numChunks)++;
+    }
+}
+
+// NOTE(sbalse): Process the graphics pipeline stages for all the mesh triangles.
+//
+// Model space   <-- original mesh vertices
+// |
+// |---> World space   <-- multiply by world matrix
+//      |
+//      |---> Camera space   <-- multiply by view matrix
+//          |
+//          |---> Clipping      <-- clip against the 6 frustum planes
+//                |
+//                |---> Projection   <-- multiply by projection matrix
+//                      |
+//                      |---> Image space  <-- apply perspective divide
+//                            |
+//                            |---> Screen space   <-- ready to render
+//
+// The world and view matrices are combined into a single model-view matrix, so model space goes
+// straight to camera space with one matrix multiplication per vertex. The vertices are kept in x, y and z
+// streams (see vertexkernels.h) so the transform handles 8 of them per AVX instruction.
+//
+// Both the vertex transform and the triangle assembly are spread over the thread pool in chunks. Every face
+// chunk writes the triangles it assembles to its own part of a frame array, and the chunks are merged into
+// the triangles to render in chunk order. Chunks follow the meshes in meshDrawOrder and the faces of each
+// mesh in file order, so the triangles come out in the same order no matter which thread processed which
+// chunk.
+//
+static void ProcessGraphicsPipelineStages(Arena* const frameArena, const int* const meshDrawOrder)
+{
+    PROFILE_EVENT_SCOPED_BEGIN(_, "ProcessGraphicsPipelineStages");
+
+    const int numOfMeshes = GetNumOfMeshes();
+    GeometryMesh* const geometryMeshes = PushArray(frameArena, GeometryMesh, numOfMeshes);
+
+    size_t numVertexChunks = 0;
+    size_t numFaceChunks = 0;
+    for (int i = 0; i < numOfMeshes; i++)
+    {
+        Mesh* const mesh = GetMesh(meshDrawOrder[i]);
+
+        // NOTE(sbalse): Combine the world and view matrices so that each vertex only needs a single matrix
+        // multiplication to get from model space to camera space. The world matrix is cached in the mesh
+        // and the view matrix is set up once per frame.
+        geometryMeshes[i].m_Mesh = mesh;
+        geometryMeshes[i].m_ModelViewMatrix = Mat4MulMat4(g_ViewMatrix, GetMeshWorldMatrix(mesh));
+        geometryMeshes[i].m_ModelViewProjectionMatrix = Mat4MulMat4(g_ProjMatrix, geometryMeshes[i].m_ModelViewMatrix);
+        geometryMeshes[i].m_CameraSpaceVertices = PushVec3Streams(frameArena, mesh->m_VerticesCount);
+        if (GetClippingMethod() != ClippingMethod::CameraSpace)
+        {
+            geometryMeshes[i].m_ClipSpaceVertices = PushVec4Streams(frameArena, mesh->m_VerticesCount);
+        }
+        if (GetClippingMethod() == ClippingMethod::GuardBand)
+        {
+            geometryMeshes[i].m_VertexGuardBandOutcodes = PushArray(frameArena, u8, mesh->m_VerticesCount);
         }
+        geometryMeshes[i].m_VertexOutcodes = PushArray(frameArena, u8, mesh->m_VerticesCount);
+
+        numVertexChunks += (mesh->m_VerticesCount + GEOMETRY_VERTEX_CHUNK_SIZE - 1) / GEOMETRY_VERTEX_CHUNK_SIZE;
+        numFaceChunks += (mesh->m_FacesCount + GEOMETRY_FACE_CHUNK_SIZE - 1) / GEOMETRY_FACE_CHUNK_SIZE;
+    }
+
+    GeometryChunk* const vertexChunks = PushArray(frameArena, GeometryChunk, numVertexChunks);
+    GeometryChunk* const faceChunks = PushArray(frameArena, GeometryChunk, numFaceChunks);
+    int numAddedVertexChunks = 0;
+    int numAddedFaceChunks = 0;
+    for (int i = 0; i < numOfMeshes; i++)
+    {
+        const Mesh* const mesh = geometryMeshes[i].m_Mesh;
+        AddGeometryChunks(&geometryMeshes[i], mesh->m_VerticesCount, GEOMETRY_VERTEX_CHUNK_SIZE, vertexChunks, &numAddedVertexChunks);
+        AddGeometryChunks(&geometryMeshes[i], mesh->m_FacesCount, GEOMETRY_FACE_CHUNK_SIZE, faceChunks, &numAddedFaceChunks);
+    }
+
+    // NOTE(sbalse): Give every face chunk room for the most triangles its faces can be clipped into.
+    size_t numFrameFaces = 0;
+    for (int chunkIndex = 0; chunkIndex < numAddedFaceChunks; chunkIndex++)
+    {
+        numFrameFaces += faceChunks[chunkIndex].m_Count;
+    }
+    Triangle* chunkTriangles = PushArray(frameArena, Triangle, numFrameFaces * MAX_NUM_POLYGON_TRIANGLES);
+    for (int chunkIndex = 0; chunkIndex < numAddedFaceChunks; chunkIndex++)
+    {
+        faceChunks[chunkIndex].m_Triangles = chunkTriangles;
+        chunkTriangles += faceChunks[chunkIndex].m_Count * MAX_NUM_POLYGON_TRIANGLES;
+    }
+
+    const StatsTimestamp transformStart = GetStatsTimestamp();
+    ThreadPoolParallelFor(numAddedVertexChunks, TransformVertexChunk, vertexChunks);
+    AddFrameStageTime(FrameStage_Transform, transformStart);
+
+    const StatsTimestamp clipStart = GetStatsTimestamp();
+
+    ThreadPoolParallelFor(numAddedFaceChunks, AssembleFaceChunk, faceChunks);
+
+    // NOTE(sbalse): Merge the chunks in chunk order. When there are more triangles than fit, the ones of the
+    // last chunks are dropped.
+    for (int chunkIndex = 0; chunkIndex < numAddedFaceChunks; chunkIndex++)
+    {
+        const GeometryChunk& chunk = faceChunks[chunkIndex];
+        const size_t numTriangles = std::min(chunk.m_NumTriangles, MAX_NUM_TRIANGLES_TO_RENDER - g_NumTrianglesToRender);
+        std::memcpy(g_TrianglesToRender + g_NumTrianglesToRender, chunk.m_Triangles, numTriangles * sizeof(Triangle));
+        g_NumTrianglesToRender += numTriangles;
     }
+
+    AddFrameStageTime(FrameStage_Clip, clipStart);
+}
+
+// NOTE(sbalse): The mesh indices sorted front to back by the camera space depth of the mesh origins. The
+// triangles are rasterized in the order they are submitted, so submitting the near meshes first lets the
+// depth test kill the hidden pixels of the far ones before they're shaded. Allocated in the frame arena.
+static int* GetFrontToBackMeshOrder(Arena* frameArena)
+{
+    const int numOfMeshes = GetNumOfMeshes();
+    int* const meshOrder = PushArray(frameArena, int, numOfMeshes);
+    float* const meshDepths = PushArray(frameArena, float, numOfMeshes);
+
+    for (int meshIndex = 0; meshIndex < numOfMeshes; meshIndex++)
+    {
+        const Vec4 origin = Vec4FromVec3(GetMesh(meshIndex)->m_Translation);
+        meshOrder[meshIndex] = meshIndex;
+        meshDepths[meshIndex] = Mat4MulVec4(g_ViewMatrix, origin).m_Z;
+    }
+
+    // NOTE(sbalse): Stable so meshes at the same depth keep their load order and frames stay reproducible.
+    std::stable_sort(meshOrder, meshOrder + numOfMeshes, [meshDepths](const int a, const int b)
+    {
+        return meshDepths[a] < meshDepths[b];
+    });
+
+    return meshOrder;
 }
 
 static void Update(Arena* frameArena, const float deltaTime)
@@ -518,166 +1021,585 @@ static void Update(Arena* frameArena, const float deltaTime)
 
     // NOTE(sbalse): Clear the list of triangles to render every frame loop.
     ArenaFree(frameArena);
+    ResetThreadFrameArenas();
     g_NumTrianglesToRender = 0;
 
-    const int numOfMeshes = GetNumOfMeshes();
+    // NOTE(sbalse): The camera doesn't move between meshes so set up the view matrix once per frame.
+    SetupCameraView();
 
-    // NOTE(sbalse): Loop over all the meshes in our scene.
-    for (int meshIndex = 0; meshIndex < numOfMeshes; meshIndex++)
+    const int* const meshDrawOrder = GetFrontToBackMeshOrder(frameArena);
+    ProcessGraphicsPipelineStages(frameArena, meshDrawOrder);
+
+    if (GetTriangleSortMethod() == TriangleSortMethod::FrontToBack)
     {
-        const Mesh* const currentMesh = GetMesh(meshIndex);
+        const StatsTimestamp sortStart = GetStatsTimestamp();
+        SortTrianglesFrontToBack(frameArena, g_TrianglesToRender, g_NumTrianglesToRender);
+        AddFrameStageTime(FrameStage_Sort, sortStart);
+    }
+
+    SetFrameTriangleCount(g_NumTrianglesToRender);
+}
+
+static void Render(Arena* frameArena)
+{
+    PROFILE_EVENT();
+
+    const StatsTimestamp clearStart = GetStatsTimestamp();
+    ClearFrameBuffers(BLACK);
+    AddFrameStageTime(FrameStage_Clear, clearStart);
+
+    const StatsTimestamp rasterStart = GetStatsTimestamp();
+    if (g_DisplayGrid)
+    {
+        DrawGrid();
+    }
 
-        if (!g_Paused)
+    {
+        PROFILE_EVENT_SCOPED_BEGIN(drawTrianglesProfileZone, "Draw Many Triangles");
+
+        RasterizeTriangles(frameArena, g_TrianglesToRender, g_NumTrianglesToRender);
+    }
+    AddFrameStageTime(FrameStage_Raster, rasterStart);
+
+    if (IsRecordingStats())
+    {
+        AddFrameCounter(FrameCounter_PixelsCovered, CountCoveredPixels());
+    }
+
+    const StatsTimestamp presentStart = GetStatsTimestamp();
+    const RenderBufferMethod currentRenderBufferMethod = GetRenderBufferMethod();
+    if (currentRenderBufferMethod == RenderBufferMethod::ColorBuffer)
+    {
+        RenderColorBuffer();
+    }
+    else if (currentRenderBufferMethod == RenderBufferMethod::ZBuffer)
+    {
+        RenderZBuffer();
+    }
+    AddFrameStageTime(FrameStage_Present, presentStart);
+}
+
+// NOTE(sbalse): Get the thread count from the "--threads <count>" command line argument. Returns 0 when
+// it's not passed which makes the thread pool use all the hardware threads.
+static int ParseThreadCount(int argc, char* argv[])
+{
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (std::strcmp(argv[i], "--threads") == 0)
         {
-            // NOTE(sbalse): Will need to remove the const from currentMesh before uncommenting the following code.
-            // currentMesh->m_Rotation.m_X += 0.6f * deltaTime;
-            // currentMesh->m_Rotation.m_Y += 0.6f * deltaTime;
-            // currentMesh->m_Rotation.m_Z += 0.6f * deltaTime;
+            return std::atoi(argv[i + 1]);
+        }
+    }
 
-            // currentMesh->m_Scale.m_X += 0.2 * deltaTime;
-            // currentMesh->m_Scale.m_Y += 0.2 * deltaTime;
-            // currentMesh->m_Scale.m_Z += 0.2 * deltaTime;
+    return 0;
+}
 
-            // currentMesh->m_Translation.m_X += 0.6 * deltaTime;
+// NOTE(sbalse): Get the directory from the "--bench-obj [directory]" command line argument. Returns nullptr
+// when it's not passed, which means the renderer runs normally.
+static const char* ParseObjBenchmarkDirectory(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--bench-obj") == 0)
+        {
+            const bool hasDirectory = (i + 1 < argc) && (std::strncmp(argv[i + 1], "--", 2) != 0);
+            return hasDirectory ? argv[i + 1] : "assets";
         }
+    }
+
+    return nullptr;
+}
 
-        ProcessGraphicsPipelineStages(currentMesh);
+// NOTE(sbalse): Get the element count from the "--bench-math [count]" command line argument. Returns 0 when
+// it's not passed, which means the renderer runs normally.
+static size_t ParseMathBenchmarkCount(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--bench-math") == 0)
+        {
+            constexpr size_t DEFAULT_MATH_BENCHMARK_COUNT = 100000;
+            const int count = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            return (count > 0) ? scast<size_t>(count) : DEFAULT_MATH_BENCHMARK_COUNT;
+        }
     }
+
+    return 0;
 }
 
-static void Render()
+// NOTE(sbalse): Get the frame count from the "--headless <frames>" command line argument. Returns 0 when
+// it's not passed, which means the renderer opens a window as usual.
+static int ParseHeadlessFrameCount(int argc, char* argv[])
 {
-    PROFILE_EVENT();
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            constexpr int DEFAULT_HEADLESS_FRAME_COUNT = 300;
+            const int frameCount = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            return (frameCount > 0) ? frameCount : DEFAULT_HEADLESS_FRAME_COUNT;
+        }
+    }
 
-    ClearColorBuffer(BLACK);
-    ClearZBuffer();
+    return 0;
+}
 
-    if (g_DisplayGrid)
+// NOTE(sbalse): Get the layout of the texels of the mesh textures from the "--texture-layout <linear|morton>"
+// command line argument. The textures are built once at load time, so unlike the options applied in
+// ApplyRenderOptionArguments() it has to be known before Setup().
+static TextureLayout ParseTextureLayout(int argc, char* argv[])
+{
+    for (int i = 1; i < argc - 1; i++)
     {
-        DrawGrid();
+        if (std::strcmp(argv[i], "--texture-layout") == 0)
+        {
+            if (std::strcmp(argv[i + 1], "morton") == 0)
+            {
+                return TextureLayout::Morton;
+            }
+            if (std::strcmp(argv[i + 1], "linear") != 0)
+            {
+                LOG_ERROR("Unknown texture layout: %s.", argv[i + 1]);
+            }
+        }
     }
 
+    return TextureLayout::Linear;
+}
+
+// NOTE(sbalse): Get the frame count from the "--bench-mip [frames]" command line argument. Returns 0 when it's
+// not passed, which means the renderer runs normally.
+static int ParseMipBenchmarkFrameCount(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
     {
-        PROFILE_EVENT_SCOPED_BEGIN(drawTrianglesProfileZone, "Draw Many Triangles");
+        if (std::strcmp(argv[i], "--bench-mip") == 0)
+        {
+            constexpr int DEFAULT_MIP_BENCHMARK_FRAME_COUNT = 30;
+            const int frameCount = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            return (frameCount > 0) ? frameCount : DEFAULT_MIP_BENCHMARK_FRAME_COUNT;
+        }
+    }
 
-        // NOTE(sbalse): Loop all projected triangles and render them.
-        for (int currentTriangleIndex = 0;
-            currentTriangleIndex < g_NumTrianglesToRender;
-            currentTriangleIndex++)
-        {
-            const Triangle& currentTriangle = g_TrianglesToRender[currentTriangleIndex];
-
-            const RenderMethod currentRenderMethod = GetRenderMethod();
-            if (currentRenderMethod == RenderMethod::FillTriangle
-                || currentRenderMethod == RenderMethod::FillTriangleWire)
-            {
-                // NOTE(sbalse): Draw mesh face triangles.
-                DrawFilledTriangle(
-                    // NOTE(sbalse): vertex A.
-                    scast<int>(currentTriangle.m_Points[0].m_X),
-                    scast<int>(currentTriangle.m_Points[0].m_Y),
-                    currentTriangle.m_Points[0].m_Z,
-                    currentTriangle.m_Points[0].m_W,
-                    // NOTE(sbalse): vertex B.
-                    scast<int>(currentTriangle.m_Points[1].m_X),
-                    scast<int>(currentTriangle.m_Points[1].m_Y),
-                    currentTriangle.m_Points[1].m_Z,
-                    currentTriangle.m_Points[1].m_W,
-                    // NOTE(sbalse): vertex C.
-                    scast<int>(currentTriangle.m_Points[2].m_X),
-                    scast<int>(currentTriangle.m_Points[2].m_Y),
-                    currentTriangle.m_Points[2].m_Z,
-                    currentTriangle.m_Points[2].m_W,
-                    // NOTE(sbalse): The color.
-                    currentTriangle.m_Color
-                );
-            }
+    return 0;
+}
 
-            if (currentRenderMethod == RenderMethod::WireVertex)
+// NOTE(sbalse): Get the frame count from the "--bench-filter [frames]" command line argument. Returns 0 when it's
+// not passed, which means the renderer runs normally.
+static int ParseFilterBenchmarkFrameCount(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--bench-filter") == 0)
+        {
+            constexpr int DEFAULT_FILTER_BENCHMARK_FRAME_COUNT = 120;
+            const int frameCount = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            return (frameCount > 0) ? frameCount : DEFAULT_FILTER_BENCHMARK_FRAME_COUNT;
+        }
+    }
+
+    return 0;
+}
+
+// NOTE(sbalse): Get the frame count from the "--bench-clip [frames]" command line argument. Returns 0 when
+// the argument isn't there.
+static int ParseClippingBenchmarkFrameCount(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--bench-clip") == 0)
+        {
+            constexpr int DEFAULT_CLIPPING_BENCHMARK_FRAME_COUNT = 300;
+            const int frameCount = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            return (frameCount > 0) ? frameCount : DEFAULT_CLIPPING_BENCHMARK_FRAME_COUNT;
+        }
+    }
+
+    return 0;
+}
+
+// NOTE(sbalse): Get the file name from the "--stats-out <file>" command line argument.
+static const char* ParseStatsFileName(int argc, char* argv[])
+{
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (std::strcmp(argv[i], "--stats-out") == 0)
+        {
+            return argv[i + 1];
+        }
+    }
+
+    return "frame_stats.csv";
+}
+
+// NOTE(sbalse): Apply the "--triangle-sort <none|front-to-back>", "--depth-prepass",
+// "--depth-clear <full|epoch>", "--mip-level <none|triangle|pixel>", "--texture-filter <nearest|bilinear>"
+// and "--clipping <camera|homogeneous|guard-band>" command line arguments. They override the defaults set in Setup().
+static void ApplyRenderOptionArguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--triangle-sort") == 0 && i + 1 < argc)
+        {
+            if (std::strcmp(argv[i + 1], "none") == 0)
             {
-                // NOTE(sbalse): Draw the cube corner vertices.
-                DrawRectangle(
-                    scast<int>(currentTriangle.m_Points[0].m_X - 3),
-                    scast<int>(currentTriangle.m_Points[0].m_Y - 3),
-                    6,
-                    6,
-                    RED
-                );
-                DrawRectangle(
-                    scast<int>(currentTriangle.m_Points[1].m_X - 3),
-                    scast<int>(currentTriangle.m_Points[1].m_Y - 3),
-                    6,
-                    6,
-                    RED
-                );
-                DrawRectangle(
-                    scast<int>(currentTriangle.m_Points[2].m_X - 3),
-                    scast<int>(currentTriangle.m_Points[2].m_Y - 3),
-                    6,
-                    6,
-                    RED
-                );
+                SetTriangleSortMethod(TriangleSortMethod::None);
+            }
+            else if (std::strcmp(argv[i + 1], "front-to-back") == 0)
+            {
+                SetTriangleSortMethod(TriangleSortMethod::FrontToBack);
+            }
+            else
+            {
+                LOG_ERROR("Unknown triangle sort method: %s.", argv[i + 1]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--depth-prepass") == 0)
+        {
+            SetDepthPrepassMethod(DepthPrepassMethod::DepthOnly);
+        }
+        else if (std::strcmp(argv[i], "--depth-clear") == 0 && i + 1 < argc)
+        {
+            if (std::strcmp(argv[i + 1], "full") == 0)
+            {
+                SetDepthClearMethod(DepthClearMethod::Full);
+            }
+            else if (std::strcmp(argv[i + 1], "epoch") == 0)
+            {
+                SetDepthClearMethod(DepthClearMethod::EpochTagged);
+            }
+            else
+            {
+                LOG_ERROR("Unknown depth clear method: %s.", argv[i + 1]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--mip-level") == 0 && i + 1 < argc)
+        {
+            if (std::strcmp(argv[i + 1], "none") == 0)
+            {
+                SetMipLevelMethod(MipLevelMethod::None);
+            }
+            else if (std::strcmp(argv[i + 1], "triangle") == 0)
+            {
+                SetMipLevelMethod(MipLevelMethod::PerTriangle);
+            }
+            else if (std::strcmp(argv[i + 1], "pixel") == 0)
+            {
+                SetMipLevelMethod(MipLevelMethod::PerPixel);
+            }
+            else
+            {
+                LOG_ERROR("Unknown mip level method: %s.", argv[i + 1]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--texture-filter") == 0 && i + 1 < argc)
+        {
+            if (std::strcmp(argv[i + 1], "nearest") == 0)
+            {
+                SetTextureFilterMethod(TextureFilterMethod::Nearest);
+            }
+            else if (std::strcmp(argv[i + 1], "bilinear") == 0)
+            {
+                SetTextureFilterMethod(TextureFilterMethod::Bilinear);
             }
+            else
+            {
+                LOG_ERROR("Unknown texture filter method: %s.", argv[i + 1]);
+            }
+        }
+        else if (std::strcmp(argv[i], "--clipping") == 0 && i + 1 < argc)
+        {
+            if (std::strcmp(argv[i + 1], "camera") == 0)
+            {
+                SetClippingMethod(ClippingMethod::CameraSpace);
+            }
+            else if (std::strcmp(argv[i + 1], "homogeneous") == 0)
+            {
+                SetClippingMethod(ClippingMethod::Homogeneous);
+            }
+            else if (std::strcmp(argv[i + 1], "guard-band") == 0)
+            {
+                SetClippingMethod(ClippingMethod::GuardBand);
+            }
+            else
+            {
+                LOG_ERROR("Unknown clipping method: %s.", argv[i + 1]);
+            }
+        }
+    }
+}
 
-            // NOTE(sbalse): Draw textured triangle.
-            if (currentRenderMethod == RenderMethod::Textured
-                || currentRenderMethod == RenderMethod::WireTextured)
-            {
-                DrawTexturedTriangle(
-                    // NOTE(sbalse): vertex A.
-                    scast<int>(currentTriangle.m_Points[0].m_X),
-                    scast<int>(currentTriangle.m_Points[0].m_Y),
-                    currentTriangle.m_Points[0].m_Z,
-                    currentTriangle.m_Points[0].m_W,
-                    currentTriangle.m_TexCoords[0].m_U,
-                    currentTriangle.m_TexCoords[0].m_V,
-                    // NOTE(sbalse): vertex B.
-                    scast<int>(currentTriangle.m_Points[1].m_X),
-                    scast<int>(currentTriangle.m_Points[1].m_Y),
-                    currentTriangle.m_Points[1].m_Z,
-                    currentTriangle.m_Points[1].m_W,
-                    currentTriangle.m_TexCoords[1].m_U,
-                    currentTriangle.m_TexCoords[1].m_V,
-                    // NOTE(sbalse): vertex C.
-                    scast<int>(currentTriangle.m_Points[2].m_X),
-                    scast<int>(currentTriangle.m_Points[2].m_Y),
-                    currentTriangle.m_Points[2].m_Z,
-                    currentTriangle.m_Points[2].m_W,
-                    currentTriangle.m_TexCoords[2].m_U,
-                    currentTriangle.m_TexCoords[2].m_V,
-                    // NOTE(sbalse): The texture.
-                    currentTriangle.m_Texture
-                );
+// NOTE(sbalse): Render frameCount frames as fast as possible without a window, with the camera moving
+// along the scripted camera path. Every run renders exactly the same frames, so the stage timings of
+// different runs, builds and machines can be compared.
+static void RunHeadless(Arena* const frameArena, Arena* const persistentArena, const int frameCount)
+{
+    BeginStatsRecording(persistentArena, frameCount);
+
+    LOG_INFO(
+        "Triangle sort: %s, depth pre-pass: %s, depth clear: %s, mip level: %s, texture filter: %s, clipping: %s.",
+        (GetTriangleSortMethod() == TriangleSortMethod::FrontToBack) ? "front to back" : "none",
+        (GetDepthPrepassMethod() == DepthPrepassMethod::DepthOnly) ? "on" : "off",
+        (GetDepthClearMethod() == DepthClearMethod::EpochTagged) ? "epoch tagged" : "full",
+        GetMipLevelMethodName(GetMipLevelMethod()),
+        GetTextureFilterMethodName(GetTextureFilterMethod()),
+        GetClippingMethodName(GetClippingMethod())
+    );
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frameCount; frame++)
+    {
+        const float t = (frameCount > 1) ? (scast<float>(frame) / scast<float>(frameCount - 1)) : 0.0f;
+        MoveCameraAlongPath(t);
+
+        Update(frameArena, FIXED_UPDATE_TIMESTEP);
+        Render(frameArena);
+
+        EndFrameStats();
+
+        PROFILE_FRAME();
+    }
+
+    const std::chrono::duration<double, std::milli> totalTime = std::chrono::steady_clock::now() - startTime;
+    LOG_INFO(
+        "Rendered %d headless frames in %.1f ms. Last frame hash: %016llx.",
+        frameCount,
+        totalTime.count(),
+        scast<unsigned long long>(GetColorBufferHash())
+    );
+    LogRecordedStatsSummary();
+}
+
+// NOTE(sbalse): Caches of a typical desktop CPU core that the texel fetches of the mip benchmark go through.
+constinit static CacheModel g_TexelL1Cache = {};
+constinit static CacheModel g_TexelL2Cache = {};
+
+static void RecordTexelFetch(const void* const texel)
+{
+    if (!AccessCacheModel(&g_TexelL1Cache, texel))
+    {
+        AccessCacheModel(&g_TexelL2Cache, texel);
+    }
+}
+
+// NOTE(sbalse): Fly the camera away from the scene and compare the mip level methods at each distance. The
+// frame time comes from rendering frameCount frames with the current settings. The cache misses come from
+// one more frame drawn serially with the scalar kernels, whose texel fetches are fed to the cache models.
+static void RunMipBenchmark(Arena* const frameArena, Arena* const persistentArena, const int frameCount)
+{
+    constexpr size_t L1_CACHE_SIZE = KILOBYTES(32);
+    constexpr size_t L2_CACHE_SIZE = MEGABYTES(1);
+    CreateCacheModel(persistentArena, &g_TexelL1Cache, L1_CACHE_SIZE, 8);
+    CreateCacheModel(persistentArena, &g_TexelL2Cache, L2_CACHE_SIZE, 16);
+
+    constexpr MipLevelMethod METHODS[] = { MipLevelMethod::None, MipLevelMethod::PerTriangle, MipLevelMethod::PerPixel };
+    constexpr int NUM_METHODS = scast<int>(sizeof(METHODS) / sizeof(METHODS[0]));
+    constexpr int NUM_DISTANCES = 7;
+    constexpr float DISTANCE_STEP = 2.0f;
+
+    const RasterizerMethod rasterizerMethod = GetRasterizerMethod();
+    const PixelKernelMethod pixelKernelMethod = GetPixelKernelMethod();
+
+    double totalFrameMs[NUM_METHODS] = {};
+    u64 totalL1Misses[NUM_METHODS] = {};
+    u64 totalL2Misses[NUM_METHODS] = {};
+
+    LOG_INFO("Benchmarking the mip level methods over %d frames per distance...", frameCount);
+
+    for (int distanceIndex = 0; distanceIndex < NUM_DISTANCES; distanceIndex++)
+    {
+        const float distance = scast<float>(distanceIndex) * DISTANCE_STEP;
+        UpdateCameraPosition(Vec3{ 0.0f, 0.0f, -distance });
+
+        for (int methodIndex = 0; methodIndex < NUM_METHODS; methodIndex++)
+        {
+            SetMipLevelMethod(METHODS[methodIndex]);
+
+            const auto startTime = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frameCount; frame++)
+            {
+                Update(frameArena, FIXED_UPDATE_TIMESTEP);
+                Render(frameArena);
+                EndFrameStats();
             }
+            const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - startTime;
+            const double frameMs = time.count() / frameCount;
+
+            ResetCacheModel(&g_TexelL1Cache);
+            ResetCacheModel(&g_TexelL2Cache);
+            SetRasterizerMethod(RasterizerMethod::Serial);
+            SetPixelKernelMethod(PixelKernelMethod::Scalar);
+            SetTexelFetchCallback(RecordTexelFetch);
+
+            Update(frameArena, FIXED_UPDATE_TIMESTEP);
+            Render(frameArena);
+            EndFrameStats();
+
+            SetTexelFetchCallback(nullptr);
+            SetRasterizerMethod(rasterizerMethod);
+            SetPixelKernelMethod(pixelKernelMethod);
+
+            const u64 numFetches = g_TexelL1Cache.m_NumAccesses;
+            LOG_INFO(
+                "Distance %5.1f, %-11s %7.3f ms per frame, %8llu texel fetches, %7llu L1 misses (%4.1f%%), %6llu L2 misses.",
+                distance,
+                GetMipLevelMethodName(METHODS[methodIndex]),
+                frameMs,
+                scast<unsigned long long>(numFetches),
+                scast<unsigned long long>(g_TexelL1Cache.m_NumMisses),
+                (numFetches > 0) ? (100.0 * scast<double>(g_TexelL1Cache.m_NumMisses) / scast<double>(numFetches)) : 0.0,
+                scast<unsigned long long>(g_TexelL2Cache.m_NumMisses)
+            );
+
+            totalFrameMs[methodIndex] += frameMs;
+            totalL1Misses[methodIndex] += g_TexelL1Cache.m_NumMisses;
+            totalL2Misses[methodIndex] += g_TexelL2Cache.m_NumMisses;
+        }
+    }
 
-            if (currentRenderMethod == RenderMethod::Wire
-                || currentRenderMethod == RenderMethod::WireVertex
-                || currentRenderMethod == RenderMethod::FillTriangleWire
-                || currentRenderMethod == RenderMethod::WireTextured)
-            {
-                // NOTE(sbalse): Draw mesh wireframe triangles.
-                DrawTriangle(
-                    scast<int>(currentTriangle.m_Points[0].m_X),
-                    scast<int>(currentTriangle.m_Points[0].m_Y),
-                    scast<int>(currentTriangle.m_Points[1].m_X),
-                    scast<int>(currentTriangle.m_Points[1].m_Y),
-                    scast<int>(currentTriangle.m_Points[2].m_X),
-                    scast<int>(currentTriangle.m_Points[2].m_Y),
-                    WHITE
-                );
+    // NOTE(sbalse): Everything relative to always sampling the full size level.
+    for (int methodIndex = 0; methodIndex < NUM_METHODS; methodIndex++)
+    {
+        LOG_INFO(
+            "%-11s %7.3f ms per frame (%+.1f%%), %.1f%% of the L1 misses and %.1f%% of the L2 misses of None.",
+            GetMipLevelMethodName(METHODS[methodIndex]),
+            totalFrameMs[methodIndex] / NUM_DISTANCES,
+            100.0 * ((totalFrameMs[methodIndex] / totalFrameMs[0]) - 1.0),
+            100.0 * scast<double>(totalL1Misses[methodIndex]) / scast<double>(std::max<u64>(totalL1Misses[0], 1)),
+            100.0 * scast<double>(totalL2Misses[methodIndex]) / scast<double>(std::max<u64>(totalL2Misses[0], 1))
+        );
+    }
+}
+
+// NOTE(sbalse): Compare the cost of a shaded pixel with each texture filter, for every pixel kernel this CPU
+// supports. Each combination draws the same frameCount frames along the scripted camera path with the serial
+// rasterizer, so the raster time divided by the shaded pixels is the cost of a pixel on one thread.
+static void RunTextureFilterBenchmark(Arena* const frameArena, const int frameCount)
+{
+    constexpr PixelKernelMethod KERNELS[] = { PixelKernelMethod::Scalar, PixelKernelMethod::SSE2, PixelKernelMethod::AVX2 };
+    constexpr TextureFilterMethod FILTERS[] = { TextureFilterMethod::Nearest, TextureFilterMethod::Bilinear };
+    constexpr int NUM_FILTERS = scast<int>(sizeof(FILTERS) / sizeof(FILTERS[0]));
+
+    const RasterizerMethod rasterizerMethod = GetRasterizerMethod();
+    const PixelKernelMethod pixelKernelMethod = GetPixelKernelMethod();
+    const TextureFilterMethod textureFilterMethod = GetTextureFilterMethod();
+    SetRasterizerMethod(RasterizerMethod::Serial);
+
+    LOG_INFO("Benchmarking the texture filters over %d frames per pixel kernel...", frameCount);
+
+    for (const PixelKernelMethod kernel : KERNELS)
+    {
+        if (!IsPixelKernelMethodSupported(kernel))
+        {
+            continue;
+        }
+        SetPixelKernelMethod(kernel);
+
+        double nanosecondsPerPixel[NUM_FILTERS] = {};
+        for (int filterIndex = 0; filterIndex < NUM_FILTERS; filterIndex++)
+        {
+            SetTextureFilterMethod(FILTERS[filterIndex]);
+
+            double rasterMs = 0.0;
+            u64 numShaded = 0;
+            for (int frame = 0; frame < frameCount; frame++)
+            {
+                const float t = (frameCount > 1) ? (scast<float>(frame) / scast<float>(frameCount - 1)) : 0.0f;
+                MoveCameraAlongPath(t);
+
+                Update(frameArena, FIXED_UPDATE_TIMESTEP);
+                Render(frameArena);
+                EndFrameStats();
+
+                rasterMs += GetLastFrameStageMs(FrameStage_Raster);
+                numShaded += GetLastFrameCounter(FrameCounter_PixelsShaded);
             }
+
+            nanosecondsPerPixel[filterIndex] = (numShaded > 0) ? ((rasterMs * 1000000.0) / scast<double>(numShaded)) : 0.0;
+            LOG_INFO(
+                "%-6s %-8s %8.3f ms raster per frame, %9llu shaded pixels per frame, %6.2f ns per shaded pixel.",
+                GetPixelKernelMethodName(kernel),
+                GetTextureFilterMethodName(FILTERS[filterIndex]),
+                rasterMs / frameCount,
+                scast<unsigned long long>(numShaded / frameCount),
+                nanosecondsPerPixel[filterIndex]
+            );
         }
+
+        // NOTE(sbalse): The raster time of both filters includes the same triangle setup and depth testing, so
+        // the difference is what the bilinear sampler costs on top of the nearest one.
+        LOG_INFO(
+            "%-6s Bilinear costs %+.2f ns (%+.1f%%) per shaded pixel over Nearest.",
+            GetPixelKernelMethodName(kernel),
+            nanosecondsPerPixel[1] - nanosecondsPerPixel[0],
+            (nanosecondsPerPixel[0] > 0.0) ? (100.0 * ((nanosecondsPerPixel[1] / nanosecondsPerPixel[0]) - 1.0)) : 0.0
+        );
     }
 
-    const RenderBufferMethod currentRenderBufferMethod = GetRenderBufferMethod();
-    if (currentRenderBufferMethod == RenderBufferMethod::ColorBuffer)
+    SetRasterizerMethod(rasterizerMethod);
+    SetPixelKernelMethod(pixelKernelMethod);
+    SetTextureFilterMethod(textureFilterMethod);
+}
+
+// NOTE(sbalse): Run the geometry stage of frameCount frames along the camera path with each clipping method
+// on a single thread and log the transform and clip time per frame. Nothing is drawn. The methods take turns
+// over several rounds and the fastest round of each is kept, so that both see the same machine noise.
+static void RunClippingBenchmark(Arena* const frameArena, const int frameCount)
+{
+    constexpr ClippingMethod METHODS[] = { ClippingMethod::CameraSpace, ClippingMethod::Homogeneous, ClippingMethod::GuardBand };
+    constexpr int NUM_METHODS = scast<int>(sizeof(METHODS) / sizeof(METHODS[0]));
+    constexpr int NUM_ROUNDS = 5;
+
+    const ClippingMethod clippingMethod = GetClippingMethod();
+    const int threadCount = GetThreadPoolThreadCount();
+    SetThreadPoolThreadCount(1);
+
+    LOG_INFO("Benchmarking the clipping methods over %d frames, best of %d rounds...", frameCount, NUM_ROUNDS);
+
+    double bestMs[NUM_METHODS] = {};
+    size_t numTriangles[NUM_METHODS] = {};
+    for (int round = 0; round < NUM_ROUNDS; round++)
     {
-        RenderColorBuffer();
+        for (int methodIndex = 0; methodIndex < NUM_METHODS; methodIndex++)
+        {
+            SetClippingMethod(METHODS[methodIndex]);
+
+            double geometryMs = 0.0;
+            numTriangles[methodIndex] = 0;
+            for (int frame = 0; frame < frameCount; frame++)
+            {
+                const float t = (frameCount > 1) ? (scast<float>(frame) / scast<float>(frameCount - 1)) : 0.0f;
+                MoveCameraAlongPath(t);
+
+                Update(frameArena, FIXED_UPDATE_TIMESTEP);
+                EndFrameStats();
+
+                geometryMs += GetLastFrameStageMs(FrameStage_Transform) + GetLastFrameStageMs(FrameStage_Clip);
+                numTriangles[methodIndex] += g_NumTrianglesToRender;
+            }
+
+            if (round == 0 || geometryMs < bestMs[methodIndex])
+            {
+                bestMs[methodIndex] = geometryMs;
+            }
+        }
     }
-    else if (currentRenderBufferMethod == RenderBufferMethod::ZBuffer)
+
+    // NOTE(sbalse): Compared to the first method, camera space clipping.
+    for (int methodIndex = 0; methodIndex < NUM_METHODS; methodIndex++)
     {
-        RenderZBuffer();
+        LOG_INFO(
+            "%-11s %8.4f ms transform and clip per frame (%+6.1f%%), %6zu triangles per frame.",
+            GetClippingMethodName(METHODS[methodIndex]),
+            bestMs[methodIndex] / frameCount,
+            (bestMs[0] > 0.0) ? (100.0 * ((bestMs[methodIndex] / bestMs[0]) - 1.0)) : 0.0,
+            numTriangles[methodIndex] / frameCount
+        );
     }
+
+    SetClippingMethod(clippingMethod);
+    SetThreadPoolThreadCount(threadCount);
 }
 
 // NOTE(sbalse): Free the memory that was dynamically allocated by the program.
@@ -705,6 +1627,72 @@ int main(int argc, char* argv[])
     ArenaCreateHeap(&frameArena, MEGABYTES(32));
     assert(frameArena.m_Buf && "ERROR: Failed to create a frame arena.");
 
+    // NOTE(sbalse): Every thread of the pool gets its own small frame arena, so jobs can allocate without
+    // fighting over the main one.
+    InitThreadPool(&persistentArena, ParseThreadCount(argc, argv), KILOBYTES(64));
+
+    const char* const objBenchmarkDirectory = ParseObjBenchmarkDirectory(argc, argv);
+    if (objBenchmarkDirectory)
+    {
+        RunObjBenchmark(&persistentArena, objBenchmarkDirectory);
+        DestroyThreadPool();
+        return EXIT_SUCCESS;
+    }
+
+    const size_t mathBenchmarkCount = ParseMathBenchmarkCount(argc, argv);
+    if (mathBenchmarkCount > 0)
+    {
+        RunMathBenchmark(&persistentArena, mathBenchmarkCount);
+        DestroyThreadPool();
+        return EXIT_SUCCESS;
+    }
+
+    const int mipBenchmarkFrameCount = ParseMipBenchmarkFrameCount(argc, argv);
+    const int filterBenchmarkFrameCount = ParseFilterBenchmarkFrameCount(argc, argv);
+    const int clippingBenchmarkFrameCount = ParseClippingBenchmarkFrameCount(argc, argv);
+    const int headlessFrameCount = ParseHeadlessFrameCount(argc, argv);
+    if (mipBenchmarkFrameCount > 0
+        || filterBenchmarkFrameCount > 0
+        || clippingBenchmarkFrameCount > 0
+        || headlessFrameCount > 0)
+    {
+        if (!InitializeHeadless(&persistentArena))
+        {
+            return EXIT_FAILURE;
+        }
+
+        Setup(&frameArena, &persistentArena, ParseTextureLayout(argc, argv));
+        ApplyRenderOptionArguments(argc, argv);
+
+        bool isStatsWritten = true;
+        if (mipBenchmarkFrameCount > 0)
+        {
+            RunMipBenchmark(&frameArena, &persistentArena, mipBenchmarkFrameCount);
+        }
+        else if (filterBenchmarkFrameCount > 0)
+        {
+            RunTextureFilterBenchmark(&frameArena, filterBenchmarkFrameCount);
+        }
+        else if (clippingBenchmarkFrameCount > 0)
+        {
+            RunClippingBenchmark(&frameArena, clippingBenchmarkFrameCount);
+        }
+        else
+        {
+            RunHeadless(&frameArena, &persistentArena, headlessFrameCount);
+            isStatsWritten = WriteRecordedStats(ParseStatsFileName(argc, argv));
+        }
+
+        DestroyWindow();
+        FreeResources();
+        DestroyThreadPool();
+
+        ArenaDestroyHeap(&frameArena);
+        ArenaDestroyHeap(&persistentArena);
+
+        return isStatsWritten ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     g_IsRunning = InitializeWindow(&persistentArena, windowTitle);
 
     if (!g_IsRunning)
@@ -712,7 +1700,8 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    Setup(&frameArena, &persistentArena);
+    Setup(&frameArena, &persistentArena, ParseTextureLayout(argc, argv));
+    ApplyRenderOptionArguments(argc, argv);
 
     u32 prevTime = SDL_GetTicks();
     u32 printTime = prevTime;
@@ -735,7 +1724,8 @@ int main(int argc, char* argv[])
             accumulatedTime -= FIXED_UPDATE_TIMESTEP;
         }
 
-        Render();
+        Render(&frameArena);
+        EndFrameStats();
 
         PROFILE_FRAME();
 
@@ -764,6 +1754,7 @@ int main(int argc, char* argv[])
 
     DestroyWindow();
     FreeResources();
+    DestroyThreadPool();
 
     ArenaDestroyHeap(&frameArena);
     ArenaDestroyHeap(&persistentArena);
@@ -1,15 +1,21 @@
 #pragma once
+#include <cmath>
+#include <type_traits>
+#include <xmmintrin.h>
+
 #include "vector.h"
 
-struct Mat4
+// NOTE(sbalse): Stored column-major, m_Columns[column][row]. Multiplying a vector is then a sum of the
+// columns scaled by the vector components, 4 broadcast-multiply-adds with whole columns in SSE registers.
+struct alignas(16) Mat4
 {
-    float m_Values[4][4];
+    float m_Columns[4][4];
 };
 
 // NOTE(sbalse): A 4x4 identity matrix.
 inline constexpr Mat4 MAT4_IDENTITY =
 {
-    .m_Values =
+    .m_Columns =
     {
         { 1, 0, 0, 0 },
         { 0, 1, 0, 0 },
@@ -18,23 +24,214 @@ inline constexpr Mat4 MAT4_IDENTITY =
     }
 };
 
-// TODO(sbalse): Use operator overloading for matrix math.
+// NOTE(sbalse): The value at the given row and column, for code that thinks of the matrix in rows.
+constexpr float Mat4Get(const Mat4& m, const int row, const int column)
+{
+    return m.m_Columns[column][row];
+}
+
+constexpr void Mat4Set(Mat4* const m, const int row, const int column, const float value)
+{
+    m->m_Columns[column][row] = value;
+}
+
+// NOTE(sbalse): The products are summed in column order, so the scalar and the SSE versions give exactly the
+// same results.
+constexpr Vec4 Mat4MulVec4(const Mat4& m, const Vec4 v)
+{
+    if (std::is_constant_evaluated())
+    {
+        Vec4 result = {};
+        result.m_X = m.m_Columns[0][0] * v.m_X + m.m_Columns[1][0] * v.m_Y + m.m_Columns[2][0] * v.m_Z + m.m_Columns[3][0] * v.m_W;
+        result.m_Y = m.m_Columns[0][1] * v.m_X + m.m_Columns[1][1] * v.m_Y + m.m_Columns[2][1] * v.m_Z + m.m_Columns[3][1] * v.m_W;
+        result.m_Z = m.m_Columns[0][2] * v.m_X + m.m_Columns[1][2] * v.m_Y + m.m_Columns[2][2] * v.m_Z + m.m_Columns[3][2] * v.m_W;
+        result.m_W = m.m_Columns[0][3] * v.m_X + m.m_Columns[1][3] * v.m_Y + m.m_Columns[2][3] * v.m_Z + m.m_Columns[3][3] * v.m_W;
+        return result;
+    }
+
+    __m128 result = _mm_mul_ps(_mm_load_ps(m.m_Columns[0]), _mm_set1_ps(v.m_X));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(m.m_Columns[1]), _mm_set1_ps(v.m_Y)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(m.m_Columns[2]), _mm_set1_ps(v.m_Z)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_load_ps(m.m_Columns[3]), _mm_set1_ps(v.m_W)));
+    return Vec4Store(result);
+}
+
+// NOTE(sbalse): Column j of the result is m1 times column j of m2.
+constexpr Mat4 Mat4MulMat4(const Mat4& m1, const Mat4& m2)
+{
+    Mat4 result = {};
+    for (int column = 0; column < 4; column++)
+    {
+        const Vec4 product = Mat4MulVec4(
+            m1,
+            { m2.m_Columns[column][0], m2.m_Columns[column][1], m2.m_Columns[column][2], m2.m_Columns[column][3] }
+        );
+        result.m_Columns[column][0] = product.m_X;
+        result.m_Columns[column][1] = product.m_Y;
+        result.m_Columns[column][2] = product.m_Z;
+        result.m_Columns[column][3] = product.m_W;
+    }
+    return result;
+}
+
+constexpr Mat4 Mat4MakeScale(const float sx, const float sy, const float sz)
+{
+    /*
+        | sx 0  0  0 |
+        | 0  sy 0  0 |
+        | 0  0  sz 0 |
+        | 0  0  0  1 |
+    */
+    Mat4 result = MAT4_IDENTITY;
+    Mat4Set(&result, 0, 0, sx);
+    Mat4Set(&result, 1, 1, sy);
+    Mat4Set(&result, 2, 2, sz);
+    return result;
+}
+
+constexpr Mat4 Mat4MakeTranslation(const float tx, const float ty, const float tz)
+{
+    /*
+        | 1 0 0 tx |
+        | 0 1 0 ty |
+        | 0 0 1 tz |
+        | 0 0 0  1 |
+    */
+    Mat4 result = MAT4_IDENTITY;
+    Mat4Set(&result, 0, 3, tx);
+    Mat4Set(&result, 1, 3, ty);
+    Mat4Set(&result, 2, 3, tz);
+    return result;
+}
+
+inline Mat4 Mat4MakeRotationX(const float angle)
+{
+    const float c = std::cosf(angle);
+    const float s = std::sinf(angle);
+    /*
+        | 1  0  0 0 |
+        | 0  c -s 0 |
+        | 0  s  c 0 |
+        | 0  0  0 1 |
+    */
+    Mat4 result = MAT4_IDENTITY;
+    Mat4Set(&result, 1, 1, c);
+    Mat4Set(&result, 1, 2, -s);
+    Mat4Set(&result, 2, 1, s);
+    Mat4Set(&result, 2, 2, c);
+    return result;
+}
+
+inline Mat4 Mat4MakeRotationY(const float angle)
+{
+    const float c = std::cosf(angle);
+    const float s = std::sinf(angle);
+    /*
+        |  c  0  s 0 |
+        |  0  1  0 0 |
+        | -s  0  c 0 |
+        |  0  0  0 1 |
+    */
+    Mat4 result = MAT4_IDENTITY;
+    Mat4Set(&result, 0, 0, c);
+    Mat4Set(&result, 0, 2, s);
+    Mat4Set(&result, 2, 0, -s);
+    Mat4Set(&result, 2, 2, c);
+    return result;
+}
+
+inline Mat4 Mat4MakeRotationZ(const float angle)
+{
+    const float c = std::cosf(angle);
+    const float s = std::sinf(angle);
+    /*
+        | c -s  0 0 |
+        | s  c  0 0 |
+        | 0  0  1 0 |
+        | 0  0  0 1 |
+    */
+    Mat4 result = MAT4_IDENTITY;
+    Mat4Set(&result, 0, 0, c);
+    Mat4Set(&result, 0, 1, -s);
+    Mat4Set(&result, 1, 0, s);
+    Mat4Set(&result, 1, 1, c);
+    return result;
+}
+
+inline Mat4 Mat4MakePerspective(const float fov, const float aspect, const float znear, const float zfar)
+{
+    /*
+        | (h/w)*1/tan(fov/2)             0           0                 0 |
+        |                  0  1/tan(fov/2)           0                 0 |
+        |                  0             0  zf/(zf-zn) (-zf*zn)/(zf-zn)) |
+        |                  0             0           1                 0 |
+    */
+    Mat4 result = {};
+    Mat4Set(&result, 0, 0, aspect * (1 / std::tanf(fov / 2.0f)));
+    Mat4Set(&result, 1, 1, 1 / std::tanf(fov / 2.0f));
+    Mat4Set(&result, 2, 2, zfar / (zfar - znear));
+    Mat4Set(&result, 2, 3, (-zfar * znear) / (zfar - znear));
+    Mat4Set(&result, 3, 2, 1.0f);
+    return result;
+}
+
+// NOTE(sbalse): Perform only the perspective divide, for a vertex that is already in clip space. w is kept
+// as it is, the same as in Mat4MulVec4Project().
+constexpr Vec4 Vec4PerspectiveDivide(const Vec4 v)
+{
+    Vec4 result = v;
+
+    // NOTE(sbalse): Perform perspective divide with original z-value that is now stored in w.
+    if (result.m_W != 0.0f)
+    {
+        result.m_X /= result.m_W;
+        result.m_Y /= result.m_W;
+        result.m_Z /= result.m_W;
+    }
+
+    return result;
+}
 
-Vec4 Mat4MulVec4(const Mat4 m, const Vec4 v);
-Mat4 Mat4MulMat4(const Mat4 m1, const Mat4 m2);
-Mat4 Mat4MakeScale(const float sx, const float sy, const float sz);
-Mat4 Mat4MakeTranslation(const float tx, const float ty, const float tz);
-Mat4 Mat4MakeRotationX(const float angle);
-Mat4 Mat4MakeRotationY(const float angle);
-Mat4 Mat4MakeRotationZ(const float angle);
-Mat4 Mat4MakePerspective(const float fov, const float aspect, const float znear, const float zfar);
 // NOTE(sbalse): Multiply the projection matrix `matProj` with the Vector `v` and also
 // perform perspective divide on the result.
-Vec4 Mat4MulVec4Project(const Mat4 matProj, const Vec4 v);
+constexpr Vec4 Mat4MulVec4Project(const Mat4& matProj, const Vec4 v)
+{
+    // NOTE(sbalse): Multiply the projection matrix by our original vector.
+    return Vec4PerspectiveDivide(Mat4MulVec4(matProj, v));
+}
 // TODO(sbalse): Orthographic projection.
 
 // NOTE(sbalse):
 // eye = Camera position.
 // target = What should the camera look at.
 // up = What is "up" for the camera.
-Mat4 Mat4LookAt(const Vec3 eye, const Vec3 target, const Vec3 up);
+inline Mat4 Mat4LookAt(const Vec3 eye, const Vec3 target, const Vec3 up)
+{
+    // NOTE(sbalse): Compute the forward (z), right (x) and up (y) vectors.
+    Vec3 z = Vec3Sub(target, eye);
+    Vec3Normalize(&z);
+    Vec3 x = Vec3Cross(up, z);
+    Vec3Normalize(&x);
+    Vec3 y = Vec3Cross(z, x);
+
+    // | x.x  x.y  x.z  -dot(x, eye) |
+    // | y.x  y.y  y.z  -dot(y, eye) |
+    // | z.x  z.y  z.z  -dot(z, eye) |
+    // |   0    0    0             1 |
+    const Mat4 result = // NOTE(sbalse): The result view matrix, written down column by column.
+    {
+        .m_Columns =
+        {
+            { x.m_X, y.m_X, z.m_X, 0 },
+            { x.m_Y, y.m_Y, z.m_Y, 0 },
+            { x.m_Z, y.m_Z, z.m_Z, 0 },
+            { -Vec3Dot(x, eye), -Vec3Dot(y, eye), -Vec3Dot(z, eye), 1 },
+        },
+    };
+
+    return result;
+}
+
+/******** NOTE(sbalse): Matrix operators. ***********/
+constexpr Vec4 operator*(const Mat4& m, const Vec4 v) { return Mat4MulVec4(m, v); }
+constexpr Mat4 operator*(const Mat4& m1, const Mat4& m2) { return Mat4MulMat4(m1, m2); }
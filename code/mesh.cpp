@@ -1,13 +1,19 @@
 #include "mesh.h"
 
-#include <cstdio>
-#include <array>
 #include <cassert>
+#include <chrono>
+extern "C"
+{
+    #include <upng.h>
+}
 
 #include "log.h"
 #include "vector.h"
-#include "colorlibrary.h"
+#include "matrix.h"
 #include "triangle.h"
+#include "fileio.h"
+#include "texture.h"
+#include "objparser.h"
 
 inline constexpr int MAX_NUM_MESHES = 10;
 static Mesh g_Meshes[MAX_NUM_MESHES] = {};
@@ -17,91 +23,49 @@ static void LoadMeshObjData(Arena* arena, const char* const objFileName, Mesh* c
 {
     assert(outMesh != nullptr);
 
-    std::FILE* file = nullptr;
-    fopen_s(&file, objFileName, "r");
+    const auto startTime = std::chrono::steady_clock::now();
 
     LOG_INFO("Loading obj file: %s...", objFileName);
 
-    if (!file)
+    MappedFile file = {};
+    if (!MapFile(objFileName, &file))
     {
         LOG_ERROR("Failed to open obj file: %s.", objFileName);
         return;
     }
 
-    std::array<char, 1024> line = {};
-
-    constexpr int maxNumberOfCharactersToRead = scast<int>(line.size());
+    // NOTE(sbalse): Parse the file in place, straight out of the mapped memory.
+    const ObjMesh objMesh = ParseObj(arena, rcast<const char*>(file.m_Data), file.m_Size);
 
-    constexpr int maxVertices = 1024;
-    constexpr int maxFaces = 1024;
-    constexpr int maxTexcoords = 1024;
+    UnmapFile(&file);
 
-    // NOTE(sbalse): Allocate memory for vertices and faces from the arena.
-    outMesh->m_Vertices = PushArray(arena, Vec3, maxVertices);
-    outMesh->m_VerticesCount = 0;
-    outMesh->m_Faces = PushArray(arena, Face, maxFaces);
-    outMesh->m_FacesCount = 0;
+    outMesh->m_VertexStreams = objMesh.m_VertexStreams;
+    outMesh->m_VerticesCount = objMesh.m_VerticesCount;
+    outMesh->m_Faces = objMesh.m_Faces;
+    outMesh->m_FacesCount = objMesh.m_FacesCount;
 
-    TempArena temp = TempArenaBegin(arena);
-    Tex2* const texCoordinates = PushArray(temp.m_OriginalArena, Tex2, maxTexcoords);
-    size_t texCoordinatesCount = 0;
-
-    while (std::fgets(line.data(), maxNumberOfCharactersToRead, file))
+    if (objMesh.m_SkippedFacesCount > 0)
     {
-        // NOTE(sbalse): Read vertex information.
-        if (std::strncmp(line.data(), "v ", 2) == 0)
-        {
-            Vec3 vertex = {};
-            sscanf_s(line.data(), "v %f %f %f", &vertex.m_X, &vertex.m_Y, &vertex.m_Z);
-            PushStruct(vertex, outMesh->m_Vertices, outMesh->m_VerticesCount);
-        }
-
-        // NOTE(sbalse): Texture coordinate information.
-        if (std::strncmp(line.data(), "vt ", 3) == 0)
-        {
-            Tex2 texcoord = {};
-            sscanf_s(line.data(), "vt %f %f", &texcoord.m_U, &texcoord.m_V);
-            PushStruct(texcoord, texCoordinates, texCoordinatesCount);
-        }
-
-        // NOTE(sbalse): Read face information.
-        if (std::strncmp(line.data(), "f ", 2) == 0)
-        {
-            int vertexIndices[3] = {};
-            int textureIndices[3] = {};
-            int normalIndices[3] = {};
-            sscanf_s(
-                line.data(),
-                "f %d/%d/%d %d/%d/%d %d/%d/%d",
-                &vertexIndices[0], &textureIndices[0], &normalIndices[0],
-                &vertexIndices[1], &textureIndices[1], &normalIndices[1],
-                &vertexIndices[2], &textureIndices[2], &normalIndices[2]
-            );
-
-            const Face face =
-            {
-                // NOTE(sbalse): Need to do -1 since numbers start at 1 in OBJ files.
-                .m_A = vertexIndices[0] - 1,
-                .m_B = vertexIndices[1] - 1,
-                .m_C = vertexIndices[2] - 1,
-                .m_AUV = texCoordinates[textureIndices[0] - 1],
-                .m_BUV = texCoordinates[textureIndices[1] - 1],
-                .m_CUV = texCoordinates[textureIndices[2] - 1],
-                .m_Color = WHITE,
-            };
-
-            PushStruct(face, outMesh->m_Faces, outMesh->m_FacesCount);
-        }
+        LOG_ERROR("Skipped %zu malformed faces in obj file: %s.", objMesh.m_SkippedFacesCount, objFileName);
     }
 
-    TempArenaEnd(&temp);
-
-    LOG_INFO("Successfully loaded obj file: %s.", objFileName);
-
-    std::fclose(file);
+    const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - startTime;
+    LOG_INFO(
+        "Successfully loaded obj file: %s. %zu vertices, %zu triangles in %.2f ms, peak memory %.1f KB.",
+        objFileName,
+        outMesh->m_VerticesCount,
+        outMesh->m_FacesCount,
+        loadTime.count(),
+        scast<double>(objMesh.m_PeakArenaBytes) / 1024.0
+    );
 }
 
-static void LoadMeshPNGData(const char* const fileName, Mesh* const outMesh)
+static void LoadMeshPNGData(
+    Arena* arena,
+    const char* const fileName,
+    const TextureLayout textureLayout,
+    Mesh* const outMesh
+)
 {
     assert(outMesh != nullptr);
 
@@ -122,10 +86,65 @@ static void LoadMeshPNGData(const char* const fileName, Mesh* const outMesh)
             "Error while decoding PNG. Error enum value = %d, Line = errorLine",
             error,
             errorLine);
+        upng_free(pngImage);
         return;
     }
 
-    outMesh->m_Texture = pngImage;
+    // NOTE(sbalse): The texture has its own copy of the texels so the decoded image isn't needed after this.
+    outMesh->m_Texture = CreateTexture(
+        arena,
+        rcast<const u32*>(upng_get_buffer(pngImage)),
+        upng_get_width(pngImage),
+        upng_get_height(pngImage),
+        textureLayout
+    );
+    upng_free(pngImage);
+}
+
+// NOTE(sbalse): Use the cooked mesh file of the OBJ and PNG pair if there is an up to date one. The mesh
+// data is used straight from the mapped file without parsing, decoding or copying anything.
+static bool LoadMeshCookedData(
+    Arena* arena,
+    const char* const objFileName,
+    const char* const pngFileName,
+    const TextureLayout textureLayout,
+    Mesh* const outMesh
+)
+{
+    assert(outMesh != nullptr);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    CookedMesh cookedMesh = {};
+    if (!MapCookedMesh(objFileName, pngFileName, &cookedMesh))
+    {
+        return false;
+    }
+
+    outMesh->m_CookedMesh = cookedMesh;
+    outMesh->m_VertexStreams = cookedMesh.m_VertexStreams;
+    outMesh->m_VerticesCount = cookedMesh.m_VerticesCount;
+    outMesh->m_Faces = cookedMesh.m_Faces;
+    outMesh->m_FacesCount = cookedMesh.m_FacesCount;
+
+    // NOTE(sbalse): The cooked mip chain is used as is when it has the layout we want. Otherwise only its
+    // texels get reordered, it doesn't have to be resized and filtered again.
+    outMesh->m_Texture = (cookedMesh.m_Texture.m_Layout == textureLayout)
+        ? cookedMesh.m_Texture
+        : ChangeTextureLayout(arena, cookedMesh.m_Texture, textureLayout);
+
+    const std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - startTime;
+    LOG_INFO(
+        "Successfully mapped cooked mesh of: %s. %zu vertices, %zu triangles, %ux%u texture in %.2f ms.",
+        objFileName,
+        outMesh->m_VerticesCount,
+        outMesh->m_FacesCount,
+        outMesh->m_Texture.m_Mips[0].m_Width,
+        outMesh->m_Texture.m_Mips[0].m_Height,
+        loadTime.count()
+    );
+
+    return true;
 }
 
 void LoadMesh(
@@ -134,14 +153,16 @@ void LoadMesh(
     const char* const pngFileName,
     const Vec3 translation,
     const Vec3 scale,
-    const Vec3 rotation
+    const Vec3 rotation,
+    const TextureLayout textureLayout
 )
 {
-    // Load the OBJ
-    LoadMeshObjData(arena, objFileName, &g_Meshes[g_MeshCount]);
-
-    // Load the PNG
-    LoadMeshPNGData(pngFileName, &g_Meshes[g_MeshCount]);
+    // Use the cooked mesh, or load the OBJ and the PNG when it's missing or stale
+    if (!LoadMeshCookedData(arena, objFileName, pngFileName, textureLayout, &g_Meshes[g_MeshCount]))
+    {
+        LoadMeshObjData(arena, objFileName, &g_Meshes[g_MeshCount]);
+        LoadMeshPNGData(arena, pngFileName, textureLayout, &g_Meshes[g_MeshCount]);
+    }
 
     // Init the scale, translation and rotation
     g_Meshes[g_MeshCount].m_Scale = scale;
@@ -164,11 +185,60 @@ Mesh* GetMesh(const int meshIndex)
     return &g_Meshes[meshIndex];
 }
 
+static bool Vec3Equal(const Vec3 a, const Vec3 b)
+{
+    return a.m_X == b.m_X && a.m_Y == b.m_Y && a.m_Z == b.m_Z;
+}
+
+Mat4 GetMeshWorldMatrix(Mesh* const mesh)
+{
+    if (mesh->m_IsWorldMatrixValid
+        && Vec3Equal(mesh->m_WorldMatrixRotation, mesh->m_Rotation)
+        && Vec3Equal(mesh->m_WorldMatrixScale, mesh->m_Scale)
+        && Vec3Equal(mesh->m_WorldMatrixTranslation, mesh->m_Translation))
+    {
+        return mesh->m_WorldMatrix;
+    }
+
+    // NOTE(sbalse): Create scale, translation, and rotation matrices that will be
+    // multiplied with our mesh vertices.
+    const Mat4 scaleMatrix = Mat4MakeScale(
+        mesh->m_Scale.m_X,
+        mesh->m_Scale.m_Y,
+        mesh->m_Scale.m_Z
+    );
+    const Mat4 translationMatrix = Mat4MakeTranslation(
+        mesh->m_Translation.m_X,
+        mesh->m_Translation.m_Y,
+        mesh->m_Translation.m_Z
+    );
+    const Mat4 rotationMatrixX = Mat4MakeRotationX(mesh->m_Rotation.m_X);
+    const Mat4 rotationMatrixY = Mat4MakeRotationY(mesh->m_Rotation.m_Y);
+    const Mat4 rotationMatrixZ = Mat4MakeRotationZ(mesh->m_Rotation.m_Z);
+
+    // NOTE(sbalse): Create a "World Matrix" combining scale, rotation and translation
+    // matrices of the mesh.
+    Mat4 worldMatrix = MAT4_IDENTITY;
+    worldMatrix = Mat4MulMat4(scaleMatrix, worldMatrix);
+    worldMatrix = Mat4MulMat4(rotationMatrixX, worldMatrix);
+    worldMatrix = Mat4MulMat4(rotationMatrixY, worldMatrix);
+    worldMatrix = Mat4MulMat4(rotationMatrixZ, worldMatrix);
+    worldMatrix = Mat4MulMat4(translationMatrix, worldMatrix);
+
+    mesh->m_WorldMatrix = worldMatrix;
+    mesh->m_WorldMatrixRotation = mesh->m_Rotation;
+    mesh->m_WorldMatrixScale = mesh->m_Scale;
+    mesh->m_WorldMatrixTranslation = mesh->m_Translation;
+    mesh->m_IsWorldMatrixValid = true;
+
+    return worldMatrix;
+}
+
 void FreeMeshes()
 {
     for (int i = 0; i < g_MeshCount; i++)
     {
-        // Free mesh texture.
-        upng_free(g_Meshes[i].m_Texture);
+        // Unmap the cooked mesh file.
+        UnmapCookedMesh(&g_Meshes[i].m_CookedMesh);
     }
 }
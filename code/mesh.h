@@ -1,12 +1,11 @@
 #pragma once
-extern "C"
-{
-    #include <upng.h>
-}
-
 #include "arena.h"
 #include "vector.h"
+#include "matrix.h"
 #include "triangle.h"
+#include "texture.h"
+#include "meshfile.h"
+#include "vertexkernels.h"
 
 // NOTE(sbalse): A struct for dynamic sized meshes. Contains an array of vertices, faces and the
 // rotation of the mesh.
@@ -16,13 +15,26 @@ struct Mesh
     Vec3 m_Scale; // NOTE(sbalse): Scale with x, y and z values.
     Vec3 m_Translation; // NOTE(sbalse): Translation with x, y and z values.
 
-    Vec3* m_Vertices; // NOTE(sbalse): The mesh vertices.
+    // NOTE(sbalse): The mesh vertices, one stream per component for the vertex kernels.
+    Vec3Streams m_VertexStreams;
     size_t m_VerticesCount;
 
-    Face* m_Faces; // NOTE(sbalse): The mesh faces.
+    const Face* m_Faces; // NOTE(sbalse): The mesh faces.
     size_t m_FacesCount;
 
-    upng_t* m_Texture; // NOTE(sbalse): The mesh's PNG texture.
+    Texture m_Texture; // NOTE(sbalse): The mesh's texture.
+
+    // NOTE(sbalse): Where the vertices, faces and texture live. Either the cooked mesh file is mapped, or they
+    // are in the arena.
+    CookedMesh m_CookedMesh;
+
+    // NOTE(sbalse): World matrix built from the rotation, scale and translation above and the values it
+    // was built from. Only rebuilt when one of them changes, see GetMeshWorldMatrix().
+    Mat4 m_WorldMatrix;
+    Vec3 m_WorldMatrixRotation;
+    Vec3 m_WorldMatrixScale;
+    Vec3 m_WorldMatrixTranslation;
+    bool m_IsWorldMatrixValid;
 };
 
 void LoadMesh(
@@ -31,8 +43,11 @@ void LoadMesh(
     const char* const pngFileName,
     const Vec3 translation,
     const Vec3 scale,
-    const Vec3 rotation
+    const Vec3 rotation,
+    const TextureLayout textureLayout
 );
 int GetNumOfMeshes();
 Mesh* GetMesh(const int meshIndex);
+// NOTE(sbalse): The matrix combining the scale, rotation and translation of the mesh.
+Mat4 GetMeshWorldMatrix(Mesh* const mesh);
 void FreeMeshes();
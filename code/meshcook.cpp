@@ -0,0 +1,258 @@
+// NOTE(sbalse): MeshCook, the offline tool that writes the cooked mesh files (.mesh) the renderer maps at
+// startup instead of parsing OBJ files and decoding PNG files. See meshfile.h for the file layout.
+//
+// Usage: MeshCook [--texture-layout <linear|morton>] [directory...]
+//
+// Cooks every name.obj in the directories (assets by default) together with name.png next to it, if
+// there is one, into name.mesh. The texture is cooked in the given layout, linear by default. Run it from
+// the same working directory as the renderer.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+extern "C"
+{
+    #include <upng.h>
+}
+
+#include "log.h"
+#include "common.h"
+#include "arena.h"
+#include "fileio.h"
+#include "objparser.h"
+#include "meshfile.h"
+#include "texture.h"
+
+static bool WriteMeshFileData(std::FILE* const file, const void* const data, const u64 size, const u64 offset)
+{
+    // NOTE(sbalse): Pad up to the aligned offset of the data.
+    static const u8 zeros[MESH_FILE_ALIGNMENT] = {};
+    const long position = std::ftell(file);
+    if (position < 0 || scast<u64>(position) > offset || offset - position > sizeof(zeros))
+    {
+        return false;
+    }
+
+    const size_t paddingSize = scast<size_t>(offset - position);
+    if (std::fwrite(zeros, 1, paddingSize, file) != paddingSize)
+    {
+        return false;
+    }
+
+    return size == 0 || std::fwrite(data, 1, scast<size_t>(size), file) == size;
+}
+
+static bool CookMesh(
+    Arena* const arena,
+    const char* const objFileName,
+    const char* const pngFileName,
+    const TextureLayout textureLayout)
+{
+    char cookedFileName[512] = {};
+    if (!GetCookedMeshFileName(objFileName, cookedFileName, sizeof(cookedFileName)))
+    {
+        LOG_ERROR("Path too long: %s.", objFileName);
+        return false;
+    }
+
+    FileStamp objStamp = {};
+    MappedFile objFile = {};
+    if (!GetFileStamp(objFileName, &objStamp) || !MapFile(objFileName, &objFile))
+    {
+        LOG_ERROR("Failed to open obj file: %s.", objFileName);
+        return false;
+    }
+
+    TempArena temp = TempArenaBegin(arena);
+    const ObjMesh objMesh = ParseObj(temp.m_OriginalArena, rcast<const char*>(objFile.m_Data), objFile.m_Size);
+    UnmapFile(&objFile);
+
+    if (objMesh.m_SkippedFacesCount > 0)
+    {
+        LOG_ERROR("Skipped %zu malformed faces in obj file: %s.", objMesh.m_SkippedFacesCount, objFileName);
+    }
+
+    // NOTE(sbalse): The texture is optional. Meshes without one are cooked without texels.
+    FileStamp pngStamp = {};
+    upng_t* pngImage = nullptr;
+    if (GetFileStamp(pngFileName, &pngStamp))
+    {
+        pngImage = upng_new_from_file(pngFileName);
+        if (pngImage)
+        {
+            upng_decode(pngImage);
+        }
+
+        // NOTE(sbalse): The pixel kernels read one u32 per texel.
+        if (!pngImage || upng_get_error(pngImage) != UPNG_EOK || upng_get_bpp(pngImage) != 32)
+        {
+            LOG_ERROR("Failed to decode PNG file or it isn't 32 bits per pixel: %s.", pngFileName);
+            if (pngImage)
+            {
+                upng_free(pngImage);
+            }
+            TempArenaEnd(&temp);
+            return false;
+        }
+    }
+
+    // NOTE(sbalse): Cook the texture the way the renderer would create it, so it's used as is.
+    const Texture texture = CreateTexture(
+        temp.m_OriginalArena,
+        pngImage ? rcast<const u32*>(upng_get_buffer(pngImage)) : nullptr,
+        pngImage ? upng_get_width(pngImage) : 0,
+        pngImage ? upng_get_height(pngImage) : 0,
+        textureLayout
+    );
+    if (pngImage)
+    {
+        upng_free(pngImage);
+    }
+
+    const MeshFileHeader header = MakeMeshFileHeader(
+        objStamp,
+        pngStamp,
+        objMesh.m_VerticesCount,
+        objMesh.m_FacesCount,
+        texture
+    );
+
+    bool isWritten = false;
+    std::FILE* file = nullptr;
+    fopen_s(&file, cookedFileName, "wb");
+    if (file)
+    {
+        isWritten = WriteMeshFileData(file, &header, sizeof(header), 0)
+            && WriteMeshFileData(file, objMesh.m_VertexStreams.m_X, header.m_VerticesCount * sizeof(float), header.m_VerticesXOffset)
+            && WriteMeshFileData(file, objMesh.m_VertexStreams.m_Y, header.m_VerticesCount * sizeof(float), header.m_VerticesYOffset)
+            && WriteMeshFileData(file, objMesh.m_VertexStreams.m_Z, header.m_VerticesCount * sizeof(float), header.m_VerticesZOffset)
+            && WriteMeshFileData(file, objMesh.m_Faces, header.m_FacesCount * sizeof(Face), header.m_FacesOffset)
+            && WriteMeshFileData(file, texture.m_Texels, GetTextureTexelsCount(texture) * sizeof(u32), header.m_TexelsOffset)
+            && WriteMeshFileData(
+                file,
+                texture.m_MortonTables,
+                GetTextureMortonTablesCount(texture) * sizeof(u32),
+                header.m_MortonTablesOffset
+            );
+
+        isWritten = (std::fclose(file) == 0) && isWritten;
+    }
+
+    TempArenaEnd(&temp);
+
+    if (!isWritten)
+    {
+        // NOTE(sbalse): Don't leave a half written file behind. The renderer would reject it anyway.
+        std::remove(cookedFileName);
+        LOG_ERROR("Failed to write cooked mesh file: %s.", cookedFileName);
+        return false;
+    }
+
+    LOG_INFO(
+        "Cooked %s: %zu vertices, %zu triangles, %ux%u %s texture with %d mip levels, %.1f KB.",
+        cookedFileName,
+        objMesh.m_VerticesCount,
+        objMesh.m_FacesCount,
+        header.m_TextureWidth,
+        header.m_TextureHeight,
+        GetTextureLayoutName(textureLayout),
+        texture.m_NumMips,
+        scast<double>(header.m_FileSize) / 1024.0
+    );
+
+    return true;
+}
+
+static int CookDirectory(Arena* const arena, const char* const directory, const TextureLayout textureLayout)
+{
+    std::error_code error;
+    std::filesystem::directory_iterator files(directory, error);
+    if (error)
+    {
+        LOG_ERROR("Failed to open directory: %s.", directory);
+        return 1;
+    }
+
+    int numFailed = 0;
+    for (const std::filesystem::directory_entry& entry : files)
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".obj")
+        {
+            continue;
+        }
+
+        // NOTE(sbalse): Use generic (forward slash) paths so the file names match the ones the renderer
+        // passes to LoadMesh().
+        std::filesystem::path pngPath = entry.path();
+        pngPath.replace_extension(".png");
+        const std::string objFileName = entry.path().generic_string();
+        const std::string pngFileName = pngPath.generic_string();
+
+        if (!CookMesh(arena, objFileName.c_str(), pngFileName.c_str(), textureLayout))
+        {
+            numFailed++;
+        }
+    }
+
+    return numFailed;
+}
+
+// NOTE(sbalse): Get the layout to cook the textures in from the "--texture-layout <linear|morton>" command line
+// argument, the same one the renderer takes.
+static TextureLayout ParseTextureLayout(int argc, char* argv[])
+{
+    for (int i = 1; i < argc - 1; i++)
+    {
+        if (std::strcmp(argv[i], "--texture-layout") == 0)
+        {
+            if (std::strcmp(argv[i + 1], "morton") == 0)
+            {
+                return TextureLayout::Morton;
+            }
+            if (std::strcmp(argv[i + 1], "linear") != 0)
+            {
+                LOG_ERROR("Unknown texture layout: %s.", argv[i + 1]);
+            }
+        }
+    }
+
+    return TextureLayout::Linear;
+}
+
+int main(int argc, char* argv[])
+{
+    Arena arena = {};
+    ArenaCreateHeap(&arena, MEGABYTES(256));
+    if (!arena.m_Buf)
+    {
+        LOG_ERROR("Failed to create an arena.");
+        return EXIT_FAILURE;
+    }
+
+    const TextureLayout textureLayout = ParseTextureLayout(argc, argv);
+
+    // NOTE(sbalse): Every argument that isn't an option is a directory to cook.
+    int numDirectories = 0;
+    int numFailed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--texture-layout") == 0)
+        {
+            i++;
+            continue;
+        }
+
+        numFailed += CookDirectory(&arena, argv[i], textureLayout);
+        numDirectories++;
+    }
+    if (numDirectories == 0)
+    {
+        numFailed += CookDirectory(&arena, "assets", textureLayout);
+    }
+
+    ArenaDestroyHeap(&arena);
+
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,190 @@
+#include "meshfile.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "log.h"
+
+// NOTE(sbalse): The header is compared with memcmp() so it must not have any padding.
+static_assert(sizeof(MeshFileHeader) == (4 * sizeof(u32)) + (2 * sizeof(FileStamp)) + (9 * sizeof(u64)) + (4 * sizeof(u32)));
+
+static u64 AlignMeshFileOffset(const u64 offset)
+{
+    return (offset + (MESH_FILE_ALIGNMENT - 1)) & ~(MESH_FILE_ALIGNMENT - 1);
+}
+
+static bool FileStampEqual(const FileStamp a, const FileStamp b)
+{
+    return a.m_ModificationTime == b.m_ModificationTime && a.m_Size == b.m_Size;
+}
+
+// NOTE(sbalse): The faces index the vertices without any checks when drawing, so a face pointing past the
+// vertices would read out of bounds.
+static bool AreFaceIndicesValid(const Face* const faces, const u64 facesCount, const u64 verticesCount)
+{
+    for (u64 i = 0; i < facesCount; i++)
+    {
+        const Face& face = faces[i];
+        const bool isInvalid = face.m_A < 0 || scast<u64>(face.m_A) >= verticesCount
+            || face.m_B < 0 || scast<u64>(face.m_B) >= verticesCount
+            || face.m_C < 0 || scast<u64>(face.m_C) >= verticesCount;
+        if (isInvalid)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool GetCookedMeshFileName(const char* const objFileName, char* const outFileName, const size_t outFileNameSize)
+{
+    // NOTE(sbalse): Replace the extension, if there is one after the last path separator.
+    const char* const extension = std::strrchr(objFileName, '.');
+    const char* const lastSlash = std::strrchr(objFileName, '/');
+    const char* const lastBackslash = std::strrchr(objFileName, '\\');
+    const bool hasExtension = extension
+        && (!lastSlash || extension > lastSlash)
+        && (!lastBackslash || extension > lastBackslash);
+
+    const int stemLength = scast<int>(hasExtension ? (extension - objFileName) : std::strlen(objFileName));
+    const int length = std::snprintf(outFileName, outFileNameSize, "%.*s.mesh", stemLength, objFileName);
+
+    return length > 0 && scast<size_t>(length) < outFileNameSize;
+}
+
+MeshFileHeader MakeMeshFileHeader(
+    const FileStamp objStamp,
+    const FileStamp pngStamp,
+    const size_t verticesCount,
+    const size_t facesCount,
+    const Texture& texture
+)
+{
+    MeshFileHeader header = {};
+    header.m_Magic = MESH_FILE_MAGIC;
+    header.m_Version = MESH_FILE_VERSION;
+    header.m_VertexComponentSize = sizeof(float);
+    header.m_FaceSize = sizeof(Face);
+    header.m_ObjStamp = objStamp;
+    header.m_PngStamp = pngStamp;
+
+    header.m_VerticesCount = verticesCount;
+    header.m_FacesCount = facesCount;
+    header.m_TextureWidth = texture.m_Mips[0].m_Width;
+    header.m_TextureHeight = texture.m_Mips[0].m_Height;
+    header.m_TextureLayout = scast<u32>(texture.m_Layout);
+    header.m_TextureMipsCount = scast<u32>(texture.m_NumMips);
+
+    header.m_VerticesXOffset = AlignMeshFileOffset(sizeof(MeshFileHeader));
+    header.m_VerticesYOffset = AlignMeshFileOffset(header.m_VerticesXOffset + (verticesCount * sizeof(float)));
+    header.m_VerticesZOffset = AlignMeshFileOffset(header.m_VerticesYOffset + (verticesCount * sizeof(float)));
+    header.m_FacesOffset = AlignMeshFileOffset(header.m_VerticesZOffset + (verticesCount * sizeof(float)));
+    header.m_TexelsOffset = AlignMeshFileOffset(header.m_FacesOffset + (facesCount * sizeof(Face)));
+    header.m_MortonTablesOffset = AlignMeshFileOffset(header.m_TexelsOffset + (GetTextureTexelsCount(texture) * sizeof(u32)));
+    header.m_FileSize = header.m_MortonTablesOffset + (GetTextureMortonTablesCount(texture) * sizeof(u32));
+
+    return header;
+}
+
+bool MapCookedMesh(
+    const char* const objFileName,
+    const char* const pngFileName,
+    CookedMesh* const outMesh
+)
+{
+    *outMesh = {};
+
+    char cookedFileName[512] = {};
+    if (!GetCookedMeshFileName(objFileName, cookedFileName, sizeof(cookedFileName)))
+    {
+        return false;
+    }
+
+    MappedFile file = {};
+    if (!MapFile(cookedFileName, &file))
+    {
+        LOG_INFO("No cooked mesh file: %s.", cookedFileName);
+        return false;
+    }
+
+    // NOTE(sbalse): The source files don't need to exist, e.g. when only the cooked files are shipped. If
+    // they do exist they must be the ones the mesh was cooked from.
+    FileStamp objStamp = {};
+    FileStamp pngStamp = {};
+    const bool hasObjStamp = GetFileStamp(objFileName, &objStamp);
+    const bool hasPngStamp = GetFileStamp(pngFileName, &pngStamp);
+
+    // NOTE(sbalse): Validate everything before handing out pointers into the file. The expected header
+    // is rebuilt from the counts in the file so a truncated or corrupted file is caught too.
+    MeshFileHeader header = {};
+    Texture texture = {};
+    bool isValid = file.m_Size >= sizeof(MeshFileHeader);
+    if (isValid)
+    {
+        std::memcpy(&header, file.m_Data, sizeof(MeshFileHeader));
+
+        // NOTE(sbalse): A texture size that isn't a power of two comes out different from the file.
+        texture = MakeTextureMips(header.m_TextureWidth, header.m_TextureHeight, scast<TextureLayout>(header.m_TextureLayout));
+        const MeshFileHeader expectedHeader = MakeMeshFileHeader(
+            header.m_ObjStamp,
+            header.m_PngStamp,
+            header.m_VerticesCount,
+            header.m_FacesCount,
+            texture
+        );
+
+        isValid = header.m_TextureLayout <= scast<u32>(TextureLayout::Morton)
+            && std::memcmp(&header, &expectedHeader, sizeof(MeshFileHeader)) == 0
+            && header.m_FileSize == file.m_Size;
+    }
+
+    if (isValid)
+    {
+        const Face* const faces = rcast<const Face*>(file.m_Data + header.m_FacesOffset);
+        isValid = AreFaceIndicesValid(faces, header.m_FacesCount, header.m_VerticesCount);
+    }
+
+    if (!isValid)
+    {
+        LOG_ERROR("Cooked mesh file is from another version or corrupted: %s.", cookedFileName);
+        UnmapFile(&file);
+        return false;
+    }
+
+    const bool isStale = (hasObjStamp && !FileStampEqual(objStamp, header.m_ObjStamp))
+        || (hasPngStamp && !FileStampEqual(pngStamp, header.m_PngStamp));
+    if (isStale)
+    {
+        LOG_INFO("Cooked mesh file is stale: %s.", cookedFileName);
+        UnmapFile(&file);
+        return false;
+    }
+
+    outMesh->m_File = file;
+    u8* const data = const_cast<u8*>(file.m_Data);
+    outMesh->m_VertexStreams.m_X = rcast<float*>(data + header.m_VerticesXOffset);
+    outMesh->m_VertexStreams.m_Y = rcast<float*>(data + header.m_VerticesYOffset);
+    outMesh->m_VertexStreams.m_Z = rcast<float*>(data + header.m_VerticesZOffset);
+    outMesh->m_VerticesCount = header.m_VerticesCount;
+    outMesh->m_Faces = rcast<const Face*>(file.m_Data + header.m_FacesOffset);
+    outMesh->m_FacesCount = header.m_FacesCount;
+
+    if (texture.m_NumMips > 0)
+    {
+        texture.m_Texels = rcast<const u32*>(file.m_Data + header.m_TexelsOffset);
+        if (texture.m_Layout == TextureLayout::Morton)
+        {
+            texture.m_MortonTables = rcast<const u32*>(file.m_Data + header.m_MortonTablesOffset);
+        }
+    }
+    outMesh->m_Texture = texture;
+
+    return true;
+}
+
+void UnmapCookedMesh(CookedMesh* const mesh)
+{
+    UnmapFile(&mesh->m_File);
+    *mesh = {};
+}
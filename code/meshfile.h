@@ -0,0 +1,102 @@
+#pragma once
+#include "common.h"
+#include "vector.h"
+#include "triangle.h"
+#include "fileio.h"
+#include "texture.h"
+#include "vertexkernels.h"
+
+// NOTE(sbalse): A cooked mesh file (.mesh) holds everything LoadMesh() needs from an OBJ and PNG file pair
+// in the exact in-memory layout the renderer uses, so it can be memory mapped and used as is.
+//
+//   +--------------------+  offset 0
+//   |   MeshFileHeader   |
+//   +--------------------+  m_VerticesXOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   float vertex x   |
+//   +--------------------+  m_VerticesYOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   float vertex y   |
+//   +--------------------+  m_VerticesZOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   float vertex z   |
+//   +--------------------+  m_FacesOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   Face faces       |
+//   +--------------------+  m_TexelsOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   u32 texels       |
+//   +--------------------+  m_MortonTablesOffset (MESH_FILE_ALIGNMENT aligned)
+//   |   u32 Morton tables|
+//   +--------------------+  m_FileSize
+//
+// The vertices are stored as the x, y and z streams of Vec3Streams, so the vertex kernels read them straight
+// from the mapped file. The texels are the whole power of two mip chain that CreateTexture() builds, in the
+// texture layout the mesh was cooked with. The Morton tables are only there for TextureLayout::Morton. The
+// files are written by the MeshCook tool. Bump MESH_FILE_VERSION whenever the layout of the file, Face or
+// the texture changes so that old files are cooked again instead of being misread.
+
+inline constexpr u32 MESH_FILE_MAGIC = 0x4853454D; // NOTE(sbalse): "MESH" in a little endian file.
+inline constexpr u32 MESH_FILE_VERSION = 3;
+inline constexpr u64 MESH_FILE_ALIGNMENT = 64;
+static_assert(MESH_FILE_ALIGNMENT % VERTEX_STREAM_ALIGNMENT == 0);
+
+struct MeshFileHeader
+{
+    u32 m_Magic;
+    u32 m_Version;
+    u32 m_VertexComponentSize; // NOTE(sbalse): sizeof(float) and sizeof(Face) of the cook tool.
+    u32 m_FaceSize;
+
+    // NOTE(sbalse): The source files the mesh was cooked from. The cooked file is stale if they changed.
+    FileStamp m_ObjStamp;
+    FileStamp m_PngStamp;
+
+    u64 m_VerticesXOffset;
+    u64 m_VerticesYOffset;
+    u64 m_VerticesZOffset;
+    u64 m_VerticesCount;
+    u64 m_FacesOffset;
+    u64 m_FacesCount;
+    u64 m_TexelsOffset;
+    u64 m_MortonTablesOffset;
+    u32 m_TextureWidth; // NOTE(sbalse): Of mip level 0, so powers of two. 0 for a mesh without a texture.
+    u32 m_TextureHeight;
+    u32 m_TextureLayout; // NOTE(sbalse): A TextureLayout.
+    u32 m_TextureMipsCount;
+
+    u64 m_FileSize;
+};
+
+// NOTE(sbalse): A mapped cooked mesh file. All the pointers point into the mapped file.
+struct CookedMesh
+{
+    MappedFile m_File;
+
+    // NOTE(sbalse): Only read from, the streams just share their type with the outputs of the vertex kernels.
+    Vec3Streams m_VertexStreams;
+    size_t m_VerticesCount;
+    const Face* m_Faces;
+    size_t m_FacesCount;
+
+    // NOTE(sbalse): The texture in the layout it was cooked with. Its texels and Morton tables point into the
+    // mapped file too.
+    Texture m_Texture;
+};
+
+// NOTE(sbalse): The cooked file name of an OBJ file, the same path with a .mesh extension. Returns false if
+// it doesn't fit in the output buffer.
+bool GetCookedMeshFileName(const char* const objFileName, char* const outFileName, const size_t outFileNameSize);
+
+// NOTE(sbalse): Fill in the counts, sizes and offsets of a header.
+MeshFileHeader MakeMeshFileHeader(
+    const FileStamp objStamp,
+    const FileStamp pngStamp,
+    const size_t verticesCount,
+    const size_t facesCount,
+    const Texture& texture
+);
+
+// NOTE(sbalse): Map the cooked file of the OBJ and PNG pair. Returns false if the cooked file is missing,
+// from another version or stale, in which case the OBJ and PNG files have to be loaded instead.
+bool MapCookedMesh(
+    const char* const objFileName,
+    const char* const pngFileName,
+    CookedMesh* const outMesh
+);
+void UnmapCookedMesh(CookedMesh* const mesh);
@@ -0,0 +1,510 @@
+#include "objparser.h"
+
+#include <charconv>
+#include <cstring>
+#include <iterator>
+
+#include "colorlibrary.h"
+#include "profile.h"
+
+// NOTE(sbalse): Max number of corners of a single OBJ face. Faces with more corners are skipped.
+inline constexpr int MAX_OBJ_FACE_CORNERS = 64;
+
+// NOTE(sbalse): Floats with at most this many significant digits fit exactly in the 24 bit float
+// mantissa.
+inline constexpr int MAX_FAST_FLOAT_DIGITS = 7;
+
+// NOTE(sbalse): Powers of ten that are exactly representable as floats. Multiplying or dividing an exact
+// mantissa by one of them is a single correctly rounded operation, which gives the same result as a
+// correctly rounded parse of the whole string.
+inline constexpr float EXACT_FLOAT_POWERS_OF_TEN[] =
+{
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+inline constexpr int MAX_FAST_FLOAT_EXPONENT = scast<int>(std::size(EXACT_FLOAT_POWERS_OF_TEN)) - 1;
+
+enum class ObjLineType
+{
+    Other,
+    Vertex,
+    TexCoordinate,
+    Face,
+};
+
+// NOTE(sbalse): One corner of an OBJ face, with the indices exactly as written in the file. 0 means the
+// index is not there (e.g. no texture coordinate in "v//vn" faces).
+struct ObjFaceCorner
+{
+    long m_VertexIndex;
+    long m_TexCoordinateIndex;
+};
+
+// NOTE(sbalse): Number of elements in an OBJ file. Found with a first pass over the file so that the
+// second pass can allocate arrays of exactly the right size.
+struct ObjElementCounts
+{
+    size_t m_VerticesCount;
+    size_t m_TexCoordinatesCount;
+    size_t m_TrianglesCount; // NOTE(sbalse): Faces with more than 3 corners count as several triangles.
+};
+
+static bool IsObjSpace(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool IsObjDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static const char* SkipObjSpaces(const char* at, const char* const end)
+{
+    while (at < end && IsObjSpace(*at))
+    {
+        at++;
+    }
+    return at;
+}
+
+// NOTE(sbalse): Returns the start of the next line.
+static const char* SkipObjLine(const char* const at, const char* const end)
+{
+    const void* const newLine = std::memchr(at, '\n', scast<size_t>(end - at));
+    return newLine ? (scast<const char*>(newLine) + 1) : end;
+}
+
+// NOTE(sbalse): Find out what the line starting at `at` contains and return the position just after the
+// keyword.
+static ObjLineType GetObjLineType(const char* const at, const char* const end, const char** const outAfterKeyword)
+{
+    const size_t remaining = scast<size_t>(end - at);
+
+    if (remaining >= 2 && at[0] == 'v' && IsObjSpace(at[1]))
+    {
+        *outAfterKeyword = at + 2;
+        return ObjLineType::Vertex;
+    }
+    if (remaining >= 3 && at[0] == 'v' && at[1] == 't' && IsObjSpace(at[2]))
+    {
+        *outAfterKeyword = at + 3;
+        return ObjLineType::TexCoordinate;
+    }
+    if (remaining >= 2 && at[0] == 'f' && IsObjSpace(at[1]))
+    {
+        *outAfterKeyword = at + 2;
+        return ObjLineType::Face;
+    }
+
+    *outAfterKeyword = at;
+    return ObjLineType::Other;
+}
+
+// NOTE(sbalse): Parse a (possibly signed) integer. Returns the position after the number, or begin if
+// there is no number.
+static const char* ParseObjInt(const char* const begin, const char* const end, long* const outValue)
+{
+    const char* at = begin;
+
+    bool isNegative = false;
+    if (at < end && (*at == '-' || *at == '+'))
+    {
+        isNegative = (*at == '-');
+        at++;
+    }
+
+    const char* const digitsBegin = at;
+    long value = 0;
+    while (at < end && IsObjDigit(*at))
+    {
+        // NOTE(sbalse): Saturate instead of overflowing. Such indices are out of range anyway.
+        if (value < 100000000)
+        {
+            value = (value * 10) + (*at - '0');
+        }
+        at++;
+    }
+
+    if (at == digitsBegin)
+    {
+        return begin;
+    }
+
+    *outValue = isNegative ? -value : value;
+    return at;
+}
+
+// NOTE(sbalse): Parse a float like std::from_chars(), but also accepting a leading '+'. Numbers with
+// few enough digits (which is almost all of them in OBJ files) are parsed directly. Everything else is
+// handed to std::from_chars(). Returns the position after the number, or begin if there is no number.
+static const char* ParseObjFloat(const char* const begin, const char* const end, float* const outValue)
+{
+    const char* at = begin;
+
+    bool isNegative = false;
+    if (at < end && (*at == '-' || *at == '+'))
+    {
+        isNegative = (*at == '-');
+        at++;
+    }
+    const char* const unsignedBegin = at;
+
+    u32 mantissa = 0;
+    int numSignificantDigits = 0;
+    int numDigits = 0;
+    int exponent = 0;
+
+    // NOTE(sbalse): Integer part.
+    while (at < end && IsObjDigit(*at))
+    {
+        if (mantissa != 0 || *at != '0')
+        {
+            numSignificantDigits++;
+        }
+        mantissa = (numSignificantDigits <= MAX_FAST_FLOAT_DIGITS) ? (mantissa * 10) + (*at - '0') : mantissa;
+        numDigits++;
+        at++;
+    }
+
+    // NOTE(sbalse): Fractional part.
+    if (at < end && *at == '.')
+    {
+        at++;
+        while (at < end && IsObjDigit(*at))
+        {
+            if (mantissa != 0 || *at != '0')
+            {
+                numSignificantDigits++;
+            }
+            mantissa = (numSignificantDigits <= MAX_FAST_FLOAT_DIGITS) ? (mantissa * 10) + (*at - '0') : mantissa;
+            exponent--;
+            numDigits++;
+            at++;
+        }
+    }
+
+    // NOTE(sbalse): Exponent.
+    if (numDigits > 0 && at < end && (*at == 'e' || *at == 'E'))
+    {
+        long exponentValue = 0;
+        const char* const afterExponent = ParseObjInt(at + 1, end, &exponentValue);
+        if (afterExponent != at + 1)
+        {
+            exponent += scast<int>(exponentValue);
+            at = afterExponent;
+        }
+    }
+
+    const bool isFastPath =
+        numDigits > 0
+        && numSignificantDigits <= MAX_FAST_FLOAT_DIGITS
+        && exponent >= -MAX_FAST_FLOAT_EXPONENT
+        && exponent <= MAX_FAST_FLOAT_EXPONENT;
+
+    if (isFastPath)
+    {
+        float value = scast<float>(mantissa);
+        if (exponent >= 0)
+        {
+            value *= EXACT_FLOAT_POWERS_OF_TEN[exponent];
+        }
+        else
+        {
+            value /= EXACT_FLOAT_POWERS_OF_TEN[-exponent];
+        }
+
+        *outValue = isNegative ? -value : value;
+        return at;
+    }
+
+    // NOTE(sbalse): Slow path for long mantissas, huge exponents, inf and nan. std::from_chars() handles
+    // the '-' itself but not a '+'.
+    const char* const fromCharsBegin = (begin < end && *begin == '+') ? unsignedBegin : begin;
+    float value = 0.0f;
+    const std::from_chars_result result = std::from_chars(fromCharsBegin, end, value);
+    if (result.ec != std::errc())
+    {
+        return begin;
+    }
+
+    *outValue = value;
+    return result.ptr;
+}
+
+// NOTE(sbalse): Parse up to `count` floats separated by spaces. Missing values are left untouched.
+static void ParseObjFloats(const char* at, const char* const end, float* const outValues[], const int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        at = SkipObjSpaces(at, end);
+        const char* const next = ParseObjFloat(at, end, outValues[i]);
+        if (next == at)
+        {
+            return;
+        }
+        at = next;
+    }
+}
+
+// NOTE(sbalse): Parse the corners of a face line. Handles the "v", "v/vt", "v//vn" and "v/vt/vn" forms.
+// Returns the number of corners, or 0 if the line is malformed or has too many corners.
+static int ParseObjFaceCorners(
+    const char* at,
+    const char* const end,
+    ObjFaceCorner outCorners[MAX_OBJ_FACE_CORNERS])
+{
+    int numCorners = 0;
+
+    while (true)
+    {
+        at = SkipObjSpaces(at, end);
+        if (at == end || *at == '\n' || *at == '#')
+        {
+            break;
+        }
+
+        if (numCorners == MAX_OBJ_FACE_CORNERS)
+        {
+            return 0;
+        }
+
+        ObjFaceCorner corner = {};
+
+        const char* next = ParseObjInt(at, end, &corner.m_VertexIndex);
+        if (next == at || corner.m_VertexIndex == 0)
+        {
+            return 0;
+        }
+        at = next;
+
+        if (at < end && *at == '/')
+        {
+            at++;
+
+            // NOTE(sbalse): The texture coordinate index is optional ("v//vn").
+            if (at < end && *at != '/')
+            {
+                next = ParseObjInt(at, end, &corner.m_TexCoordinateIndex);
+                if (next == at)
+                {
+                    return 0;
+                }
+                at = next;
+            }
+
+            // NOTE(sbalse): We don't use the normals but still need to skip over them.
+            if (at < end && *at == '/')
+            {
+                long normalIndex = 0;
+                at = ParseObjInt(at + 1, end, &normalIndex);
+            }
+        }
+
+        // NOTE(sbalse): Something other than a separator after the corner means the line is malformed.
+        if (at < end && !IsObjSpace(*at) && *at != '\n' && *at != '#')
+        {
+            return 0;
+        }
+
+        outCorners[numCorners++] = corner;
+    }
+
+    return numCorners;
+}
+
+// NOTE(sbalse): Turn a 1 based (or negative, relative to the end) OBJ index into a 0 based index.
+// elementsSoFar is the number of elements of that type that came before the index in the file. Returns
+// -1 if the index is out of range.
+static long ResolveObjIndex(const long index, const size_t elementsSoFar, const size_t totalElements)
+{
+    const long resolved = (index > 0) ? (index - 1) : (scast<long>(elementsSoFar) + index);
+    if (resolved < 0 || scast<size_t>(resolved) >= totalElements)
+    {
+        return -1;
+    }
+
+    return resolved;
+}
+
+// NOTE(sbalse): First pass over the OBJ text, only counts the elements.
+static ObjElementCounts CountObjElements(const char* const data, const size_t size)
+{
+    PROFILE_EVENT();
+
+    ObjElementCounts result = {};
+
+    ObjFaceCorner corners[MAX_OBJ_FACE_CORNERS] = {};
+
+    const char* const end = data + size;
+    const char* at = data;
+    while (at < end)
+    {
+        at = SkipObjSpaces(at, end);
+
+        const char* afterKeyword = nullptr;
+        switch (GetObjLineType(at, end, &afterKeyword))
+        {
+        case ObjLineType::Vertex:
+        {
+            result.m_VerticesCount++;
+        } break;
+
+        case ObjLineType::TexCoordinate:
+        {
+            result.m_TexCoordinatesCount++;
+        } break;
+
+        case ObjLineType::Face:
+        {
+            const int numCorners = ParseObjFaceCorners(afterKeyword, end, corners);
+            if (numCorners >= 3)
+            {
+                result.m_TrianglesCount += numCorners - 2;
+            }
+        } break;
+
+        default:
+        {
+        } break;
+        }
+
+        at = SkipObjLine(afterKeyword, end);
+    }
+
+    return result;
+}
+
+ObjMesh ParseObj(Arena* const arena, const char* const data, const size_t size)
+{
+    PROFILE_EVENT();
+
+    ObjMesh result = {};
+
+    const size_t startArenaOffset = arena->m_CurrOffset;
+
+    // NOTE(sbalse): Count everything first so that all the arrays can be allocated with the right size.
+    const ObjElementCounts counts = CountObjElements(data, size);
+
+    // NOTE(sbalse): Allocate memory for vertices and faces from the arena.
+    result.m_VertexStreams = PushVec3Streams(arena, counts.m_VerticesCount);
+    result.m_Faces = PushArray(arena, Face, counts.m_TrianglesCount);
+
+    TempArena temp = TempArenaBegin(arena);
+    Tex2* const texCoordinates = PushArray(temp.m_OriginalArena, Tex2, counts.m_TexCoordinatesCount);
+    size_t texCoordinatesCount = 0;
+
+    // NOTE(sbalse): The texture coordinates are the last allocation so this is the most memory the
+    // parser uses at once.
+    result.m_PeakArenaBytes = arena->m_CurrOffset - startArenaOffset;
+
+    ObjFaceCorner corners[MAX_OBJ_FACE_CORNERS] = {};
+
+    const char* const end = data + size;
+    const char* at = data;
+    while (at < end)
+    {
+        at = SkipObjSpaces(at, end);
+
+        const char* afterKeyword = nullptr;
+        switch (GetObjLineType(at, end, &afterKeyword))
+        {
+        // NOTE(sbalse): Read vertex information.
+        case ObjLineType::Vertex:
+        {
+            const size_t index = result.m_VerticesCount++;
+            float* const values[] =
+            {
+                &result.m_VertexStreams.m_X[index],
+                &result.m_VertexStreams.m_Y[index],
+                &result.m_VertexStreams.m_Z[index],
+            };
+            ParseObjFloats(afterKeyword, end, values, 3);
+        } break;
+
+        // NOTE(sbalse): Texture coordinate information.
+        case ObjLineType::TexCoordinate:
+        {
+            Tex2 texcoord = {};
+            float* const values[] = { &texcoord.m_U, &texcoord.m_V };
+            ParseObjFloats(afterKeyword, end, values, 2);
+            PushStruct(texcoord, texCoordinates, texCoordinatesCount);
+        } break;
+
+        // NOTE(sbalse): Read face information.
+        case ObjLineType::Face:
+        {
+            const int numCorners = ParseObjFaceCorners(afterKeyword, end, corners);
+            if (numCorners < 3)
+            {
+                result.m_SkippedFacesCount++;
+                break;
+            }
+
+            // NOTE(sbalse): Resolve the indices of all the corners first so that a face with a bad index
+            // is skipped completely.
+            long vertexIndices[MAX_OBJ_FACE_CORNERS] = {};
+            Tex2 uvs[MAX_OBJ_FACE_CORNERS] = {};
+            bool isFaceValid = true;
+
+            for (int i = 0; i < numCorners; i++)
+            {
+                vertexIndices[i] = ResolveObjIndex(
+                    corners[i].m_VertexIndex,
+                    result.m_VerticesCount,
+                    counts.m_VerticesCount
+                );
+                isFaceValid = isFaceValid && (vertexIndices[i] >= 0);
+
+                // NOTE(sbalse): Faces without texture coordinates get (0, 0).
+                if (corners[i].m_TexCoordinateIndex != 0)
+                {
+                    const long texCoordinateIndex = ResolveObjIndex(
+                        corners[i].m_TexCoordinateIndex,
+                        texCoordinatesCount,
+                        counts.m_TexCoordinatesCount
+                    );
+                    isFaceValid = isFaceValid && (texCoordinateIndex >= 0);
+                    if (texCoordinateIndex >= 0)
+                    {
+                        uvs[i] = texCoordinates[texCoordinateIndex];
+                    }
+                }
+            }
+
+            if (!isFaceValid)
+            {
+                result.m_SkippedFacesCount++;
+                break;
+            }
+
+            // NOTE(sbalse): Triangulate faces with more than 3 corners as a fan around the first corner.
+            // This is only correct for convex faces, which is what OBJ exporters write.
+            for (int i = 1; i + 1 < numCorners; i++)
+            {
+                const Face face =
+                {
+                    .m_A = scast<int>(vertexIndices[0]),
+                    .m_B = scast<int>(vertexIndices[i]),
+                    .m_C = scast<int>(vertexIndices[i + 1]),
+                    .m_AUV = uvs[0],
+                    .m_BUV = uvs[i],
+                    .m_CUV = uvs[i + 1],
+                    .m_Color = WHITE,
+                };
+
+                PushStruct(face, result.m_Faces, result.m_FacesCount);
+            }
+        } break;
+
+        default:
+        {
+        } break;
+        }
+
+        at = SkipObjLine(afterKeyword, end);
+    }
+
+    TempArenaEnd(&temp);
+
+    return result;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "common.h"
+#include "arena.h"
+#include "vector.h"
+#include "triangle.h"
+#include "vertexkernels.h"
+
+// NOTE(sbalse): The geometry of an OBJ file. Faces with more than 3 corners are already triangulated.
+struct ObjMesh
+{
+    Vec3Streams m_VertexStreams; // NOTE(sbalse): In the stream layout the renderer uses, no copy needed.
+    size_t m_VerticesCount;
+
+    Face* m_Faces;
+    size_t m_FacesCount;
+
+    size_t m_SkippedFacesCount; // NOTE(sbalse): Malformed faces and faces with out of range indices.
+    size_t m_PeakArenaBytes; // NOTE(sbalse): Most arena memory in use at once while parsing.
+};
+
+// NOTE(sbalse): Parse the OBJ text in [data, data + size). The text doesn't need to be null terminated
+// so it can be a memory mapped file. The vertices and faces are allocated from the arena.
+ObjMesh ParseObj(Arena* const arena, const char* const data, const size_t size);
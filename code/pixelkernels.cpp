@@ -0,0 +1,1404 @@
+#include "pixelkernels.h"
+
+#include <cstdlib>
+#include <bit>
+#include <algorithm>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+constinit static TexelFetchCallback g_TexelFetchCallback = nullptr;
+
+// NOTE(sbalse): cpuid with the given leaf and sub-leaf. cpuInfo gets eax, ebx, ecx and edx.
+static void GetCpuId(int cpuInfo[4], const int leaf, const int subLeaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(cpuInfo, leaf, subLeaf);
+#else
+    unsigned int registers[4] = {};
+    __get_cpuid_count(leaf, subLeaf, &registers[0], &registers[1], &registers[2], &registers[3]);
+    for (int i = 0; i < 4; i++)
+    {
+        cpuInfo[i] = scast<int>(registers[i]);
+    }
+#endif
+}
+
+static TARGET_XSAVE bool CpuSupportsAVX2()
+{
+    int cpuInfo[4] = {};
+
+    GetCpuId(cpuInfo, 0, 0);
+    const int maxLeaf = cpuInfo[0];
+    if (maxLeaf < 7)
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): The CPU needs to support AVX and the OS needs to save the YMM registers on context
+    // switches (OSXSAVE set and the SSE and AVX state bits enabled in XCR0).
+    GetCpuId(cpuInfo, 1, 0);
+    const bool hasOSXSAVE = (cpuInfo[2] & (1 << 27)) != 0;
+    const bool hasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+    if (!hasOSXSAVE || !hasAVX)
+    {
+        return false;
+    }
+
+    if ((_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    GetCpuId(cpuInfo, 7, 0);
+    return (cpuInfo[1] & (1 << 5)) != 0;
+}
+
+// NOTE(sbalse): The part of the span starting at pixel `start`. Used by the vector kernels to draw the
+// pixels left over after the last full group with the scalar kernel.
+static Span GetSpanTail(const SpanTriangle& triangle, const Span& span, const int start)
+{
+    Span result = span;
+    result.m_Colors += start;
+    result.m_Depths += start;
+    result.m_Count -= start;
+    for (int i = 0; i < 3; i++)
+    {
+        result.m_Edges[i] += triangle.m_EdgeStepX[i] * start;
+    }
+    return result;
+}
+
+/******** NOTE(sbalse): Scalar kernels. ***********/
+
+// NOTE(sbalse): Whether a pixel at the given depth is drawn over the stored one.
+static bool DepthTestScalar(const SpanTriangle& triangle, const float depth, const float storedDepth)
+{
+    return (triangle.m_DepthTestMethod == DepthTestMethod::LessEqual)
+        ? (depth <= storedDepth)
+        : (depth < storedDepth);
+}
+
+static int DrawDepthSpanScalar(const SpanTriangle& triangle, const Span& span)
+{
+    const Vec3 reciprocalW = triangle.m_ReciprocalW;
+
+    i64 e0 = span.m_Edges[0];
+    i64 e1 = span.m_Edges[1];
+    i64 e2 = span.m_Edges[2];
+
+    int numWritten = 0;
+    for (int i = 0; i < span.m_Count; i++)
+    {
+        const float weight0 = scast<float>(e0) * triangle.m_InvArea;
+        const float weight1 = scast<float>(e1) * triangle.m_InvArea;
+        const float weight2 = scast<float>(e2) * triangle.m_InvArea;
+
+        const float interpolatedReciprocalW =
+            (reciprocalW.m_X * weight0)
+            + (reciprocalW.m_Y * weight1)
+            + (reciprocalW.m_Z * weight2);
+        const float depth = 1.0f - interpolatedReciprocalW;
+
+        if (DepthTestScalar(triangle, depth, span.m_Depths[i]))
+        {
+            span.m_Depths[i] = depth;
+            numWritten++;
+        }
+
+        e0 += triangle.m_EdgeStepX[0];
+        e1 += triangle.m_EdgeStepX[1];
+        e2 += triangle.m_EdgeStepX[2];
+    }
+
+    return numWritten;
+}
+
+static int DrawFilledSpanScalar(const SpanTriangle& triangle, const Span& span)
+{
+    const Vec3 reciprocalW = triangle.m_ReciprocalW;
+
+    i64 e0 = span.m_Edges[0];
+    i64 e1 = span.m_Edges[1];
+    i64 e2 = span.m_Edges[2];
+
+    int numShaded = 0;
+    for (int i = 0; i < span.m_Count; i++)
+    {
+        const float weight0 = scast<float>(e0) * triangle.m_InvArea;
+        const float weight1 = scast<float>(e1) * triangle.m_InvArea;
+        const float weight2 = scast<float>(e2) * triangle.m_InvArea;
+
+        // NOTE(sbalse): Interpolate the value of 1/w.
+        const float interpolatedReciprocalW =
+            (reciprocalW.m_X * weight0)
+            + (reciprocalW.m_Y * weight1)
+            + (reciprocalW.m_Z * weight2);
+
+        // NOTE(sbalse): Adjust 1/w so that pixels that are closer to the camera have smaller values.
+        const float depth = 1.0f - interpolatedReciprocalW;
+
+        // NOTE(sbalse): Only draw the pixel if the depth value is less than the one previously stored
+        // in the z-buffer.
+        if (DepthTestScalar(triangle, depth, span.m_Depths[i]))
+        {
+            span.m_Colors[i] = triangle.m_Color;
+            span.m_Depths[i] = depth;
+            numShaded++;
+        }
+
+        e0 += triangle.m_EdgeStepX[0];
+        e1 += triangle.m_EdgeStepX[1];
+        e2 += triangle.m_EdgeStepX[2];
+    }
+
+    return numShaded;
+}
+
+// NOTE(sbalse): Square of the number of level 0 texels the pixel covers along its longer screen axis, from
+// the u and v of the pixel (not yet scaled to texels) and its 1/w.
+static float GetTexelsPerPixelSquaredScalar(
+    const SpanTriangle& triangle,
+    const float u,
+    const float v,
+    const float reciprocalW)
+{
+    const float dudx = triangle.m_TexelUOverWStep[0] - (u * triangle.m_ReciprocalWStepU[0]);
+    const float dvdx = triangle.m_TexelVOverWStep[0] - (v * triangle.m_ReciprocalWStepV[0]);
+    const float dudy = triangle.m_TexelUOverWStep[1] - (u * triangle.m_ReciprocalWStepU[1]);
+    const float dvdy = triangle.m_TexelVOverWStep[1] - (v * triangle.m_ReciprocalWStepV[1]);
+
+    const float lengthXSquared = (dudx * dudx) + (dvdx * dvdx);
+    const float lengthYSquared = (dudy * dudy) + (dvdy * dvdy);
+    return std::max(lengthXSquared, lengthYSquared) / (reciprocalW * reciprocalW);
+}
+
+// NOTE(sbalse): The bilinear sampler works on level 0 texel coordinates in 24.8 fixed point. The vector
+// kernels keep them in 32 bit lanes, so u and v times the texture size have to stay below 2^23.
+inline constexpr int BILINEAR_FRACTION_BITS = 8;
+inline constexpr int BILINEAR_ONE = 1 << BILINEAR_FRACTION_BITS;
+
+// NOTE(sbalse): Two of the four 8 bit channels of a texel, each in the low byte of a 16 bit half.
+inline constexpr u32 TEXEL_CHANNEL_PAIR_MASK = 0x00FF00FF;
+
+// NOTE(sbalse): The four texels around a bilinear sample of a mip level and how far the sample is past the
+// first one, in 1/256 of a texel.
+struct BilinearTexels
+{
+    u32 m_Texels[4]; // NOTE(sbalse): x0y0, x1y0, x0y1 and x1y1.
+    u32 m_WeightX;
+    u32 m_WeightY;
+};
+
+// NOTE(sbalse): The texels of a bilinear sample at the fixed point level 0 coordinates. The coordinates are
+// moved to the level and half a texel back, so the weights are relative to the texel centers. The texels
+// past the edge of the level wrap around to the other side.
+static BilinearTexels FetchBilinearTexelsScalar(
+    const Texture& texture,
+    const int level,
+    const u32 fixedX,
+    const u32 fixedY)
+{
+    const TextureMip& mip = texture.m_Mips[level];
+
+    const int x = scast<int>(fixedX >> level) - (BILINEAR_ONE / 2);
+    const int y = scast<int>(fixedY >> level) - (BILINEAR_ONE / 2);
+    const u32 x0 = scast<u32>(x >> BILINEAR_FRACTION_BITS) & mip.m_WidthMask;
+    const u32 y0 = scast<u32>(y >> BILINEAR_FRACTION_BITS) & mip.m_HeightMask;
+    const u32 xs[2] = { x0, (x0 + 1) & mip.m_WidthMask };
+    const u32 ys[2] = { y0, (y0 + 1) & mip.m_HeightMask };
+
+    BilinearTexels result = {};
+    for (int i = 0; i < 4; i++)
+    {
+        const u32* const texel = texture.m_Texels + GetTexelIndex(texture, level, xs[i & 1], ys[i >> 1]);
+        if (g_TexelFetchCallback)
+        {
+            g_TexelFetchCallback(texel);
+        }
+        result.m_Texels[i] = *texel;
+    }
+    result.m_WeightX = scast<u32>(x) & (BILINEAR_ONE - 1);
+    result.m_WeightY = scast<u32>(y) & (BILINEAR_ONE - 1);
+    return result;
+}
+
+// NOTE(sbalse): a + (b - a) * weight / 256 for both channels of a channel pair at once. Each product is at
+// most 255 * 256, so the two halves never carry into each other.
+static u32 LerpTexelChannelPairScalar(const u32 a, const u32 b, const u32 weight)
+{
+    return (((a * (BILINEAR_ONE - weight)) + (b * weight)) >> BILINEAR_FRACTION_BITS) & TEXEL_CHANNEL_PAIR_MASK;
+}
+
+// NOTE(sbalse): Blend the texels along x first and then along y, one channel pair at a time.
+static u32 BlendBilinearScalar(const BilinearTexels& texels)
+{
+    u32 result = 0;
+    for (int shift = 0; shift < 16; shift += 8)
+    {
+        const u32 texel00 = (texels.m_Texels[0] >> shift) & TEXEL_CHANNEL_PAIR_MASK;
+        const u32 texel10 = (texels.m_Texels[1] >> shift) & TEXEL_CHANNEL_PAIR_MASK;
+        const u32 texel01 = (texels.m_Texels[2] >> shift) & TEXEL_CHANNEL_PAIR_MASK;
+        const u32 texel11 = (texels.m_Texels[3] >> shift) & TEXEL_CHANNEL_PAIR_MASK;
+
+        const u32 top = LerpTexelChannelPairScalar(texel00, texel10, texels.m_WeightX);
+        const u32 bottom = LerpTexelChannelPairScalar(texel01, texel11, texels.m_WeightX);
+        result |= LerpTexelChannelPairScalar(top, bottom, texels.m_WeightY) << shift;
+    }
+    return result;
+}
+
+static int DrawFilteredTexturedSpanScalar(const SpanTriangle& triangle, const Span& span, const TextureFilterMethod filter)
+{
+    const Vec3 reciprocalW = triangle.m_ReciprocalW;
+    const Tex2 aUV = triangle.m_UVOverW[0];
+    const Tex2 bUV = triangle.m_UVOverW[1];
+    const Tex2 cUV = triangle.m_UVOverW[2];
+    const Texture& texture = *triangle.m_Texture;
+    const float textureWidth = scast<float>(texture.m_Mips[0].m_Width);
+    const float textureHeight = scast<float>(texture.m_Mips[0].m_Height);
+    const float fixedTextureWidth = scast<float>(texture.m_Mips[0].m_Width * BILINEAR_ONE);
+    const float fixedTextureHeight = scast<float>(texture.m_Mips[0].m_Height * BILINEAR_ONE);
+    const bool isMipLevelPerPixel = triangle.m_MinMipLevel != triangle.m_MaxMipLevel;
+
+    i64 e0 = span.m_Edges[0];
+    i64 e1 = span.m_Edges[1];
+    i64 e2 = span.m_Edges[2];
+
+    int numShaded = 0;
+    for (int i = 0; i < span.m_Count; i++)
+    {
+        const float weight0 = scast<float>(e0) * triangle.m_InvArea;
+        const float weight1 = scast<float>(e1) * triangle.m_InvArea;
+        const float weight2 = scast<float>(e2) * triangle.m_InvArea;
+
+        e0 += triangle.m_EdgeStepX[0];
+        e1 += triangle.m_EdgeStepX[1];
+        e2 += triangle.m_EdgeStepX[2];
+
+        const float interpolatedReciprocalW =
+            (reciprocalW.m_X * weight0)
+            + (reciprocalW.m_Y * weight1)
+            + (reciprocalW.m_Z * weight2);
+
+        // NOTE(sbalse): Adjust 1/w so that pixels closer to the camera have smaller values.
+        const float depth = 1.0f - interpolatedReciprocalW;
+
+        // NOTE(sbalse): Early Z. Hidden pixels skip the UV reconstruction and the texture fetch below.
+        if (!DepthTestScalar(triangle, depth, span.m_Depths[i]))
+        {
+            continue;
+        }
+
+        // NOTE(sbalse): Calculating barycentric coordinates gives us the interpolated U/w and V/w
+        // values. The 1/w factor is what performs perspective correction on our texture. Perspective
+        // correction is necessary otherwise the texture will appear distorted.
+        float interpolatedU = (aUV.m_U * weight0) + (bUV.m_U * weight1) + (cUV.m_U * weight2);
+        float interpolatedV = (aUV.m_V * weight0) + (bUV.m_V * weight1) + (cUV.m_V * weight2);
+
+        // NOTE(sbalse): Convert the interpolated U and V back into screen space by dividing them by
+        // the interpolated W.
+        interpolatedU /= interpolatedReciprocalW;
+        interpolatedV /= interpolatedReciprocalW;
+
+        int level = triangle.m_MinMipLevel;
+        if (isMipLevelPerPixel)
+        {
+            level = GetMipLevel(
+                GetTexelsPerPixelSquaredScalar(triangle, interpolatedU, interpolatedV, interpolatedReciprocalW),
+                triangle.m_MinMipLevel,
+                triangle.m_MaxMipLevel
+            );
+        }
+
+        if (filter == TextureFilterMethod::Bilinear)
+        {
+            const u32 fixedX = scast<u32>(std::abs(scast<int>(interpolatedU * fixedTextureWidth)));
+            const u32 fixedY = scast<u32>(std::abs(scast<int>(interpolatedV * fixedTextureHeight)));
+            span.m_Colors[i] = BlendBilinearScalar(FetchBilinearTexelsScalar(texture, level, fixedX, fixedY));
+        }
+        else
+        {
+            // NOTE(sbalse): The interpolated value will be between 0 and 1 so we need to multiply it by
+            // the texture width and height to map the UV coordinates to the full texture width and height.
+            const u32 texelX = scast<u32>(std::abs(scast<int>(interpolatedU * textureWidth)));
+            const u32 texelY = scast<u32>(std::abs(scast<int>(interpolatedV * textureHeight)));
+
+            const u32* const texel = texture.m_Texels + GetTexelIndexFromBaseCoordinates(texture, level, texelX, texelY);
+            if (g_TexelFetchCallback)
+            {
+                g_TexelFetchCallback(texel);
+            }
+            span.m_Colors[i] = *texel;
+        }
+
+        span.m_Depths[i] = depth;
+        numShaded++;
+    }
+
+    return numShaded;
+}
+
+static int DrawTexturedSpanScalar(const SpanTriangle& triangle, const Span& span)
+{
+    return DrawFilteredTexturedSpanScalar(triangle, span, TextureFilterMethod::Nearest);
+}
+
+static int DrawBilinearTexturedSpanScalar(const SpanTriangle& triangle, const Span& span)
+{
+    return DrawFilteredTexturedSpanScalar(triangle, span, TextureFilterMethod::Bilinear);
+}
+
+/*
+NOTE(sbalse): The vector kernels do exactly the same float operations in the same order as the scalar
+ones, so they produce bit identical images.
+
+The edge function values are kept in 32 bit lanes. The lanes wrap around on overflow, but since the values
+inside the triangle are between 0 and the triangle area, the lanes of pixels inside the span still hold the
+exact values as long as the area fits in 31 bits.
+*/
+
+/******** NOTE(sbalse): SSE2 kernels, 4 pixels at a time. ***********/
+
+inline constexpr int SSE2_LANES = 4;
+
+// NOTE(sbalse): Edge function values of the first group of pixels and how much they change per group.
+static void SetupEdgeLanesSSE2(
+    const SpanTriangle& triangle,
+    const Span& span,
+    __m128i outEdges[3],
+    __m128i outGroupSteps[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        const u32 start = scast<u32>(span.m_Edges[i]);
+        const u32 step = scast<u32>(triangle.m_EdgeStepX[i]);
+        outEdges[i] = _mm_setr_epi32(
+            scast<int>(start),
+            scast<int>(start + step),
+            scast<int>(start + (step * 2)),
+            scast<int>(start + (step * 3))
+        );
+        outGroupSteps[i] = _mm_set1_epi32(scast<int>(step * SSE2_LANES));
+    }
+}
+
+// NOTE(sbalse): Per lane mask ? a : b.
+static __m128i SelectSSE2(const __m128i mask, const __m128i a, const __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static __m128i AbsSSE2(const __m128i value)
+{
+    const __m128i sign = _mm_srai_epi32(value, 31);
+    return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+}
+
+// NOTE(sbalse): Write the colors and depths of the lanes that passed the depth test.
+static void StorePixelsSSE2(
+    const Span& span,
+    const int i,
+    const __m128 depthMask,
+    const __m128i colors,
+    const __m128 depths)
+{
+    const __m128i mask = _mm_castps_si128(depthMask);
+
+    u32* const colorAddress = span.m_Colors + i;
+    float* const depthAddress = span.m_Depths + i;
+
+    const __m128i oldColors = _mm_loadu_si128(rcast<const __m128i*>(colorAddress));
+    _mm_storeu_si128(rcast<__m128i*>(colorAddress), SelectSSE2(mask, colors, oldColors));
+
+    const __m128 oldDepths = _mm_loadu_ps(depthAddress);
+    _mm_storeu_ps(depthAddress, _mm_or_ps(_mm_and_ps(depthMask, depths), _mm_andnot_ps(depthMask, oldDepths)));
+}
+
+static __m128 DepthTestSSE2(const SpanTriangle& triangle, const __m128 depths, const __m128 storedDepths)
+{
+    return (triangle.m_DepthTestMethod == DepthTestMethod::LessEqual)
+        ? _mm_cmple_ps(depths, storedDepths)
+        : _mm_cmplt_ps(depths, storedDepths);
+}
+
+// NOTE(sbalse): Same as GetTexelsPerPixelSquaredScalar() and GetMipLevel() for 4 pixels.
+static __m128i GetMipLevelsSSE2(
+    const SpanTriangle& triangle,
+    const __m128 u,
+    const __m128 v,
+    const __m128 reciprocalW)
+{
+    const __m128 dudx = _mm_sub_ps(_mm_set1_ps(triangle.m_TexelUOverWStep[0]), _mm_mul_ps(u, _mm_set1_ps(triangle.m_ReciprocalWStepU[0])));
+    const __m128 dvdx = _mm_sub_ps(_mm_set1_ps(triangle.m_TexelVOverWStep[0]), _mm_mul_ps(v, _mm_set1_ps(triangle.m_ReciprocalWStepV[0])));
+    const __m128 dudy = _mm_sub_ps(_mm_set1_ps(triangle.m_TexelUOverWStep[1]), _mm_mul_ps(u, _mm_set1_ps(triangle.m_ReciprocalWStepU[1])));
+    const __m128 dvdy = _mm_sub_ps(_mm_set1_ps(triangle.m_TexelVOverWStep[1]), _mm_mul_ps(v, _mm_set1_ps(triangle.m_ReciprocalWStepV[1])));
+
+    const __m128 lengthXSquared = _mm_add_ps(_mm_mul_ps(dudx, dudx), _mm_mul_ps(dvdx, dvdx));
+    const __m128 lengthYSquared = _mm_add_ps(_mm_mul_ps(dudy, dudy), _mm_mul_ps(dvdy, dvdy));
+    const __m128 texelsPerPixelSquared = _mm_div_ps(
+        _mm_max_ps(lengthXSquared, lengthYSquared),
+        _mm_mul_ps(reciprocalW, reciprocalW)
+    );
+
+    const __m128i exponents = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(texelsPerPixelSquared), 23), _mm_set1_epi32(127));
+    __m128i levels = _mm_srai_epi32(exponents, 1);
+
+    const __m128i minLevel = _mm_set1_epi32(triangle.m_MinMipLevel);
+    const __m128i maxLevel = _mm_set1_epi32(triangle.m_MaxMipLevel);
+    levels = SelectSSE2(_mm_cmplt_epi32(levels, minLevel), minLevel, levels);
+    levels = SelectSSE2(_mm_cmpgt_epi32(levels, maxLevel), maxLevel, levels);
+    return levels;
+}
+
+static int DrawDepthSpanSSE2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m128 invArea = _mm_set1_ps(triangle.m_InvArea);
+    const __m128 reciprocalW0 = _mm_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m128 reciprocalW1 = _mm_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m128 reciprocalW2 = _mm_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128i edges[3] = {};
+    __m128i groupSteps[3] = {};
+    SetupEdgeLanesSSE2(triangle, span, edges, groupSteps);
+
+    int numWritten = 0;
+    int i = 0;
+    for (; i + SSE2_LANES <= span.m_Count; i += SSE2_LANES)
+    {
+        const __m128 weight0 = _mm_mul_ps(_mm_cvtepi32_ps(edges[0]), invArea);
+        const __m128 weight1 = _mm_mul_ps(_mm_cvtepi32_ps(edges[1]), invArea);
+        const __m128 weight2 = _mm_mul_ps(_mm_cvtepi32_ps(edges[2]), invArea);
+
+        const __m128 interpolatedReciprocalW = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(reciprocalW0, weight0), _mm_mul_ps(reciprocalW1, weight1)),
+            _mm_mul_ps(reciprocalW2, weight2)
+        );
+        const __m128 depths = _mm_sub_ps(one, interpolatedReciprocalW);
+
+        float* const depthAddress = span.m_Depths + i;
+        const __m128 oldDepths = _mm_loadu_ps(depthAddress);
+        const __m128 depthMask = DepthTestSSE2(triangle, depths, oldDepths);
+        const int passedLanes = _mm_movemask_ps(depthMask);
+        if (passedLanes != 0)
+        {
+            _mm_storeu_ps(depthAddress, _mm_or_ps(_mm_and_ps(depthMask, depths), _mm_andnot_ps(depthMask, oldDepths)));
+            numWritten += std::popcount(scast<u32>(passedLanes));
+        }
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm_add_epi32(edges[edge], groupSteps[edge]);
+        }
+    }
+
+    if (i < span.m_Count)
+    {
+        numWritten += DrawDepthSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numWritten;
+}
+
+static int DrawFilledSpanSSE2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m128 invArea = _mm_set1_ps(triangle.m_InvArea);
+    const __m128 reciprocalW0 = _mm_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m128 reciprocalW1 = _mm_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m128 reciprocalW2 = _mm_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i color = _mm_set1_epi32(scast<int>(triangle.m_Color));
+
+    __m128i edges[3] = {};
+    __m128i groupSteps[3] = {};
+    SetupEdgeLanesSSE2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + SSE2_LANES <= span.m_Count; i += SSE2_LANES)
+    {
+        const __m128 weight0 = _mm_mul_ps(_mm_cvtepi32_ps(edges[0]), invArea);
+        const __m128 weight1 = _mm_mul_ps(_mm_cvtepi32_ps(edges[1]), invArea);
+        const __m128 weight2 = _mm_mul_ps(_mm_cvtepi32_ps(edges[2]), invArea);
+
+        const __m128 interpolatedReciprocalW = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(reciprocalW0, weight0), _mm_mul_ps(reciprocalW1, weight1)),
+            _mm_mul_ps(reciprocalW2, weight2)
+        );
+        const __m128 depths = _mm_sub_ps(one, interpolatedReciprocalW);
+
+        const __m128 depthMask = DepthTestSSE2(triangle, depths, _mm_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm_movemask_ps(depthMask);
+        if (passedLanes != 0)
+        {
+            StorePixelsSSE2(span, i, depthMask, color, depths);
+            numShaded += std::popcount(scast<u32>(passedLanes));
+        }
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm_add_epi32(edges[edge], groupSteps[edge]);
+        }
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawFilledSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+static int DrawTexturedSpanSSE2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m128 invArea = _mm_set1_ps(triangle.m_InvArea);
+    const __m128 reciprocalW0 = _mm_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m128 reciprocalW1 = _mm_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m128 reciprocalW2 = _mm_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m128 u0 = _mm_set1_ps(triangle.m_UVOverW[0].m_U);
+    const __m128 u1 = _mm_set1_ps(triangle.m_UVOverW[1].m_U);
+    const __m128 u2 = _mm_set1_ps(triangle.m_UVOverW[2].m_U);
+    const __m128 v0 = _mm_set1_ps(triangle.m_UVOverW[0].m_V);
+    const __m128 v1 = _mm_set1_ps(triangle.m_UVOverW[1].m_V);
+    const __m128 v2 = _mm_set1_ps(triangle.m_UVOverW[2].m_V);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    const Texture& texture = *triangle.m_Texture;
+    const __m128 textureWidth = _mm_set1_ps(scast<float>(texture.m_Mips[0].m_Width));
+    const __m128 textureHeight = _mm_set1_ps(scast<float>(texture.m_Mips[0].m_Height));
+    const bool isMipLevelPerPixel = triangle.m_MinMipLevel != triangle.m_MaxMipLevel;
+
+    __m128i edges[3] = {};
+    __m128i groupSteps[3] = {};
+    SetupEdgeLanesSSE2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + SSE2_LANES <= span.m_Count; i += SSE2_LANES)
+    {
+        const __m128 weight0 = _mm_mul_ps(_mm_cvtepi32_ps(edges[0]), invArea);
+        const __m128 weight1 = _mm_mul_ps(_mm_cvtepi32_ps(edges[1]), invArea);
+        const __m128 weight2 = _mm_mul_ps(_mm_cvtepi32_ps(edges[2]), invArea);
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm_add_epi32(edges[edge], groupSteps[edge]);
+        }
+
+        const __m128 interpolatedReciprocalW = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(reciprocalW0, weight0), _mm_mul_ps(reciprocalW1, weight1)),
+            _mm_mul_ps(reciprocalW2, weight2)
+        );
+        const __m128 depths = _mm_sub_ps(one, interpolatedReciprocalW);
+
+        const __m128 depthMask = DepthTestSSE2(triangle, depths, _mm_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm_movemask_ps(depthMask);
+        if (passedLanes == 0)
+        {
+            continue;
+        }
+        numShaded += std::popcount(scast<u32>(passedLanes));
+
+        __m128 interpolatedU = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(u0, weight0), _mm_mul_ps(u1, weight1)),
+            _mm_mul_ps(u2, weight2)
+        );
+        __m128 interpolatedV = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(v0, weight0), _mm_mul_ps(v1, weight1)),
+            _mm_mul_ps(v2, weight2)
+        );
+        interpolatedU = _mm_div_ps(interpolatedU, interpolatedReciprocalW);
+        interpolatedV = _mm_div_ps(interpolatedV, interpolatedReciprocalW);
+
+        alignas(16) int levels[SSE2_LANES] = { triangle.m_MinMipLevel, triangle.m_MinMipLevel, triangle.m_MinMipLevel, triangle.m_MinMipLevel };
+        if (isMipLevelPerPixel)
+        {
+            _mm_store_si128(rcast<__m128i*>(levels), GetMipLevelsSSE2(triangle, interpolatedU, interpolatedV, interpolatedReciprocalW));
+        }
+
+        alignas(16) u32 texelXs[SSE2_LANES] = {};
+        alignas(16) u32 texelYs[SSE2_LANES] = {};
+        _mm_store_si128(rcast<__m128i*>(texelXs), AbsSSE2(_mm_cvttps_epi32(_mm_mul_ps(interpolatedU, textureWidth))));
+        _mm_store_si128(rcast<__m128i*>(texelYs), AbsSSE2(_mm_cvttps_epi32(_mm_mul_ps(interpolatedV, textureHeight))));
+
+        // NOTE(sbalse): SSE2 has no gather so fetch the texels one lane at a time, and only the texels of the
+        // lanes that passed the depth test.
+        alignas(16) u32 texelColors[SSE2_LANES] = {};
+        for (int lane = 0; lane < SSE2_LANES; lane++)
+        {
+            if (passedLanes & (1 << lane))
+            {
+                texelColors[lane] = texture.m_Texels[GetTexelIndexFromBaseCoordinates(texture, levels[lane], texelXs[lane], texelYs[lane])];
+            }
+        }
+        const __m128i colors = _mm_load_si128(rcast<const __m128i*>(texelColors));
+
+        StorePixelsSSE2(span, i, depthMask, colors, depths);
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawTexturedSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+// NOTE(sbalse): Same as LerpTexelChannelPairScalar() for 4 texels. The weight of each lane has to be in
+// both of its 16 bit halves.
+static __m128i LerpTexelChannelPairsSSE2(const __m128i a, const __m128i b, const __m128i weights)
+{
+    const __m128i inverseWeights = _mm_sub_epi16(_mm_set1_epi16(BILINEAR_ONE), weights);
+    return _mm_srli_epi16(
+        _mm_add_epi16(_mm_mullo_epi16(a, inverseWeights), _mm_mullo_epi16(b, weights)),
+        BILINEAR_FRACTION_BITS
+    );
+}
+
+static __m128i BlendChannelPairsSSE2(
+    const __m128i texel00,
+    const __m128i texel10,
+    const __m128i texel01,
+    const __m128i texel11,
+    const __m128i weightsX,
+    const __m128i weightsY)
+{
+    const __m128i top = LerpTexelChannelPairsSSE2(texel00, texel10, weightsX);
+    const __m128i bottom = LerpTexelChannelPairsSSE2(texel01, texel11, weightsX);
+    return LerpTexelChannelPairsSSE2(top, bottom, weightsY);
+}
+
+// NOTE(sbalse): Same as BlendBilinearScalar() for 4 pixels. texels[i] holds corner i of the texels of
+// every lane.
+static __m128i BlendBilinearSSE2(const __m128i texels[4], const __m128i weightX, const __m128i weightY)
+{
+    const __m128i channelPairMask = _mm_set1_epi32(scast<int>(TEXEL_CHANNEL_PAIR_MASK));
+    const __m128i weightsX = _mm_or_si128(weightX, _mm_slli_epi32(weightX, 16));
+    const __m128i weightsY = _mm_or_si128(weightY, _mm_slli_epi32(weightY, 16));
+
+    const __m128i lowChannels = BlendChannelPairsSSE2(
+        _mm_and_si128(texels[0], channelPairMask),
+        _mm_and_si128(texels[1], channelPairMask),
+        _mm_and_si128(texels[2], channelPairMask),
+        _mm_and_si128(texels[3], channelPairMask),
+        weightsX,
+        weightsY
+    );
+    const __m128i highChannels = BlendChannelPairsSSE2(
+        _mm_srli_epi16(texels[0], 8),
+        _mm_srli_epi16(texels[1], 8),
+        _mm_srli_epi16(texels[2], 8),
+        _mm_srli_epi16(texels[3], 8),
+        weightsX,
+        weightsY
+    );
+    return _mm_or_si128(lowChannels, _mm_slli_epi16(highChannels, 8));
+}
+
+static int DrawBilinearTexturedSpanSSE2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m128 invArea = _mm_set1_ps(triangle.m_InvArea);
+    const __m128 reciprocalW0 = _mm_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m128 reciprocalW1 = _mm_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m128 reciprocalW2 = _mm_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m128 u0 = _mm_set1_ps(triangle.m_UVOverW[0].m_U);
+    const __m128 u1 = _mm_set1_ps(triangle.m_UVOverW[1].m_U);
+    const __m128 u2 = _mm_set1_ps(triangle.m_UVOverW[2].m_U);
+    const __m128 v0 = _mm_set1_ps(triangle.m_UVOverW[0].m_V);
+    const __m128 v1 = _mm_set1_ps(triangle.m_UVOverW[1].m_V);
+    const __m128 v2 = _mm_set1_ps(triangle.m_UVOverW[2].m_V);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    const Texture& texture = *triangle.m_Texture;
+    const __m128 fixedTextureWidth = _mm_set1_ps(scast<float>(texture.m_Mips[0].m_Width * BILINEAR_ONE));
+    const __m128 fixedTextureHeight = _mm_set1_ps(scast<float>(texture.m_Mips[0].m_Height * BILINEAR_ONE));
+    const bool isMipLevelPerPixel = triangle.m_MinMipLevel != triangle.m_MaxMipLevel;
+
+    __m128i edges[3] = {};
+    __m128i groupSteps[3] = {};
+    SetupEdgeLanesSSE2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + SSE2_LANES <= span.m_Count; i += SSE2_LANES)
+    {
+        const __m128 weight0 = _mm_mul_ps(_mm_cvtepi32_ps(edges[0]), invArea);
+        const __m128 weight1 = _mm_mul_ps(_mm_cvtepi32_ps(edges[1]), invArea);
+        const __m128 weight2 = _mm_mul_ps(_mm_cvtepi32_ps(edges[2]), invArea);
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm_add_epi32(edges[edge], groupSteps[edge]);
+        }
+
+        const __m128 interpolatedReciprocalW = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(reciprocalW0, weight0), _mm_mul_ps(reciprocalW1, weight1)),
+            _mm_mul_ps(reciprocalW2, weight2)
+        );
+        const __m128 depths = _mm_sub_ps(one, interpolatedReciprocalW);
+
+        const __m128 depthMask = DepthTestSSE2(triangle, depths, _mm_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm_movemask_ps(depthMask);
+        if (passedLanes == 0)
+        {
+            continue;
+        }
+        numShaded += std::popcount(scast<u32>(passedLanes));
+
+        __m128 interpolatedU = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(u0, weight0), _mm_mul_ps(u1, weight1)),
+            _mm_mul_ps(u2, weight2)
+        );
+        __m128 interpolatedV = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(v0, weight0), _mm_mul_ps(v1, weight1)),
+            _mm_mul_ps(v2, weight2)
+        );
+        interpolatedU = _mm_div_ps(interpolatedU, interpolatedReciprocalW);
+        interpolatedV = _mm_div_ps(interpolatedV, interpolatedReciprocalW);
+
+        alignas(16) int levels[SSE2_LANES] = { triangle.m_MinMipLevel, triangle.m_MinMipLevel, triangle.m_MinMipLevel, triangle.m_MinMipLevel };
+        if (isMipLevelPerPixel)
+        {
+            _mm_store_si128(rcast<__m128i*>(levels), GetMipLevelsSSE2(triangle, interpolatedU, interpolatedV, interpolatedReciprocalW));
+        }
+
+        alignas(16) u32 fixedXs[SSE2_LANES] = {};
+        alignas(16) u32 fixedYs[SSE2_LANES] = {};
+        _mm_store_si128(rcast<__m128i*>(fixedXs), AbsSSE2(_mm_cvttps_epi32(_mm_mul_ps(interpolatedU, fixedTextureWidth))));
+        _mm_store_si128(rcast<__m128i*>(fixedYs), AbsSSE2(_mm_cvttps_epi32(_mm_mul_ps(interpolatedV, fixedTextureHeight))));
+
+        // NOTE(sbalse): SSE2 has no gather so fetch the texels one lane at a time, and only the texels of the
+        // lanes that passed the depth test. The blend is done for all the lanes at once.
+        alignas(16) u32 corners[4][SSE2_LANES] = {};
+        alignas(16) u32 weightXs[SSE2_LANES] = {};
+        alignas(16) u32 weightYs[SSE2_LANES] = {};
+        for (int lane = 0; lane < SSE2_LANES; lane++)
+        {
+            if (passedLanes & (1 << lane))
+            {
+                const BilinearTexels texels = FetchBilinearTexelsScalar(texture, levels[lane], fixedXs[lane], fixedYs[lane]);
+                for (int corner = 0; corner < 4; corner++)
+                {
+                    corners[corner][lane] = texels.m_Texels[corner];
+                }
+                weightXs[lane] = texels.m_WeightX;
+                weightYs[lane] = texels.m_WeightY;
+            }
+        }
+
+        const __m128i texels[4] =
+        {
+            _mm_load_si128(rcast<const __m128i*>(corners[0])),
+            _mm_load_si128(rcast<const __m128i*>(corners[1])),
+            _mm_load_si128(rcast<const __m128i*>(corners[2])),
+            _mm_load_si128(rcast<const __m128i*>(corners[3])),
+        };
+        const __m128i colors = BlendBilinearSSE2(
+            texels,
+            _mm_load_si128(rcast<const __m128i*>(weightXs)),
+            _mm_load_si128(rcast<const __m128i*>(weightYs))
+        );
+
+        StorePixelsSSE2(span, i, depthMask, colors, depths);
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawBilinearTexturedSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+/******** NOTE(sbalse): AVX2 kernels, 8 pixels at a time. ***********/
+
+inline constexpr int AVX2_LANES = 8;
+
+static TARGET_AVX2 void SetupEdgeLanesAVX2(
+    const SpanTriangle& triangle,
+    const Span& span,
+    __m256i outEdges[3],
+    __m256i outGroupSteps[3])
+{
+    const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (int i = 0; i < 3; i++)
+    {
+        const u32 start = scast<u32>(span.m_Edges[i]);
+        const u32 step = scast<u32>(triangle.m_EdgeStepX[i]);
+        outEdges[i] = _mm256_add_epi32(
+            _mm256_set1_epi32(scast<int>(start)),
+            _mm256_mullo_epi32(laneIndices, _mm256_set1_epi32(scast<int>(step)))
+        );
+        outGroupSteps[i] = _mm256_set1_epi32(scast<int>(step * AVX2_LANES));
+    }
+}
+
+static TARGET_AVX2 void StorePixelsAVX2(
+    const Span& span,
+    const int i,
+    const __m256 depthMask,
+    const __m256i colors,
+    const __m256 depths)
+{
+    const __m256i mask = _mm256_castps_si256(depthMask);
+
+    u32* const colorAddress = span.m_Colors + i;
+    float* const depthAddress = span.m_Depths + i;
+
+    const __m256i oldColors = _mm256_loadu_si256(rcast<const __m256i*>(colorAddress));
+    _mm256_storeu_si256(rcast<__m256i*>(colorAddress), _mm256_blendv_epi8(oldColors, colors, mask));
+
+    const __m256 oldDepths = _mm256_loadu_ps(depthAddress);
+    _mm256_storeu_ps(depthAddress, _mm256_blendv_ps(oldDepths, depths, depthMask));
+}
+
+static TARGET_AVX2 __m256 DepthTestAVX2(const SpanTriangle& triangle, const __m256 depths, const __m256 storedDepths)
+{
+    return (triangle.m_DepthTestMethod == DepthTestMethod::LessEqual)
+        ? _mm256_cmp_ps(depths, storedDepths, _CMP_LE_OQ)
+        : _mm256_cmp_ps(depths, storedDepths, _CMP_LT_OQ);
+}
+
+// NOTE(sbalse): Same as GetTexelsPerPixelSquaredScalar() and GetMipLevel() for 8 pixels.
+static TARGET_AVX2 __m256i GetMipLevelsAVX2(
+    const SpanTriangle& triangle,
+    const __m256 u,
+    const __m256 v,
+    const __m256 reciprocalW)
+{
+    const __m256 dudx = _mm256_sub_ps(_mm256_set1_ps(triangle.m_TexelUOverWStep[0]), _mm256_mul_ps(u, _mm256_set1_ps(triangle.m_ReciprocalWStepU[0])));
+    const __m256 dvdx = _mm256_sub_ps(_mm256_set1_ps(triangle.m_TexelVOverWStep[0]), _mm256_mul_ps(v, _mm256_set1_ps(triangle.m_ReciprocalWStepV[0])));
+    const __m256 dudy = _mm256_sub_ps(_mm256_set1_ps(triangle.m_TexelUOverWStep[1]), _mm256_mul_ps(u, _mm256_set1_ps(triangle.m_ReciprocalWStepU[1])));
+    const __m256 dvdy = _mm256_sub_ps(_mm256_set1_ps(triangle.m_TexelVOverWStep[1]), _mm256_mul_ps(v, _mm256_set1_ps(triangle.m_ReciprocalWStepV[1])));
+
+    const __m256 lengthXSquared = _mm256_add_ps(_mm256_mul_ps(dudx, dudx), _mm256_mul_ps(dvdx, dvdx));
+    const __m256 lengthYSquared = _mm256_add_ps(_mm256_mul_ps(dudy, dudy), _mm256_mul_ps(dvdy, dvdy));
+    const __m256 texelsPerPixelSquared = _mm256_div_ps(
+        _mm256_max_ps(lengthXSquared, lengthYSquared),
+        _mm256_mul_ps(reciprocalW, reciprocalW)
+    );
+
+    const __m256i exponents = _mm256_sub_epi32(
+        _mm256_srli_epi32(_mm256_castps_si256(texelsPerPixelSquared), 23),
+        _mm256_set1_epi32(127)
+    );
+    const __m256i levels = _mm256_srai_epi32(exponents, 1);
+    return _mm256_min_epi32(
+        _mm256_max_epi32(levels, _mm256_set1_epi32(triangle.m_MinMipLevel)),
+        _mm256_set1_epi32(triangle.m_MaxMipLevel)
+    );
+}
+
+// NOTE(sbalse): What the texel index of each lane is computed from, for the mip level of the lane.
+struct MipLanesAVX2
+{
+    __m256i m_Levels;
+    __m256i m_WidthLog2;
+    __m256i m_WidthMask;
+    __m256i m_HeightMask;
+    __m256i m_TexelsOffset;
+    __m256i m_MortonXOffset; // NOTE(sbalse): Only set with TextureLayout::Morton.
+    __m256i m_MortonYOffset;
+};
+
+static TARGET_AVX2 MipLanesAVX2 GetMipLanesAVX2(const Texture& texture, const __m256i levels)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const TextureMip& baseMip = texture.m_Mips[0];
+
+    // NOTE(sbalse): Every level is half the size of the one before it, down to 1.
+    const __m256i widthLog2 = _mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(scast<int>(baseMip.m_WidthLog2)), levels), zero);
+    const __m256i heightLog2 = _mm256_max_epi32(_mm256_sub_epi32(_mm256_set1_epi32(scast<int>(baseMip.m_HeightLog2)), levels), zero);
+    const __m256i widths = _mm256_sllv_epi32(one, widthLog2);
+    const __m256i mipIndices = _mm256_mullo_epi32(levels, _mm256_set1_epi32(TEXTURE_MIP_STRIDE));
+
+    MipLanesAVX2 result = {};
+    result.m_Levels = levels;
+    result.m_WidthLog2 = widthLog2;
+    result.m_WidthMask = _mm256_sub_epi32(widths, one);
+    result.m_HeightMask = _mm256_sub_epi32(_mm256_sllv_epi32(one, heightLog2), one);
+    result.m_TexelsOffset = _mm256_i32gather_epi32(rcast<const int*>(&baseMip.m_TexelsOffset), mipIndices, sizeof(u32));
+    if (texture.m_Layout == TextureLayout::Morton)
+    {
+        result.m_MortonXOffset = _mm256_i32gather_epi32(rcast<const int*>(&baseMip.m_MortonOffset), mipIndices, sizeof(u32));
+        result.m_MortonYOffset = _mm256_add_epi32(result.m_MortonXOffset, widths);
+    }
+    return result;
+}
+
+// NOTE(sbalse): The texel index of each lane is the index of its column plus the index of its row. Both
+// take wrapped coordinates of the mip level of the lane, and the row index includes the offset of the level.
+// With the Morton layout the bits of the two indices don't overlap, so adding them is the same as the OR
+// in GetTexelIndex().
+static TARGET_AVX2 __m256i GetTexelColumnIndicesAVX2(const Texture& texture, const MipLanesAVX2& mip, const __m256i x)
+{
+    if (texture.m_Layout == TextureLayout::Morton)
+    {
+        const int* const mortonTables = rcast<const int*>(texture.m_MortonTables);
+        return _mm256_i32gather_epi32(mortonTables, _mm256_add_epi32(mip.m_MortonXOffset, x), sizeof(u32));
+    }
+
+    return x;
+}
+
+static TARGET_AVX2 __m256i GetTexelRowIndicesAVX2(const Texture& texture, const MipLanesAVX2& mip, const __m256i y)
+{
+    __m256i indices = {};
+    if (texture.m_Layout == TextureLayout::Morton)
+    {
+        const int* const mortonTables = rcast<const int*>(texture.m_MortonTables);
+        indices = _mm256_i32gather_epi32(mortonTables, _mm256_add_epi32(mip.m_MortonYOffset, y), sizeof(u32));
+    }
+    else
+    {
+        indices = _mm256_sllv_epi32(y, mip.m_WidthLog2);
+    }
+
+    return _mm256_add_epi32(indices, mip.m_TexelsOffset);
+}
+
+// NOTE(sbalse): Same as GetTexelIndexFromBaseCoordinates() for 8 pixels.
+static TARGET_AVX2 __m256i GetTexelIndicesAVX2(
+    const Texture& texture,
+    const MipLanesAVX2& mip,
+    const __m256i baseX,
+    const __m256i baseY)
+{
+    const __m256i x = _mm256_and_si256(_mm256_srlv_epi32(baseX, mip.m_Levels), mip.m_WidthMask);
+    const __m256i y = _mm256_and_si256(_mm256_srlv_epi32(baseY, mip.m_Levels), mip.m_HeightMask);
+    return _mm256_add_epi32(GetTexelColumnIndicesAVX2(texture, mip, x), GetTexelRowIndicesAVX2(texture, mip, y));
+}
+
+// NOTE(sbalse): Same as LerpTexelChannelPairScalar() for 8 texels. The weight of each lane has to be in
+// both of its 16 bit halves.
+static TARGET_AVX2 __m256i LerpTexelChannelPairsAVX2(const __m256i a, const __m256i b, const __m256i weights)
+{
+    const __m256i inverseWeights = _mm256_sub_epi16(_mm256_set1_epi16(BILINEAR_ONE), weights);
+    return _mm256_srli_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(a, inverseWeights), _mm256_mullo_epi16(b, weights)),
+        BILINEAR_FRACTION_BITS
+    );
+}
+
+static TARGET_AVX2 __m256i BlendChannelPairsAVX2(
+    const __m256i texel00,
+    const __m256i texel10,
+    const __m256i texel01,
+    const __m256i texel11,
+    const __m256i weightsX,
+    const __m256i weightsY)
+{
+    const __m256i top = LerpTexelChannelPairsAVX2(texel00, texel10, weightsX);
+    const __m256i bottom = LerpTexelChannelPairsAVX2(texel01, texel11, weightsX);
+    return LerpTexelChannelPairsAVX2(top, bottom, weightsY);
+}
+
+// NOTE(sbalse): Same as FetchBilinearTexelsScalar() and BlendBilinearScalar() for 8 pixels. Only the texels of
+// the lanes in the mask are fetched.
+static TARGET_AVX2 __m256i SampleBilinearAVX2(
+    const Texture& texture,
+    const MipLanesAVX2& mip,
+    const __m256i fixedX,
+    const __m256i fixedY,
+    const __m256i mask)
+{
+    const __m256i halfTexel = _mm256_set1_epi32(BILINEAR_ONE / 2);
+    const __m256i fractionMask = _mm256_set1_epi32(BILINEAR_ONE - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    const __m256i x = _mm256_sub_epi32(_mm256_srlv_epi32(fixedX, mip.m_Levels), halfTexel);
+    const __m256i y = _mm256_sub_epi32(_mm256_srlv_epi32(fixedY, mip.m_Levels), halfTexel);
+    const __m256i x0 = _mm256_and_si256(_mm256_srai_epi32(x, BILINEAR_FRACTION_BITS), mip.m_WidthMask);
+    const __m256i y0 = _mm256_and_si256(_mm256_srai_epi32(y, BILINEAR_FRACTION_BITS), mip.m_HeightMask);
+    const __m256i x1 = _mm256_and_si256(_mm256_add_epi32(x0, one), mip.m_WidthMask);
+    const __m256i y1 = _mm256_and_si256(_mm256_add_epi32(y0, one), mip.m_HeightMask);
+
+    const __m256i columns[2] = { GetTexelColumnIndicesAVX2(texture, mip, x0), GetTexelColumnIndicesAVX2(texture, mip, x1) };
+    const __m256i rows[2] = { GetTexelRowIndicesAVX2(texture, mip, y0), GetTexelRowIndicesAVX2(texture, mip, y1) };
+
+    const int* const texels = rcast<const int*>(texture.m_Texels);
+    __m256i corners[4] = {};
+    for (int corner = 0; corner < 4; corner++)
+    {
+        corners[corner] = _mm256_mask_i32gather_epi32(
+            _mm256_setzero_si256(),
+            texels,
+            _mm256_add_epi32(columns[corner & 1], rows[corner >> 1]),
+            mask,
+            sizeof(u32)
+        );
+    }
+
+    const __m256i weightX = _mm256_and_si256(x, fractionMask);
+    const __m256i weightY = _mm256_and_si256(y, fractionMask);
+    const __m256i weightsX = _mm256_or_si256(weightX, _mm256_slli_epi32(weightX, 16));
+    const __m256i weightsY = _mm256_or_si256(weightY, _mm256_slli_epi32(weightY, 16));
+
+    const __m256i channelPairMask = _mm256_set1_epi32(scast<int>(TEXEL_CHANNEL_PAIR_MASK));
+    const __m256i lowChannels = BlendChannelPairsAVX2(
+        _mm256_and_si256(corners[0], channelPairMask),
+        _mm256_and_si256(corners[1], channelPairMask),
+        _mm256_and_si256(corners[2], channelPairMask),
+        _mm256_and_si256(corners[3], channelPairMask),
+        weightsX,
+        weightsY
+    );
+    const __m256i highChannels = BlendChannelPairsAVX2(
+        _mm256_srli_epi16(corners[0], 8),
+        _mm256_srli_epi16(corners[1], 8),
+        _mm256_srli_epi16(corners[2], 8),
+        _mm256_srli_epi16(corners[3], 8),
+        weightsX,
+        weightsY
+    );
+    return _mm256_or_si256(lowChannels, _mm256_slli_epi16(highChannels, 8));
+}
+
+static TARGET_AVX2 int DrawDepthSpanAVX2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m256 invArea = _mm256_set1_ps(triangle.m_InvArea);
+    const __m256 reciprocalW0 = _mm256_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m256 reciprocalW1 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m256 reciprocalW2 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256i edges[3] = {};
+    __m256i groupSteps[3] = {};
+    SetupEdgeLanesAVX2(triangle, span, edges, groupSteps);
+
+    int numWritten = 0;
+    int i = 0;
+    for (; i + AVX2_LANES <= span.m_Count; i += AVX2_LANES)
+    {
+        const __m256 weight0 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[0]), invArea);
+        const __m256 weight1 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[1]), invArea);
+        const __m256 weight2 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[2]), invArea);
+
+        const __m256 interpolatedReciprocalW = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(reciprocalW0, weight0), _mm256_mul_ps(reciprocalW1, weight1)),
+            _mm256_mul_ps(reciprocalW2, weight2)
+        );
+        const __m256 depths = _mm256_sub_ps(one, interpolatedReciprocalW);
+
+        float* const depthAddress = span.m_Depths + i;
+        const __m256 oldDepths = _mm256_loadu_ps(depthAddress);
+        const __m256 depthMask = DepthTestAVX2(triangle, depths, oldDepths);
+        const int passedLanes = _mm256_movemask_ps(depthMask);
+        if (passedLanes != 0)
+        {
+            _mm256_storeu_ps(depthAddress, _mm256_blendv_ps(oldDepths, depths, depthMask));
+            numWritten += std::popcount(scast<u32>(passedLanes));
+        }
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm256_add_epi32(edges[edge], groupSteps[edge]);
+        }
+    }
+
+    if (i < span.m_Count)
+    {
+        numWritten += DrawDepthSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numWritten;
+}
+
+static TARGET_AVX2 int DrawFilledSpanAVX2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m256 invArea = _mm256_set1_ps(triangle.m_InvArea);
+    const __m256 reciprocalW0 = _mm256_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m256 reciprocalW1 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m256 reciprocalW2 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i color = _mm256_set1_epi32(scast<int>(triangle.m_Color));
+
+    __m256i edges[3] = {};
+    __m256i groupSteps[3] = {};
+    SetupEdgeLanesAVX2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + AVX2_LANES <= span.m_Count; i += AVX2_LANES)
+    {
+        const __m256 weight0 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[0]), invArea);
+        const __m256 weight1 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[1]), invArea);
+        const __m256 weight2 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[2]), invArea);
+
+        const __m256 interpolatedReciprocalW = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(reciprocalW0, weight0), _mm256_mul_ps(reciprocalW1, weight1)),
+            _mm256_mul_ps(reciprocalW2, weight2)
+        );
+        const __m256 depths = _mm256_sub_ps(one, interpolatedReciprocalW);
+
+        const __m256 depthMask = DepthTestAVX2(triangle, depths, _mm256_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm256_movemask_ps(depthMask);
+        if (passedLanes != 0)
+        {
+            StorePixelsAVX2(span, i, depthMask, color, depths);
+            numShaded += std::popcount(scast<u32>(passedLanes));
+        }
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm256_add_epi32(edges[edge], groupSteps[edge]);
+        }
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawFilledSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+static TARGET_AVX2 int DrawTexturedSpanAVX2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m256 invArea = _mm256_set1_ps(triangle.m_InvArea);
+    const __m256 reciprocalW0 = _mm256_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m256 reciprocalW1 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m256 reciprocalW2 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m256 u0 = _mm256_set1_ps(triangle.m_UVOverW[0].m_U);
+    const __m256 u1 = _mm256_set1_ps(triangle.m_UVOverW[1].m_U);
+    const __m256 u2 = _mm256_set1_ps(triangle.m_UVOverW[2].m_U);
+    const __m256 v0 = _mm256_set1_ps(triangle.m_UVOverW[0].m_V);
+    const __m256 v1 = _mm256_set1_ps(triangle.m_UVOverW[1].m_V);
+    const __m256 v2 = _mm256_set1_ps(triangle.m_UVOverW[2].m_V);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const Texture& texture = *triangle.m_Texture;
+    const __m256 textureWidth = _mm256_set1_ps(scast<float>(texture.m_Mips[0].m_Width));
+    const __m256 textureHeight = _mm256_set1_ps(scast<float>(texture.m_Mips[0].m_Height));
+    const int* const texels = rcast<const int*>(texture.m_Texels);
+    const bool isMipLevelPerPixel = triangle.m_MinMipLevel != triangle.m_MaxMipLevel;
+
+    // NOTE(sbalse): The mip level of all the lanes when it's the same for the whole triangle.
+    const MipLanesAVX2 triangleMip = GetMipLanesAVX2(texture, _mm256_set1_epi32(triangle.m_MinMipLevel));
+
+    __m256i edges[3] = {};
+    __m256i groupSteps[3] = {};
+    SetupEdgeLanesAVX2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + AVX2_LANES <= span.m_Count; i += AVX2_LANES)
+    {
+        const __m256 weight0 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[0]), invArea);
+        const __m256 weight1 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[1]), invArea);
+        const __m256 weight2 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[2]), invArea);
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm256_add_epi32(edges[edge], groupSteps[edge]);
+        }
+
+        const __m256 interpolatedReciprocalW = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(reciprocalW0, weight0), _mm256_mul_ps(reciprocalW1, weight1)),
+            _mm256_mul_ps(reciprocalW2, weight2)
+        );
+        const __m256 depths = _mm256_sub_ps(one, interpolatedReciprocalW);
+
+        const __m256 depthMask = DepthTestAVX2(triangle, depths, _mm256_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm256_movemask_ps(depthMask);
+        if (passedLanes == 0)
+        {
+            continue;
+        }
+        numShaded += std::popcount(scast<u32>(passedLanes));
+
+        __m256 interpolatedU = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(u0, weight0), _mm256_mul_ps(u1, weight1)),
+            _mm256_mul_ps(u2, weight2)
+        );
+        __m256 interpolatedV = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(v0, weight0), _mm256_mul_ps(v1, weight1)),
+            _mm256_mul_ps(v2, weight2)
+        );
+        interpolatedU = _mm256_div_ps(interpolatedU, interpolatedReciprocalW);
+        interpolatedV = _mm256_div_ps(interpolatedV, interpolatedReciprocalW);
+
+        const __m256i texelX = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(interpolatedU, textureWidth)));
+        const __m256i texelY = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(interpolatedV, textureHeight)));
+
+        const __m256i texelIndices = isMipLevelPerPixel
+            ? GetTexelIndicesAVX2(
+                texture,
+                GetMipLanesAVX2(texture, GetMipLevelsAVX2(triangle, interpolatedU, interpolatedV, interpolatedReciprocalW)),
+                texelX,
+                texelY
+            )
+            : GetTexelIndicesAVX2(texture, triangleMip, texelX, texelY);
+
+        // NOTE(sbalse): Only fetch the texels of the lanes that passed the depth test.
+        const __m256i colors = _mm256_mask_i32gather_epi32(
+            _mm256_setzero_si256(),
+            texels,
+            texelIndices,
+            _mm256_castps_si256(depthMask),
+            sizeof(u32)
+        );
+
+        StorePixelsAVX2(span, i, depthMask, colors, depths);
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawTexturedSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+static TARGET_AVX2 int DrawBilinearTexturedSpanAVX2(const SpanTriangle& triangle, const Span& span)
+{
+    const __m256 invArea = _mm256_set1_ps(triangle.m_InvArea);
+    const __m256 reciprocalW0 = _mm256_set1_ps(triangle.m_ReciprocalW.m_X);
+    const __m256 reciprocalW1 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Y);
+    const __m256 reciprocalW2 = _mm256_set1_ps(triangle.m_ReciprocalW.m_Z);
+    const __m256 u0 = _mm256_set1_ps(triangle.m_UVOverW[0].m_U);
+    const __m256 u1 = _mm256_set1_ps(triangle.m_UVOverW[1].m_U);
+    const __m256 u2 = _mm256_set1_ps(triangle.m_UVOverW[2].m_U);
+    const __m256 v0 = _mm256_set1_ps(triangle.m_UVOverW[0].m_V);
+    const __m256 v1 = _mm256_set1_ps(triangle.m_UVOverW[1].m_V);
+    const __m256 v2 = _mm256_set1_ps(triangle.m_UVOverW[2].m_V);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const Texture& texture = *triangle.m_Texture;
+    const __m256 fixedTextureWidth = _mm256_set1_ps(scast<float>(texture.m_Mips[0].m_Width * BILINEAR_ONE));
+    const __m256 fixedTextureHeight = _mm256_set1_ps(scast<float>(texture.m_Mips[0].m_Height * BILINEAR_ONE));
+    const bool isMipLevelPerPixel = triangle.m_MinMipLevel != triangle.m_MaxMipLevel;
+
+    // NOTE(sbalse): The mip level of all the lanes when it's the same for the whole triangle.
+    const MipLanesAVX2 triangleMip = GetMipLanesAVX2(texture, _mm256_set1_epi32(triangle.m_MinMipLevel));
+
+    __m256i edges[3] = {};
+    __m256i groupSteps[3] = {};
+    SetupEdgeLanesAVX2(triangle, span, edges, groupSteps);
+
+    int numShaded = 0;
+    int i = 0;
+    for (; i + AVX2_LANES <= span.m_Count; i += AVX2_LANES)
+    {
+        const __m256 weight0 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[0]), invArea);
+        const __m256 weight1 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[1]), invArea);
+        const __m256 weight2 = _mm256_mul_ps(_mm256_cvtepi32_ps(edges[2]), invArea);
+
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edges[edge] = _mm256_add_epi32(edges[edge], groupSteps[edge]);
+        }
+
+        const __m256 interpolatedReciprocalW = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(reciprocalW0, weight0), _mm256_mul_ps(reciprocalW1, weight1)),
+            _mm256_mul_ps(reciprocalW2, weight2)
+        );
+        const __m256 depths = _mm256_sub_ps(one, interpolatedReciprocalW);
+
+        const __m256 depthMask = DepthTestAVX2(triangle, depths, _mm256_loadu_ps(span.m_Depths + i));
+        const int passedLanes = _mm256_movemask_ps(depthMask);
+        if (passedLanes == 0)
+        {
+            continue;
+        }
+        numShaded += std::popcount(scast<u32>(passedLanes));
+
+        __m256 interpolatedU = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(u0, weight0), _mm256_mul_ps(u1, weight1)),
+            _mm256_mul_ps(u2, weight2)
+        );
+        __m256 interpolatedV = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(v0, weight0), _mm256_mul_ps(v1, weight1)),
+            _mm256_mul_ps(v2, weight2)
+        );
+        interpolatedU = _mm256_div_ps(interpolatedU, interpolatedReciprocalW);
+        interpolatedV = _mm256_div_ps(interpolatedV, interpolatedReciprocalW);
+
+        const __m256i fixedX = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(interpolatedU, fixedTextureWidth)));
+        const __m256i fixedY = _mm256_abs_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(interpolatedV, fixedTextureHeight)));
+
+        const __m256i colors = isMipLevelPerPixel
+            ? SampleBilinearAVX2(
+                texture,
+                GetMipLanesAVX2(texture, GetMipLevelsAVX2(triangle, interpolatedU, interpolatedV, interpolatedReciprocalW)),
+                fixedX,
+                fixedY,
+                _mm256_castps_si256(depthMask)
+            )
+            : SampleBilinearAVX2(texture, triangleMip, fixedX, fixedY, _mm256_castps_si256(depthMask));
+
+        StorePixelsAVX2(span, i, depthMask, colors, depths);
+    }
+
+    if (i < span.m_Count)
+    {
+        numShaded += DrawBilinearTexturedSpanScalar(triangle, GetSpanTail(triangle, span, i));
+    }
+
+    return numShaded;
+}
+
+bool IsPixelKernelMethodSupported(const PixelKernelMethod method)
+{
+    // NOTE(sbalse): SSE2 is part of x64 so only AVX2 needs checking.
+    if (method == PixelKernelMethod::AVX2)
+    {
+        static const bool supportsAVX2 = CpuSupportsAVX2();
+        return supportsAVX2;
+    }
+
+    return true;
+}
+
+PixelKernelMethod GetBestPixelKernelMethod()
+{
+    if (IsPixelKernelMethodSupported(PixelKernelMethod::AVX2))
+    {
+        return PixelKernelMethod::AVX2;
+    }
+
+    return PixelKernelMethod::SSE2;
+}
+
+const char* GetPixelKernelMethodName(const PixelKernelMethod method)
+{
+    switch (method)
+    {
+    case PixelKernelMethod::Scalar: return "Scalar";
+    case PixelKernelMethod::SSE2: return "SSE2";
+    case PixelKernelMethod::AVX2: return "AVX2";
+    }
+
+    return "Unknown";
+}
+
+void SetTexelFetchCallback(const TexelFetchCallback callback)
+{
+    g_TexelFetchCallback = callback;
+}
+
+PixelKernels GetPixelKernels(const PixelKernelMethod method)
+{
+    switch (method)
+    {
+    case PixelKernelMethod::SSE2:
+    {
+        return PixelKernels{ DrawDepthSpanSSE2, DrawFilledSpanSSE2, DrawTexturedSpanSSE2, DrawBilinearTexturedSpanSSE2 };
+    }
+
+    case PixelKernelMethod::AVX2:
+    {
+        return PixelKernels{ DrawDepthSpanAVX2, DrawFilledSpanAVX2, DrawTexturedSpanAVX2, DrawBilinearTexturedSpanAVX2 };
+    }
+
+    default:
+    {
+        return PixelKernels{ DrawDepthSpanScalar, DrawFilledSpanScalar, DrawTexturedSpanScalar, DrawBilinearTexturedSpanScalar };
+    }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "common.h"
+#include "vector.h"
+#include "texture.h"
+#include "display.h"
+
+// NOTE(sbalse): Everything about a triangle that stays the same for all of its spans.
+struct SpanTriangle
+{
+    i64 m_EdgeStepX[3]; // NOTE(sbalse): Change of the edge function values when moving one pixel right.
+    float m_InvArea; // NOTE(sbalse): Turns edge function values into barycentric weights.
+    Vec3 m_ReciprocalW; // NOTE(sbalse): 1/w of the three vertices.
+    DepthTestMethod m_DepthTestMethod;
+
+    u32 m_Color; // NOTE(sbalse): Only used by the filled kernels.
+
+    // NOTE(sbalse): Only used by the textured kernels.
+    Tex2 m_UVOverW[3]; // NOTE(sbalse): U/w and V/w of the three vertices with V already flipped.
+    const Texture* m_Texture;
+
+    // NOTE(sbalse): The mip level of each pixel is clamped to these. When they are the same the whole
+    // triangle is sampled from that level and the kernels skip working out the level of each pixel.
+    int m_MinMipLevel;
+    int m_MaxMipLevel;
+
+    // NOTE(sbalse): Change of U/w, V/w and 1/w when moving one pixel right ([0]) and one pixel down ([1]), in
+    // level 0 texels. The U derivatives are scaled by the texture width and the V ones by the height, so the
+    // screen space derivative of u in texels is (m_TexelUOverWStep - (u * m_ReciprocalWStepU)) * w.
+    float m_TexelUOverWStep[2];
+    float m_TexelVOverWStep[2];
+    float m_ReciprocalWStepU[2];
+    float m_ReciprocalWStepV[2];
+};
+
+// NOTE(sbalse): A run of horizontally adjacent pixels of one row. All the pixels of a span are inside
+// the triangle so the kernels only need to do the depth test.
+struct Span
+{
+    u32* m_Colors;
+    float* m_Depths;
+    int m_Count;
+    i64 m_Edges[3]; // NOTE(sbalse): Edge function values at the center of the first pixel.
+};
+
+// NOTE(sbalse): Every kernel does the depth test of a pixel before any of its shading work, so hidden pixels
+// cost only the depth interpolation. Returns the number of pixels that passed the depth test.
+using DrawSpanFunc = int (*)(const SpanTriangle& triangle, const Span& span);
+
+struct PixelKernels
+{
+    DrawSpanFunc m_DrawDepthSpan; // NOTE(sbalse): Only writes the depth, used by the depth pre-pass.
+    DrawSpanFunc m_DrawFilledSpan;
+    DrawSpanFunc m_DrawTexturedSpan; // NOTE(sbalse): TextureFilterMethod::Nearest.
+    DrawSpanFunc m_DrawBilinearTexturedSpan; // NOTE(sbalse): TextureFilterMethod::Bilinear.
+};
+
+// NOTE(sbalse): The vector kernels keep the edge function values in 32 bit lanes. Triangles bigger than
+// this have to use the scalar kernels.
+inline constexpr i64 MAX_VECTOR_KERNEL_TRIANGLE_AREA = (i64(1) << 31) - 1;
+
+// NOTE(sbalse): Called with the address of every texel fetched without a gather, when set. Only used to feed
+// the texel addresses of the scalar kernels to a cache model when benchmarking, the AVX2 kernels never call it.
+using TexelFetchCallback = void (*)(const void* texel);
+void SetTexelFetchCallback(const TexelFetchCallback callback);
+
+// NOTE(sbalse): Whether the CPU we are running on can execute the kernels of the given method.
+bool IsPixelKernelMethodSupported(const PixelKernelMethod method);
+// NOTE(sbalse): The fastest method supported by this CPU.
+PixelKernelMethod GetBestPixelKernelMethod();
+const char* GetPixelKernelMethodName(const PixelKernelMethod method);
+
+// NOTE(sbalse): All kernels draw exactly the same pixels with exactly the same values.
+PixelKernels GetPixelKernels(const PixelKernelMethod method);
@@ -11,6 +11,7 @@
 #define PROFILE_FRAME() FrameMark
 #define PROFILE_EVENT() ZoneScoped
 #define PROFILE_EVENT_SCOPED_BEGIN(var, name) ZoneNamedN(var, name, true)
+#define PROFILE_THREAD_NAME(name) tracy::SetThreadName(name)
 #define PROFILE_MEMORY_ALLOC(ptr, size) TracyAlloc(ptr, size)
 #define PROFILE_MEMORY_FREE(ptr) TracyFree(ptr)
 
@@ -19,6 +20,7 @@
 #define PROFILE_FRAME()
 #define PROFILE_EVENT()
 #define PROFILE_EVENT_SCOPED_BEGIN(var, name)
+#define PROFILE_THREAD_NAME(name)
 #define PROFILE_MEMORY_ALLOC(ptr, size)
 #define PROFILE_MEMORY_FREE(ptr)
 
@@ -0,0 +1,404 @@
+#include "rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "display.h"
+#include "colorlibrary.h"
+#include "threadpool.h"
+#include "profile.h"
+#include "stats.h"
+
+// NOTE(sbalse): Extra pixels added around the triangle bounds when binning. The vertex rectangles of
+// RenderMethod::WireVertex stick out 3 pixels from the triangle vertices.
+inline constexpr int TILE_BINNING_MARGIN = 4;
+
+// NOTE(sbalse): The triangles sorted into screen tiles.
+struct TileBins
+{
+    const Triangle* m_Triangles;
+    u32* m_TriangleIndices; // NOTE(sbalse): Triangles touching each tile, in submission order.
+    u32* m_TileOffsets; // NOTE(sbalse): Tile i uses m_TriangleIndices[m_TileOffsets[i]] to m_TriangleIndices[m_TileOffsets[i + 1] - 1].
+    int m_NumTilesX;
+    int m_NumTilesY;
+    RenderMethod m_RenderMethod;
+    bool m_IsDepthPrepass; // NOTE(sbalse): Only draw the depth of the triangles.
+};
+
+// NOTE(sbalse): Draw a single triangle with the given render method.
+static void DrawTriangleToRender(const Triangle& triangle, const RenderMethod renderMethod)
+{
+    if (renderMethod == RenderMethod::FillTriangle
+        || renderMethod == RenderMethod::FillTriangleWire)
+    {
+        // NOTE(sbalse): Draw mesh face triangles.
+        DrawFilledTriangle(
+            triangle.m_Points[0],
+            triangle.m_Points[1],
+            triangle.m_Points[2],
+            triangle.m_Color
+        );
+    }
+
+    if (renderMethod == RenderMethod::WireVertex)
+    {
+        // NOTE(sbalse): Draw the cube corner vertices.
+        DrawRectangle(
+            scast<int>(triangle.m_Points[0].m_X - 3),
+            scast<int>(triangle.m_Points[0].m_Y - 3),
+            6,
+            6,
+            RED
+        );
+        DrawRectangle(
+            scast<int>(triangle.m_Points[1].m_X - 3),
+            scast<int>(triangle.m_Points[1].m_Y - 3),
+            6,
+            6,
+            RED
+        );
+        DrawRectangle(
+            scast<int>(triangle.m_Points[2].m_X - 3),
+            scast<int>(triangle.m_Points[2].m_Y - 3),
+            6,
+            6,
+            RED
+        );
+    }
+
+    // NOTE(sbalse): Draw textured triangle.
+    if (renderMethod == RenderMethod::Textured
+        || renderMethod == RenderMethod::WireTextured)
+    {
+        DrawTexturedTriangle(
+            triangle.m_Points[0],
+            triangle.m_Points[1],
+            triangle.m_Points[2],
+            triangle.m_TexCoords[0],
+            triangle.m_TexCoords[1],
+            triangle.m_TexCoords[2],
+            triangle.m_Texture
+        );
+    }
+
+    if (renderMethod == RenderMethod::Wire
+        || renderMethod == RenderMethod::WireVertex
+        || renderMethod == RenderMethod::FillTriangleWire
+        || renderMethod == RenderMethod::WireTextured)
+    {
+        // NOTE(sbalse): Draw mesh wireframe triangles.
+        DrawTriangle(
+            scast<int>(triangle.m_Points[0].m_X),
+            scast<int>(triangle.m_Points[0].m_Y),
+            scast<int>(triangle.m_Points[1].m_X),
+            scast<int>(triangle.m_Points[1].m_Y),
+            scast<int>(triangle.m_Points[2].m_X),
+            scast<int>(triangle.m_Points[2].m_Y),
+            WHITE
+        );
+    }
+}
+
+// NOTE(sbalse): Draw the depth of a single triangle for the depth pre-pass. Only the render methods that
+// fill triangles write depth, the lines and vertex rectangles don't.
+static void DrawTriangleDepthToRender(const Triangle& triangle, const RenderMethod renderMethod)
+{
+    if (renderMethod == RenderMethod::FillTriangle
+        || renderMethod == RenderMethod::FillTriangleWire
+        || renderMethod == RenderMethod::Textured
+        || renderMethod == RenderMethod::WireTextured)
+    {
+        DrawDepthTriangle(triangle.m_Points[0], triangle.m_Points[1], triangle.m_Points[2]);
+    }
+}
+
+// NOTE(sbalse): Get the range of tiles (inclusive) that the triangle can draw to. Returns false if the
+// triangle is completely outside the screen.
+static bool GetTriangleTileRange(
+    const Triangle& triangle,
+    const int numTilesX,
+    const int numTilesY,
+    ScreenRect* const outTileRange)
+{
+    const float minX = std::min({ triangle.m_Points[0].m_X, triangle.m_Points[1].m_X, triangle.m_Points[2].m_X });
+    const float minY = std::min({ triangle.m_Points[0].m_Y, triangle.m_Points[1].m_Y, triangle.m_Points[2].m_Y });
+    const float maxX = std::max({ triangle.m_Points[0].m_X, triangle.m_Points[1].m_X, triangle.m_Points[2].m_X });
+    const float maxY = std::max({ triangle.m_Points[0].m_Y, triangle.m_Points[1].m_Y, triangle.m_Points[2].m_Y });
+
+    const float windowWidth = scast<float>(GetWindowWidth());
+    const float windowHeight = scast<float>(GetWindowHeight());
+
+    // NOTE(sbalse): Written this way so that NaN coordinates are also rejected.
+    if (!(maxX >= -TILE_BINNING_MARGIN && maxY >= -TILE_BINNING_MARGIN
+        && minX < windowWidth + TILE_BINNING_MARGIN && minY < windowHeight + TILE_BINNING_MARGIN))
+    {
+        return false;
+    }
+
+    // NOTE(sbalse): Clamp to the window before converting to int so that huge values can't overflow.
+    const int pixelMinX = scast<int>(std::floor(std::max(minX, 0.0f))) - TILE_BINNING_MARGIN;
+    const int pixelMinY = scast<int>(std::floor(std::max(minY, 0.0f))) - TILE_BINNING_MARGIN;
+    const int pixelMaxX = scast<int>(std::ceil(std::min(maxX, windowWidth))) + TILE_BINNING_MARGIN;
+    const int pixelMaxY = scast<int>(std::ceil(std::min(maxY, windowHeight))) + TILE_BINNING_MARGIN;
+
+    outTileRange->m_MinX = std::clamp(pixelMinX / RASTERIZER_TILE_SIZE, 0, numTilesX - 1);
+    outTileRange->m_MinY = std::clamp(pixelMinY / RASTERIZER_TILE_SIZE, 0, numTilesY - 1);
+    outTileRange->m_MaxX = std::clamp(pixelMaxX / RASTERIZER_TILE_SIZE, 0, numTilesX - 1);
+    outTileRange->m_MaxY = std::clamp(pixelMaxY / RASTERIZER_TILE_SIZE, 0, numTilesY - 1);
+
+    return true;
+}
+
+// NOTE(sbalse): Sort the triangles into the screen tiles they touch. Triangles keep their submission
+// order inside every tile.
+static TileBins BinTriangles(
+    Arena* const arena,
+    const Triangle* const triangles,
+    const size_t numTriangles)
+{
+    PROFILE_EVENT();
+
+    TileBins result = {};
+    result.m_Triangles = triangles;
+    result.m_NumTilesX = (GetWindowWidth() + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
+    result.m_NumTilesY = (GetWindowHeight() + RASTERIZER_TILE_SIZE - 1) / RASTERIZER_TILE_SIZE;
+
+    const int numTiles = result.m_NumTilesX * result.m_NumTilesY;
+    result.m_TileOffsets = PushArray(arena, u32, numTiles + 1);
+
+    ScreenRect* const tileRanges = PushArray(arena, ScreenRect, numTriangles);
+    bool* const isVisible = PushArray(arena, bool, numTriangles);
+
+    // NOTE(sbalse): First pass, count the triangles in each tile.
+    size_t numTriangleIndices = 0;
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        isVisible[i] = GetTriangleTileRange(
+            triangles[i],
+            result.m_NumTilesX,
+            result.m_NumTilesY,
+            &tileRanges[i]
+        );
+        if (!isVisible[i])
+        {
+            continue;
+        }
+
+        for (int tileY = tileRanges[i].m_MinY; tileY <= tileRanges[i].m_MaxY; tileY++)
+        {
+            for (int tileX = tileRanges[i].m_MinX; tileX <= tileRanges[i].m_MaxX; tileX++)
+            {
+                result.m_TileOffsets[(tileY * result.m_NumTilesX) + tileX + 1]++;
+                numTriangleIndices++;
+            }
+        }
+    }
+
+    // NOTE(sbalse): Turn the counts into offsets with a prefix sum.
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        result.m_TileOffsets[tile + 1] += result.m_TileOffsets[tile];
+    }
+
+    // NOTE(sbalse): Second pass, write the triangle indices. Use a copy of the offsets as the write
+    // cursors of each tile.
+    result.m_TriangleIndices = PushArray(arena, u32, numTriangleIndices);
+    u32* const tileCursors = PushArray(arena, u32, numTiles);
+    std::copy(result.m_TileOffsets, result.m_TileOffsets + numTiles, tileCursors);
+
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        if (!isVisible[i])
+        {
+            continue;
+        }
+
+        for (int tileY = tileRanges[i].m_MinY; tileY <= tileRanges[i].m_MaxY; tileY++)
+        {
+            for (int tileX = tileRanges[i].m_MinX; tileX <= tileRanges[i].m_MaxX; tileX++)
+            {
+                const int tile = (tileY * result.m_NumTilesX) + tileX;
+                result.m_TriangleIndices[tileCursors[tile]++] = scast<u32>(i);
+            }
+        }
+    }
+
+    return result;
+}
+
+// NOTE(sbalse): Thread pool callback. Draws all the triangles of one tile. Tiles don't overlap so
+// different threads never touch the same pixels of the color and z buffers.
+static void DrawTile(void* userData, const int tileIndex, const int threadIndex)
+{
+    PROFILE_EVENT();
+
+    const TileBins* const bins = scast<const TileBins*>(userData);
+
+    const int tileX = tileIndex % bins->m_NumTilesX;
+    const int tileY = tileIndex / bins->m_NumTilesX;
+
+    SetDrawClipRect(ScreenRect
+    {
+        .m_MinX = tileX * RASTERIZER_TILE_SIZE,
+        .m_MinY = tileY * RASTERIZER_TILE_SIZE,
+        .m_MaxX = (tileX + 1) * RASTERIZER_TILE_SIZE,
+        .m_MaxY = (tileY + 1) * RASTERIZER_TILE_SIZE,
+    });
+
+    for (u32 i = bins->m_TileOffsets[tileIndex]; i < bins->m_TileOffsets[tileIndex + 1]; i++)
+    {
+        const Triangle& triangle = bins->m_Triangles[bins->m_TriangleIndices[i]];
+        if (bins->m_IsDepthPrepass)
+        {
+            DrawTriangleDepthToRender(triangle, bins->m_RenderMethod);
+        }
+        else
+        {
+            DrawTriangleToRender(triangle, bins->m_RenderMethod);
+        }
+    }
+
+    ResetDrawClipRect();
+    FlushThreadFrameCounters();
+}
+
+// NOTE(sbalse): Draw the triangles, or only their depth for the depth pre-pass.
+static void RasterizeTrianglesPass(
+    Arena* const frameArena,
+    const Triangle* const triangles,
+    const size_t numTriangles,
+    const bool isDepthPrepass)
+{
+    PROFILE_EVENT();
+
+    const RenderMethod renderMethod = GetRenderMethod();
+
+    if (GetRasterizerMethod() == RasterizerMethod::Serial)
+    {
+        // NOTE(sbalse): Loop all projected triangles and render them.
+        for (size_t i = 0; i < numTriangles; i++)
+        {
+            if (isDepthPrepass)
+            {
+                DrawTriangleDepthToRender(triangles[i], renderMethod);
+            }
+            else
+            {
+                DrawTriangleToRender(triangles[i], renderMethod);
+            }
+        }
+        return;
+    }
+
+    // NOTE(sbalse): The bins are only needed until all the tiles are drawn.
+    TempArena temp = TempArenaBegin(frameArena);
+
+    TileBins bins = BinTriangles(temp.m_OriginalArena, triangles, numTriangles);
+    bins.m_RenderMethod = renderMethod;
+    bins.m_IsDepthPrepass = isDepthPrepass;
+
+    ThreadPoolParallelFor(bins.m_NumTilesX * bins.m_NumTilesY, DrawTile, &bins);
+
+    TempArenaEnd(&temp);
+}
+
+void RasterizeTriangles(
+    Arena* const frameArena,
+    const Triangle* const triangles,
+    const size_t numTriangles)
+{
+    PROFILE_EVENT();
+
+    if (GetDepthPrepassMethod() == DepthPrepassMethod::None)
+    {
+        RasterizeTrianglesPass(frameArena, triangles, numTriangles, false);
+        return;
+    }
+
+    // NOTE(sbalse): After the pre-pass the Z buffer holds the depth of the visible pixels, so only the pixels
+    // whose depth equals it get shaded in the second pass.
+    RasterizeTrianglesPass(frameArena, triangles, numTriangles, true);
+
+    SetDepthTestMethod(DepthTestMethod::LessEqual);
+    RasterizeTrianglesPass(frameArena, triangles, numTriangles, false);
+    SetDepthTestMethod(DepthTestMethod::Less);
+}
+
+// NOTE(sbalse): Quantized depths are TRIANGLE_SORT_KEY_BITS bits, sorted TRIANGLE_SORT_RADIX_BITS bits
+// per pass.
+inline constexpr int TRIANGLE_SORT_KEY_BITS = 16;
+inline constexpr int TRIANGLE_SORT_RADIX_BITS = 8;
+inline constexpr u32 TRIANGLE_SORT_RADIX = 1u << TRIANGLE_SORT_RADIX_BITS;
+inline constexpr float TRIANGLE_SORT_MAX_KEY = scast<float>((1u << TRIANGLE_SORT_KEY_BITS) - 1);
+
+void SortTrianglesFrontToBack(Arena* const frameArena, Triangle* const triangles, const size_t numTriangles)
+{
+    PROFILE_EVENT();
+
+    if (numTriangles < 2)
+    {
+        return;
+    }
+
+    TempArena temp = TempArenaBegin(frameArena);
+    Arena* const arena = temp.m_OriginalArena;
+
+    // NOTE(sbalse): The depth of a triangle is the average w (camera space depth) of its vertices.
+    float* const depths = PushArray(arena, float, numTriangles);
+    float minDepth = INFINITY;
+    float maxDepth = -INFINITY;
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        const Vec4* const points = triangles[i].m_Points;
+        depths[i] = (points[0].m_W + points[1].m_W + points[2].m_W) * (1.0f / 3.0f);
+        minDepth = std::min(minDepth, depths[i]);
+        maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // NOTE(sbalse): Quantize the depths over the range used by this frame's triangles.
+    const float keyScale = (maxDepth > minDepth) ? (TRIANGLE_SORT_MAX_KEY / (maxDepth - minDepth)) : 0.0f;
+    u16* const keys = PushArray(arena, u16, numTriangles);
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        // NOTE(sbalse): Written this way so that NaN depths get key 0.
+        const float key = (depths[i] - minDepth) * keyScale;
+        keys[i] = (key > 0.0f) ? scast<u16>(std::min(key, TRIANGLE_SORT_MAX_KEY)) : 0;
+    }
+
+    // NOTE(sbalse): LSD radix sort of the triangle indices. Every pass is stable so triangles with the same
+    // key keep their submission order.
+    u32* order = PushArray(arena, u32, numTriangles);
+    u32* sortedOrder = PushArray(arena, u32, numTriangles);
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        order[i] = scast<u32>(i);
+    }
+
+    for (int shift = 0; shift < TRIANGLE_SORT_KEY_BITS; shift += TRIANGLE_SORT_RADIX_BITS)
+    {
+        u32 offsets[TRIANGLE_SORT_RADIX + 1] = {};
+        for (size_t i = 0; i < numTriangles; i++)
+        {
+            offsets[((keys[order[i]] >> shift) & (TRIANGLE_SORT_RADIX - 1)) + 1]++;
+        }
+        for (u32 digit = 0; digit < TRIANGLE_SORT_RADIX; digit++)
+        {
+            offsets[digit + 1] += offsets[digit];
+        }
+        for (size_t i = 0; i < numTriangles; i++)
+        {
+            sortedOrder[offsets[(keys[order[i]] >> shift) & (TRIANGLE_SORT_RADIX - 1)]++] = order[i];
+        }
+
+        std::swap(order, sortedOrder);
+    }
+
+    Triangle* const sortedTriangles = PushArray(arena, Triangle, numTriangles);
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        sortedTriangles[i] = triangles[order[i]];
+    }
+    std::copy(sortedTriangles, sortedTriangles + numTriangles, triangles);
+
+    TempArenaEnd(&temp);
+}
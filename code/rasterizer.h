@@ -0,0 +1,24 @@
+#pragma once
+#include "common.h"
+#include "arena.h"
+#include "triangle.h"
+
+// NOTE(sbalse): Width and height in pixels of the screen tiles used by the tiled rasterizer.
+inline constexpr int RASTERIZER_TILE_SIZE = 64;
+
+// NOTE(sbalse): Draw the screen space triangles using the current render method. Depending on
+// GetRasterizerMethod() the triangles are either drawn one by one on the main thread or binned into
+// screen tiles which are then drawn in parallel on the thread pool. Both methods produce exactly the
+// same image since every pixel still sees the triangles in the same order.
+//
+// With DepthPrepassMethod::DepthOnly the depth of all the triangles is drawn first, and then the triangles
+// are drawn again with the depth test passing only the nearest pixel.
+void RasterizeTriangles(
+    Arena* const frameArena,
+    const Triangle* const triangles,
+    const size_t numTriangles
+);
+
+// NOTE(sbalse): Sort the triangles front to back with a radix sort on their quantized depth, so nearer
+// triangles are drawn first and hidden pixels behind them fail the depth test before being shaded.
+void SortTrianglesFrontToBack(Arena* const frameArena, Triangle* const triangles, const size_t numTriangles);
@@ -0,0 +1,381 @@
+#include "stats.h"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+#include "log.h"
+
+constinit static FrameStats g_CurrentFrameStats = {};
+constinit static FrameStats g_LastFrameStats = {};
+
+// NOTE(sbalse): A counter of the current frame. Each one is on its own cache line so that threads adding to
+// different counters don't fight over the same line.
+struct alignas(64) SharedFrameCounter
+{
+    std::atomic<u64> m_Value;
+};
+
+// NOTE(sbalse): The counters of the current frame are kept apart since they're added to from the worker
+// threads. They are moved into the frame stats when the frame ends.
+constinit static SharedFrameCounter g_CurrentFrameCounters[FrameCounter_Count] = {};
+// NOTE(sbalse): Counters added to by the calling thread that haven't been flushed to the frame yet.
+constinit static thread_local u64 g_ThreadFrameCounters[FrameCounter_Count] = {};
+
+constinit static FrameStats* g_RecordedFrameStats = nullptr;
+constinit static size_t g_RecordedFramesCount = 0;
+constinit static size_t g_MaxRecordedFrames = 0;
+
+StatsTimestamp GetStatsTimestamp()
+{
+    return std::chrono::steady_clock::now();
+}
+
+void AddFrameStageTime(const FrameStage stage, const StatsTimestamp start)
+{
+    const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+    g_CurrentFrameStats.m_StageMs[stage] += time.count();
+}
+
+void SetFrameTriangleCount(const size_t numTriangles)
+{
+    g_CurrentFrameStats.m_NumTriangles = numTriangles;
+}
+
+void AddFrameCounter(const FrameCounter counter, const u64 value)
+{
+    g_CurrentFrameCounters[counter].m_Value.fetch_add(value, std::memory_order_relaxed);
+}
+
+void AddThreadFrameCounter(const FrameCounter counter, const u64 value)
+{
+    g_ThreadFrameCounters[counter] += value;
+}
+
+void FlushThreadFrameCounters()
+{
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        if (g_ThreadFrameCounters[counter] > 0)
+        {
+            AddFrameCounter(scast<FrameCounter>(counter), g_ThreadFrameCounters[counter]);
+            g_ThreadFrameCounters[counter] = 0;
+        }
+    }
+}
+
+double GetLastFrameStageMs(const FrameStage stage)
+{
+    return g_LastFrameStats.m_StageMs[stage];
+}
+
+u64 GetLastFrameCounter(const FrameCounter counter)
+{
+    return g_LastFrameStats.m_Counters[counter];
+}
+
+void BeginStatsRecording(Arena* const arena, const size_t maxFrames)
+{
+    g_RecordedFrameStats = PushArray(arena, FrameStats, maxFrames);
+    g_RecordedFramesCount = 0;
+    g_MaxRecordedFrames = maxFrames;
+}
+
+bool IsRecordingStats()
+{
+    return g_RecordedFramesCount < g_MaxRecordedFrames;
+}
+
+void EndFrameStats()
+{
+    // NOTE(sbalse): Whatever the main thread drew outside of the thread pool jobs, e.g. with the serial rasterizer.
+    FlushThreadFrameCounters();
+
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        g_CurrentFrameStats.m_Counters[counter] = g_CurrentFrameCounters[counter].m_Value.exchange(0, std::memory_order_relaxed);
+    }
+
+    g_LastFrameStats = g_CurrentFrameStats;
+
+    if (g_RecordedFramesCount < g_MaxRecordedFrames)
+    {
+        PushStruct(g_CurrentFrameStats, g_RecordedFrameStats, g_RecordedFramesCount);
+    }
+
+    g_CurrentFrameStats = {};
+}
+
+const char* GetFrameStageName(const FrameStage stage)
+{
+    switch (stage)
+    {
+    case FrameStage_Transform: return "transform";
+    case FrameStage_Clip: return "clip";
+    case FrameStage_Sort: return "sort";
+    case FrameStage_Raster: return "raster";
+    case FrameStage_Clear: return "clear";
+    case FrameStage_Present: return "present";
+    default: return "unknown";
+    }
+}
+
+const char* GetFrameCounterName(const FrameCounter counter)
+{
+    switch (counter)
+    {
+    case FrameCounter_HiZTilesTested: return "hiz_tiles_tested";
+    case FrameCounter_HiZTilesRejected: return "hiz_tiles_rejected";
+    case FrameCounter_HiZTrianglesRejected: return "hiz_triangles_rejected";
+    case FrameCounter_PixelsDepthTested: return "pixels_depth_tested";
+    case FrameCounter_PixelsShaded: return "pixels_shaded";
+    case FrameCounter_PrepassPixelsDepthTested: return "prepass_pixels_depth_tested";
+    case FrameCounter_PixelsCovered: return "pixels_covered";
+    case FrameCounter_ZTilesLazilyCleared: return "z_tiles_lazily_cleared";
+    case FrameCounter_TrianglesTriviallyAccepted: return "triangles_trivially_accepted";
+    case FrameCounter_TrianglesGuardBandAccepted: return "triangles_guard_band_accepted";
+    case FrameCounter_TrianglesTriviallyRejected: return "triangles_trivially_rejected";
+    case FrameCounter_TrianglesClipped: return "triangles_clipped";
+    default: return "unknown";
+    }
+}
+
+static double GetFrameTotalMs(const FrameStats& frame)
+{
+    double total = 0.0;
+    for (int stage = 0; stage < FrameStage_Count; stage++)
+    {
+        total += frame.m_StageMs[stage];
+    }
+    return total;
+}
+
+static FrameStats GetAverageFrameStats()
+{
+    FrameStats average = {};
+    if (g_RecordedFramesCount == 0)
+    {
+        return average;
+    }
+
+    size_t totalTriangles = 0;
+    for (size_t i = 0; i < g_RecordedFramesCount; i++)
+    {
+        for (int stage = 0; stage < FrameStage_Count; stage++)
+        {
+            average.m_StageMs[stage] += g_RecordedFrameStats[i].m_StageMs[stage];
+        }
+        for (int counter = 0; counter < FrameCounter_Count; counter++)
+        {
+            average.m_Counters[counter] += g_RecordedFrameStats[i].m_Counters[counter];
+        }
+        totalTriangles += g_RecordedFrameStats[i].m_NumTriangles;
+    }
+
+    for (int stage = 0; stage < FrameStage_Count; stage++)
+    {
+        average.m_StageMs[stage] /= scast<double>(g_RecordedFramesCount);
+    }
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        average.m_Counters[counter] /= g_RecordedFramesCount;
+    }
+    average.m_NumTriangles = totalTriangles / g_RecordedFramesCount;
+
+    return average;
+}
+
+static void WriteStatsCsv(std::FILE* const file)
+{
+    std::fprintf(file, "frame");
+    for (int stage = 0; stage < FrameStage_Count; stage++)
+    {
+        std::fprintf(file, ",%s_ms", GetFrameStageName(scast<FrameStage>(stage)));
+    }
+    std::fprintf(file, ",total_ms,triangles");
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        std::fprintf(file, ",%s", GetFrameCounterName(scast<FrameCounter>(counter)));
+    }
+    std::fprintf(file, "\n");
+
+    for (size_t i = 0; i < g_RecordedFramesCount; i++)
+    {
+        const FrameStats& frame = g_RecordedFrameStats[i];
+
+        std::fprintf(file, "%zu", i);
+        for (int stage = 0; stage < FrameStage_Count; stage++)
+        {
+            std::fprintf(file, ",%.4f", frame.m_StageMs[stage]);
+        }
+        std::fprintf(file, ",%.4f,%zu", GetFrameTotalMs(frame), frame.m_NumTriangles);
+        for (int counter = 0; counter < FrameCounter_Count; counter++)
+        {
+            std::fprintf(file, ",%llu", scast<unsigned long long>(frame.m_Counters[counter]));
+        }
+        std::fprintf(file, "\n");
+    }
+}
+
+static void WriteStatsJsonFrame(std::FILE* const file, const FrameStats& frame)
+{
+    std::fprintf(file, "{ ");
+    for (int stage = 0; stage < FrameStage_Count; stage++)
+    {
+        std::fprintf(file, "\"%s_ms\": %.4f, ", GetFrameStageName(scast<FrameStage>(stage)), frame.m_StageMs[stage]);
+    }
+    std::fprintf(file, "\"total_ms\": %.4f, \"triangles\": %zu", GetFrameTotalMs(frame), frame.m_NumTriangles);
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        std::fprintf(
+            file,
+            ", \"%s\": %llu",
+            GetFrameCounterName(scast<FrameCounter>(counter)),
+            scast<unsigned long long>(frame.m_Counters[counter])
+        );
+    }
+    std::fprintf(file, " }");
+}
+
+static void WriteStatsJson(std::FILE* const file)
+{
+    std::fprintf(file, "{\n  \"frame_count\": %zu,\n  \"average\": ", g_RecordedFramesCount);
+    WriteStatsJsonFrame(file, GetAverageFrameStats());
+    std::fprintf(file, ",\n  \"frames\":\n  [\n");
+
+    for (size_t i = 0; i < g_RecordedFramesCount; i++)
+    {
+        std::fprintf(file, "    ");
+        WriteStatsJsonFrame(file, g_RecordedFrameStats[i]);
+        std::fprintf(file, (i + 1 < g_RecordedFramesCount) ? ",\n" : "\n");
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+}
+
+bool WriteRecordedStats(const char* const fileName)
+{
+    std::FILE* file = nullptr;
+    fopen_s(&file, fileName, "w");
+    if (!file)
+    {
+        LOG_ERROR("Failed to open stats file: %s.", fileName);
+        return false;
+    }
+
+    const size_t fileNameLength = std::strlen(fileName);
+    const bool isJson = fileNameLength >= 5 && std::strcmp(fileName + fileNameLength - 5, ".json") == 0;
+    if (isJson)
+    {
+        WriteStatsJson(file);
+    }
+    else
+    {
+        WriteStatsCsv(file);
+    }
+
+    const bool isWritten = !std::ferror(file);
+    std::fclose(file);
+
+    if (!isWritten)
+    {
+        LOG_ERROR("Failed to write stats file: %s.", fileName);
+        return false;
+    }
+
+    LOG_INFO("Wrote stats of %zu frames to: %s.", g_RecordedFramesCount, fileName);
+    return true;
+}
+
+void LogRecordedStatsSummary()
+{
+    if (g_RecordedFramesCount == 0)
+    {
+        return;
+    }
+
+    const FrameStats average = GetAverageFrameStats();
+
+    for (int stage = 0; stage < FrameStage_Count; stage++)
+    {
+        double minMs = g_RecordedFrameStats[0].m_StageMs[stage];
+        double maxMs = minMs;
+        for (size_t i = 1; i < g_RecordedFramesCount; i++)
+        {
+            minMs = std::min(minMs, g_RecordedFrameStats[i].m_StageMs[stage]);
+            maxMs = std::max(maxMs, g_RecordedFrameStats[i].m_StageMs[stage]);
+        }
+
+        LOG_INFO(
+            "%-9s avg %8.3f ms, min %8.3f ms, max %8.3f ms",
+            GetFrameStageName(scast<FrameStage>(stage)),
+            average.m_StageMs[stage],
+            minMs,
+            maxMs
+        );
+    }
+
+    const double averageTotalMs = GetFrameTotalMs(average);
+    LOG_INFO(
+        "total     avg %8.3f ms (%.1f fps), %zu triangles per frame on average.",
+        averageTotalMs,
+        (averageTotalMs > 0.0) ? (1000.0 / averageTotalMs) : 0.0,
+        average.m_NumTriangles
+    );
+
+    for (int counter = 0; counter < FrameCounter_Count; counter++)
+    {
+        LOG_INFO(
+            "%-29s avg %10llu per frame",
+            GetFrameCounterName(scast<FrameCounter>(counter)),
+            scast<unsigned long long>(average.m_Counters[counter])
+        );
+    }
+
+    const u64 hiZTilesTested = average.m_Counters[FrameCounter_HiZTilesTested];
+    if (hiZTilesTested > 0)
+    {
+        LOG_INFO(
+            "Hierarchical Z rejected %.1f%% of the tested tiles.",
+            100.0 * scast<double>(average.m_Counters[FrameCounter_HiZTilesRejected]) / scast<double>(hiZTilesTested)
+        );
+    }
+
+    const u64 trianglesClipTested = average.m_Counters[FrameCounter_TrianglesTriviallyAccepted]
+        + average.m_Counters[FrameCounter_TrianglesGuardBandAccepted]
+        + average.m_Counters[FrameCounter_TrianglesTriviallyRejected]
+        + average.m_Counters[FrameCounter_TrianglesClipped];
+    if (trianglesClipTested > 0)
+    {
+        LOG_INFO(
+            "Clipping trivially accepted %.1f%%, guard band accepted %.1f%% and rejected %.1f%% of the triangles left "
+            "after culling, clipped %.1f%%.",
+            100.0 * scast<double>(average.m_Counters[FrameCounter_TrianglesTriviallyAccepted]) / scast<double>(trianglesClipTested),
+            100.0 * scast<double>(average.m_Counters[FrameCounter_TrianglesGuardBandAccepted]) / scast<double>(trianglesClipTested),
+            100.0 * scast<double>(average.m_Counters[FrameCounter_TrianglesTriviallyRejected]) / scast<double>(trianglesClipTested),
+            100.0 * scast<double>(average.m_Counters[FrameCounter_TrianglesClipped]) / scast<double>(trianglesClipTested)
+        );
+    }
+
+    const u64 pixelsDepthTested = average.m_Counters[FrameCounter_PixelsDepthTested];
+    if (pixelsDepthTested > 0)
+    {
+        LOG_INFO(
+            "Early Z killed %.1f%% of the depth tested pixels before shading.",
+            100.0 * scast<double>(pixelsDepthTested - average.m_Counters[FrameCounter_PixelsShaded]) / scast<double>(pixelsDepthTested)
+        );
+    }
+
+    // NOTE(sbalse): An overdraw of 1 means every covered pixel was shaded exactly once.
+    const u64 pixelsCovered = average.m_Counters[FrameCounter_PixelsCovered];
+    if (pixelsCovered > 0)
+    {
+        LOG_INFO(
+            "Overdraw: %.2f shaded, %.2f depth tested and %.2f pre-pass depth tested pixels per covered pixel.",
+            scast<double>(average.m_Counters[FrameCounter_PixelsShaded]) / scast<double>(pixelsCovered),
+            scast<double>(pixelsDepthTested) / scast<double>(pixelsCovered),
+            scast<double>(average.m_Counters[FrameCounter_PrepassPixelsDepthTested]) / scast<double>(pixelsCovered)
+        );
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+
+#include "common.h"
+#include "arena.h"
+
+// NOTE(sbalse): The stages of a frame that are timed separately.
+enum FrameStage
+{
+    FrameStage_Transform, // NOTE(sbalse): Model space to camera space vertex transform.
+    FrameStage_Clip, // NOTE(sbalse): Culling, clipping, projection and triangle assembly.
+    FrameStage_Sort, // NOTE(sbalse): Sorting the triangles front to back, when on.
+    FrameStage_Raster, // NOTE(sbalse): Drawing the triangles (and the grid).
+    FrameStage_Clear, // NOTE(sbalse): Clearing the color and Z buffers.
+    FrameStage_Present, // NOTE(sbalse): Handing the finished buffer to SDL.
+    FrameStage_Count,
+};
+
+// NOTE(sbalse): Things counted during a frame. Can be added to from any thread.
+enum FrameCounter
+{
+    FrameCounter_HiZTilesTested, // NOTE(sbalse): Triangle and hierarchical Z tile pairs tested.
+    FrameCounter_HiZTilesRejected, // NOTE(sbalse): Tested tiles where the triangle was completely hidden.
+    FrameCounter_HiZTrianglesRejected, // NOTE(sbalse): Triangles that were hidden in all their tiles.
+    FrameCounter_PixelsDepthTested, // NOTE(sbalse): Pixels inside a triangle that went through the depth test.
+    FrameCounter_PixelsShaded, // NOTE(sbalse): Pixels that passed the depth test and were shaded and written.
+    FrameCounter_PrepassPixelsDepthTested, // NOTE(sbalse): Pixels that went through the depth pre-pass.
+    FrameCounter_PixelsCovered, // NOTE(sbalse): Pixels covered by any triangle at the end of the frame.
+    FrameCounter_ZTilesLazilyCleared, // NOTE(sbalse): Z buffer tiles cleared on first touch when epoch tagged.
+    FrameCounter_TrianglesTriviallyAccepted, // NOTE(sbalse): Faces completely inside the frustum, not clipped.
+    FrameCounter_TrianglesGuardBandAccepted, // NOTE(sbalse): Faces crossing only the screen edges, not clipped.
+    FrameCounter_TrianglesTriviallyRejected, // NOTE(sbalse): Faces completely outside one of the frustum planes.
+    FrameCounter_TrianglesClipped, // NOTE(sbalse): Faces crossing a frustum plane, clipped against the planes they cross.
+    FrameCounter_Count,
+};
+
+struct FrameStats
+{
+    double m_StageMs[FrameStage_Count]; // NOTE(sbalse): Time spent in each stage in milliseconds.
+    size_t m_NumTriangles; // NOTE(sbalse): Triangles sent to the rasterizer.
+    u64 m_Counters[FrameCounter_Count];
+};
+
+using StatsTimestamp = std::chrono::steady_clock::time_point;
+
+StatsTimestamp GetStatsTimestamp();
+
+// NOTE(sbalse): Add the time since start to a stage of the current frame. A stage can be timed in several
+// pieces, e.g. once per mesh.
+void AddFrameStageTime(const FrameStage stage, const StatsTimestamp start);
+void SetFrameTriangleCount(const size_t numTriangles);
+void AddFrameCounter(const FrameCounter counter, const u64 value);
+// NOTE(sbalse): Add to a counter of the calling thread, without any atomics. For the counters that are added to
+// for every triangle. They only count for the frame once the thread calls FlushThreadFrameCounters(), which the
+// thread pool jobs that add to them do when they finish. EndFrameStats() flushes the ones of the main thread.
+void AddThreadFrameCounter(const FrameCounter counter, const u64 value);
+void FlushThreadFrameCounters();
+// NOTE(sbalse): The stage times and counters of the last finished frame.
+double GetLastFrameStageMs(const FrameStage stage);
+u64 GetLastFrameCounter(const FrameCounter counter);
+
+// NOTE(sbalse): Keep the stats of up to maxFrames frames so that they can be written out at the end.
+void BeginStatsRecording(Arena* const arena, const size_t maxFrames);
+// NOTE(sbalse): Whether frames are being recorded. Stats that cost extra time to gather are only gathered
+// then.
+bool IsRecordingStats();
+// NOTE(sbalse): Finish the current frame. Its stats are recorded if recording and then reset.
+void EndFrameStats();
+
+const char* GetFrameStageName(const FrameStage stage);
+const char* GetFrameCounterName(const FrameCounter counter);
+
+// NOTE(sbalse): Write the recorded frames, one row per frame plus the averages. Files ending in ".json"
+// are written as JSON, everything else as CSV.
+bool WriteRecordedStats(const char* const fileName);
+// NOTE(sbalse): Log the average, min and max time of each stage and the average of each counter over the
+// recorded frames.
+void LogRecordedStatsSummary();
@@ -0,0 +1,218 @@
+#include "texture.h"
+
+#include <bit>
+#include <algorithm>
+
+// NOTE(sbalse): The Morton index bit of each bit of a coordinate. The low numInterleavedBits bits of x and y
+// alternate (x in the even bits, y in the odd bits). The dimension that is bigger than the other one has
+// bits left over, which go above all of the interleaved ones.
+static u32 SpreadMortonBits(const u32 value, const u32 numInterleavedBits, const u32 firstBit)
+{
+    u32 result = 0;
+    for (u32 bit = 0; bit < 32; bit++)
+    {
+        if ((value & (u32(1) << bit)) == 0)
+        {
+            continue;
+        }
+
+        const u32 indexBit = (bit < numInterleavedBits) ? ((2 * bit) + firstBit) : (numInterleavedBits + bit);
+        result |= u32(1) << indexBit;
+    }
+    return result;
+}
+
+static void FillMortonTable(u32* const table, const u32 size, const u32 numInterleavedBits, const u32 firstBit)
+{
+    for (u32 i = 0; i < size; i++)
+    {
+        table[i] = SpreadMortonBits(i, numInterleavedBits, firstBit);
+    }
+}
+
+// NOTE(sbalse): Average of four texels, per 8 bit channel and rounded to nearest.
+static u32 AverageTexels(const u32 a, const u32 b, const u32 c, const u32 d)
+{
+    u32 result = 0;
+    for (u32 shift = 0; shift < 32; shift += 8)
+    {
+        const u32 sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+        result |= ((sum + 2) / 4) << shift;
+    }
+    return result;
+}
+
+// NOTE(sbalse): Allocate the texels of all the levels of a texture made with MakeTextureMips(), and fill in
+// the Morton tables when it uses them.
+static u32* PushTextureTexels(Arena* const arena, Texture* const texture)
+{
+    u32* const texels = PushArray(arena, u32, GetTextureTexelsCount(*texture));
+    texture->m_Texels = texels;
+
+    if (texture->m_Layout == TextureLayout::Morton)
+    {
+        u32* const mortonTables = PushArray(arena, u32, GetTextureMortonTablesCount(*texture));
+        for (int level = 0; level < texture->m_NumMips; level++)
+        {
+            const TextureMip& mip = texture->m_Mips[level];
+            const u32 numInterleavedBits = std::min(mip.m_WidthLog2, mip.m_HeightLog2);
+            FillMortonTable(mortonTables + mip.m_MortonOffset, mip.m_Width, numInterleavedBits, 0);
+            FillMortonTable(mortonTables + mip.m_MortonOffset + mip.m_Width, mip.m_Height, numInterleavedBits, 1);
+        }
+        texture->m_MortonTables = mortonTables;
+    }
+
+    return texels;
+}
+
+Texture MakeTextureMips(const u32 width, const u32 height, const TextureLayout layout)
+{
+    Texture texture = {};
+    texture.m_Layout = layout;
+    if (width == 0 || height == 0)
+    {
+        return texture;
+    }
+
+    // NOTE(sbalse): Round up to the next power of two so no detail is lost, unless it's over the max size.
+    const u32 widthLog2 = std::min(scast<u32>(std::bit_width(std::bit_ceil(width)) - 1), MAX_TEXTURE_SIZE_LOG2);
+    const u32 heightLog2 = std::min(scast<u32>(std::bit_width(std::bit_ceil(height)) - 1), MAX_TEXTURE_SIZE_LOG2);
+    texture.m_NumMips = scast<int>(std::max(widthLog2, heightLog2)) + 1;
+
+    // NOTE(sbalse): All the levels go in one allocation so the texel of any level can be found from the
+    // start of level 0.
+    size_t numTexels = 0;
+    size_t numMortonEntries = 0;
+    for (int level = 0; level < texture.m_NumMips; level++)
+    {
+        TextureMip& mip = texture.m_Mips[level];
+        mip.m_WidthLog2 = (widthLog2 > scast<u32>(level)) ? (widthLog2 - level) : 0;
+        mip.m_HeightLog2 = (heightLog2 > scast<u32>(level)) ? (heightLog2 - level) : 0;
+        mip.m_Width = u32(1) << mip.m_WidthLog2;
+        mip.m_Height = u32(1) << mip.m_HeightLog2;
+        mip.m_WidthMask = mip.m_Width - 1;
+        mip.m_HeightMask = mip.m_Height - 1;
+        mip.m_TexelsOffset = scast<u32>(numTexels);
+        mip.m_MortonOffset = scast<u32>(numMortonEntries);
+
+        numTexels += scast<size_t>(mip.m_Width) * mip.m_Height;
+        numMortonEntries += scast<size_t>(mip.m_Width) + mip.m_Height;
+    }
+
+    return texture;
+}
+
+size_t GetTextureTexelsCount(const Texture& texture)
+{
+    if (texture.m_NumMips == 0)
+    {
+        return 0;
+    }
+
+    const TextureMip& lastMip = texture.m_Mips[texture.m_NumMips - 1];
+    return lastMip.m_TexelsOffset + (scast<size_t>(lastMip.m_Width) * lastMip.m_Height);
+}
+
+size_t GetTextureMortonTablesCount(const Texture& texture)
+{
+    if (texture.m_Layout != TextureLayout::Morton || texture.m_NumMips == 0)
+    {
+        return 0;
+    }
+
+    const TextureMip& lastMip = texture.m_Mips[texture.m_NumMips - 1];
+    return lastMip.m_MortonOffset + scast<size_t>(lastMip.m_Width) + lastMip.m_Height;
+}
+
+Texture CreateTexture(
+    Arena* const arena,
+    const u32* const texels,
+    const u32 width,
+    const u32 height,
+    const TextureLayout layout
+)
+{
+    if (!texels || width == 0 || height == 0)
+    {
+        return MakeTextureMips(0, 0, layout);
+    }
+
+    Texture texture = MakeTextureMips(width, height, layout);
+    u32* const textureTexels = PushTextureTexels(arena, &texture);
+
+    // NOTE(sbalse): Level 0 picks the source texel nearest to the center of each texel. That's an exact copy
+    // when the source is already a power of two.
+    const TextureMip& baseMip = texture.m_Mips[0];
+    for (u32 y = 0; y < baseMip.m_Height; y++)
+    {
+        const u32 sourceY = scast<u32>(((2 * scast<u64>(y) + 1) * height) / (2 * scast<u64>(baseMip.m_Height)));
+        for (u32 x = 0; x < baseMip.m_Width; x++)
+        {
+            const u32 sourceX = scast<u32>(((2 * scast<u64>(x) + 1) * width) / (2 * scast<u64>(baseMip.m_Width)));
+            textureTexels[GetTexelIndex(texture, 0, x, y)] = texels[(scast<size_t>(sourceY) * width) + sourceX];
+        }
+    }
+
+    // NOTE(sbalse): Every other level is a 2x2 box filter of the one before it. Once one side is down to a
+    // single texel the same texel is used twice on that side.
+    for (int level = 1; level < texture.m_NumMips; level++)
+    {
+        const TextureMip& source = texture.m_Mips[level - 1];
+        const TextureMip& mip = texture.m_Mips[level];
+        const u32 stepX = (source.m_Width > 1) ? 1 : 0;
+        const u32 stepY = (source.m_Height > 1) ? 1 : 0;
+
+        for (u32 y = 0; y < mip.m_Height; y++)
+        {
+            const u32 sourceY0 = y << stepY;
+            const u32 sourceY1 = sourceY0 + stepY;
+            for (u32 x = 0; x < mip.m_Width; x++)
+            {
+                const u32 sourceX0 = x << stepX;
+                const u32 sourceX1 = sourceX0 + stepX;
+                textureTexels[GetTexelIndex(texture, level, x, y)] = AverageTexels(
+                    textureTexels[GetTexelIndex(texture, level - 1, sourceX0, sourceY0)],
+                    textureTexels[GetTexelIndex(texture, level - 1, sourceX1, sourceY0)],
+                    textureTexels[GetTexelIndex(texture, level - 1, sourceX0, sourceY1)],
+                    textureTexels[GetTexelIndex(texture, level - 1, sourceX1, sourceY1)]
+                );
+            }
+        }
+    }
+
+    return texture;
+}
+
+Texture ChangeTextureLayout(Arena* const arena, const Texture& source, const TextureLayout layout)
+{
+    Texture texture = MakeTextureMips(source.m_Mips[0].m_Width, source.m_Mips[0].m_Height, layout);
+    if (source.m_NumMips == 0)
+    {
+        return texture;
+    }
+
+    u32* const textureTexels = PushTextureTexels(arena, &texture);
+    for (int level = 0; level < texture.m_NumMips; level++)
+    {
+        const TextureMip& mip = texture.m_Mips[level];
+        for (u32 y = 0; y < mip.m_Height; y++)
+        {
+            for (u32 x = 0; x < mip.m_Width; x++)
+            {
+                textureTexels[GetTexelIndex(texture, level, x, y)] = source.m_Texels[GetTexelIndex(source, level, x, y)];
+            }
+        }
+    }
+
+    return texture;
+}
+
+const char* GetTextureLayoutName(const TextureLayout layout)
+{
+    switch (layout)
+    {
+    case TextureLayout::Linear: return "linear";
+    case TextureLayout::Morton: return "morton";
+    default: return "unknown";
+    }
+}
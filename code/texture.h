@@ -1,4 +1,9 @@
 #pragma once
+#include <bit>
+#include <algorithm>
+
+#include "common.h"
+#include "arena.h"
 
 // NOTE(sbalse): A texture type.
 struct Tex2
@@ -6,3 +11,103 @@ struct Tex2
     float m_U;
     float m_V;
 };
+
+// NOTE(sbalse): How the texels of each mip level are ordered in memory.
+enum class TextureLayout
+{
+    Linear, // NOTE(sbalse): Row after row.
+    Morton, // NOTE(sbalse): Along a Z-order curve, so texels that are close in 2D are mostly close in memory too.
+};
+
+// NOTE(sbalse): Textures bigger than this are scaled down when they are created. Keeps every texel index
+// of every layout inside a signed 32 bit integer for the vector kernels.
+inline constexpr u32 MAX_TEXTURE_SIZE_LOG2 = 14;
+inline constexpr int MAX_TEXTURE_MIP_LEVELS = MAX_TEXTURE_SIZE_LOG2 + 1;
+
+// NOTE(sbalse): One level of the mip chain. The width and height are powers of two so texel coordinates
+// wrap around with a mask instead of a modulo.
+struct TextureMip
+{
+    u32 m_Width;
+    u32 m_Height;
+    u32 m_WidthLog2;
+    u32 m_HeightLog2;
+    u32 m_WidthMask;
+    u32 m_HeightMask;
+    u32 m_TexelsOffset; // NOTE(sbalse): Where the texels of the level start in Texture::m_Texels.
+
+    // NOTE(sbalse): Only used with TextureLayout::Morton. Where the Morton tables of the level start in
+    // Texture::m_MortonTables. The table for x has m_Width entries and the one for y follows it.
+    u32 m_MortonOffset;
+};
+
+// NOTE(sbalse): The vector kernels gather the offsets of the mip level of each lane straight out of the
+// TextureMip array, with the level times this as the index.
+inline constexpr int TEXTURE_MIP_STRIDE = sizeof(TextureMip) / sizeof(u32);
+static_assert(sizeof(TextureMip) % sizeof(u32) == 0);
+
+// NOTE(sbalse): A texture with power of two dimensions and all of its mip levels. Created at load time from
+// decoded pixels, or cooked into a mesh file and used straight from the mapping.
+struct Texture
+{
+    // NOTE(sbalse): The texels of all the levels, level 0 first. One u32 per texel in the byte order of the
+    // PNG decoder (RGBA).
+    const u32* m_Texels;
+
+    // NOTE(sbalse): Only used with TextureLayout::Morton. The bits of a texel x and y coordinate spread out
+    // to where they go in the Morton index, so the index is mortonX[x] | mortonY[y].
+    const u32* m_MortonTables;
+
+    TextureMip m_Mips[MAX_TEXTURE_MIP_LEVELS]; // NOTE(sbalse): Level 0 is the full size, each next level is half as big down to 1x1.
+    int m_NumMips; // NOTE(sbalse): 0 for a texture without texels.
+    TextureLayout m_Layout;
+};
+
+// NOTE(sbalse): Build the texture and its mip chain from width x height texels in the PNG decoder byte
+// order. All the memory comes from the arena. Returns an empty texture if there are no texels.
+Texture CreateTexture(
+    Arena* const arena,
+    const u32* const texels,
+    const u32 width,
+    const u32 height,
+    const TextureLayout layout
+);
+// NOTE(sbalse): The same texture with its texels reordered to another layout. Only moves texels around, so
+// it's a lot cheaper than resizing and filtering the mip chain again.
+Texture ChangeTextureLayout(Arena* const arena, const Texture& source, const TextureLayout layout);
+
+// NOTE(sbalse): The mip levels of the texture CreateTexture() makes out of width x height texels, without
+// the texels and Morton tables. Returns an empty texture for a width or height of 0.
+Texture MakeTextureMips(const u32 width, const u32 height, const TextureLayout layout);
+// NOTE(sbalse): Sizes of the m_Texels and m_MortonTables arrays, in u32s.
+size_t GetTextureTexelsCount(const Texture& texture);
+size_t GetTextureMortonTablesCount(const Texture& texture);
+
+const char* GetTextureLayoutName(const TextureLayout layout);
+
+// NOTE(sbalse): Index into m_Texels of the texel at x, y of a mip level. x and y have to be wrapped already.
+inline u32 GetTexelIndex(const Texture& texture, const int level, const u32 x, const u32 y)
+{
+    const TextureMip& mip = texture.m_Mips[level];
+    const u32 indexInLevel = (texture.m_Layout == TextureLayout::Morton)
+        ? (texture.m_MortonTables[mip.m_MortonOffset + x] | texture.m_MortonTables[mip.m_MortonOffset + mip.m_Width + y])
+        : ((y << mip.m_WidthLog2) | x);
+    return mip.m_TexelsOffset + indexInLevel;
+}
+
+// NOTE(sbalse): Same as GetTexelIndex() but x and y are level 0 texel coordinates that haven't been wrapped.
+// Sampling any level from the level 0 coordinates keeps all the levels lined up exactly.
+inline u32 GetTexelIndexFromBaseCoordinates(const Texture& texture, const int level, const u32 baseX, const u32 baseY)
+{
+    const TextureMip& mip = texture.m_Mips[level];
+    return GetTexelIndex(texture, level, (baseX >> level) & mip.m_WidthMask, (baseY >> level) & mip.m_HeightMask);
+}
+
+// NOTE(sbalse): The mip level to sample when a pixel covers texelsPerPixelSquared^(1/2) level 0 texels along
+// its longer axis, rounded down. floor(log2(x) / 2) is half of the unbiased float exponent of x, rounded
+// down, which the vector kernels get with the same integer operations.
+inline int GetMipLevel(const float texelsPerPixelSquared, const int minLevel, const int maxLevel)
+{
+    const int level = (scast<int>(std::bit_cast<u32>(texelsPerPixelSquared) >> 23) - 127) >> 1;
+    return std::clamp(level, minLevel, maxLevel);
+}
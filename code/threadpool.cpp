@@ -0,0 +1,484 @@
+#include "threadpool.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+#include "log.h"
+#include "profile.h"
+
+struct ParallelFor;
+
+// NOTE(sbalse): A queued piece of work. Either a single job function, or a range of the indices of a
+// parallel for.
+struct Job
+{
+    JobFunc m_Func;
+    void* m_UserData;
+    JobCounter* m_Counter; // NOTE(sbalse): Decremented once the job has run. Can be null.
+
+    ParallelFor* m_ParallelFor; // NOTE(sbalse): Only set for the ranges of a parallel for.
+    int m_Begin;
+    int m_End;
+
+    Job* m_NextContinuation; // NOTE(sbalse): Next job waiting for the same JobCounter.
+
+    std::atomic<bool>* m_IsInUse; // NOTE(sbalse): Flag of the job's slot in the pool of the thread that allocated it.
+};
+
+struct ParallelFor
+{
+    ParallelForFunc m_Func;
+    void* m_UserData;
+    int m_Grain; // NOTE(sbalse): Ranges of up to this many indices aren't split any further.
+    JobCounter m_Counter;
+};
+
+// NOTE(sbalse): Every thread allocates its jobs round robin from its own pool. A slot is in use from when its
+// job is allocated until it has run, which includes the time it spends queued or waiting for a JobCounter.
+inline constexpr int MAX_JOBS_PER_THREAD = 4096;
+// NOTE(sbalse): A job that doesn't fit in the deque of its thread is run right away instead.
+inline constexpr u32 MAX_QUEUED_JOBS_PER_THREAD = 1024;
+// NOTE(sbalse): A parallel for is split down to about this many ranges per thread, so that threads that
+// finish early have something left to steal.
+inline constexpr int PARALLEL_FOR_RANGES_PER_THREAD = 8;
+
+// NOTE(sbalse): The deque of jobs of a thread. The owning thread pushes and pops at the bottom, so it keeps
+// working on the newest and smallest ranges whose data is still in its cache. Other threads steal from the
+// top, which holds the oldest and biggest ranges. The lock is only held for a few instructions.
+struct WorkerQueue
+{
+    std::mutex m_Mutex;
+    Job* m_Jobs[MAX_QUEUED_JOBS_PER_THREAD];
+    u32 m_Top;
+    u32 m_Bottom;
+};
+
+// NOTE(sbalse): Cache line aligned so that threads don't fight over each other's queue.
+struct alignas(64) ThreadState
+{
+    WorkerQueue m_Queue;
+    Job* m_Jobs;
+    std::atomic<bool>* m_IsJobInUse; // NOTE(sbalse): Only set by the owning thread, cleared by whoever runs the job.
+    int m_NextJob;
+    Arena m_FrameArena;
+};
+
+static std::thread g_Workers[MAX_NUM_THREADS] = {};
+static ThreadState g_ThreadStates[MAX_NUM_THREADS] = {};
+
+static std::mutex g_Mutex;
+static std::condition_variable g_WakeCondition; // NOTE(sbalse): Signals the sleeping workers that jobs got queued.
+static constinit bool g_ShuttingDown = false; // NOTE(sbalse): Protected by g_Mutex.
+
+static constinit std::atomic<int> g_NumQueuedJobs = 0;
+static constinit std::atomic<int> g_NumSleepingWorkers = 0;
+
+static constinit int g_MaxThreadCount = 1;
+static constinit std::atomic<int> g_ThreadCount = 1;
+
+static constinit thread_local int g_ThreadIndex = 0; // NOTE(sbalse): 0 is the main thread.
+
+static Job* FindJob(const int threadIndex);
+static void ExecuteJob(Job* const job, const int threadIndex);
+
+// NOTE(sbalse): Take the next free slot of the calling thread's pool. A slot whose job hasn't run yet is never
+// handed out again. When all of them are taken, run queued jobs until one frees up.
+static Job* AllocateJob()
+{
+    ThreadState& state = g_ThreadStates[g_ThreadIndex];
+    while (true)
+    {
+        for (int i = 0; i < MAX_JOBS_PER_THREAD; i++)
+        {
+            const int jobIndex = state.m_NextJob;
+            state.m_NextJob = (state.m_NextJob + 1) % MAX_JOBS_PER_THREAD;
+
+            if (!state.m_IsJobInUse[jobIndex].exchange(true, std::memory_order_acquire))
+            {
+                Job* const job = &state.m_Jobs[jobIndex];
+                *job = {};
+                job->m_IsInUse = &state.m_IsJobInUse[jobIndex];
+                return job;
+            }
+        }
+
+        Job* const queuedJob = FindJob(g_ThreadIndex);
+        if (queuedJob)
+        {
+            ExecuteJob(queuedJob, g_ThreadIndex);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// NOTE(sbalse): Push the job to the bottom of the deque of the calling thread and wake up a worker to steal it.
+static void QueueJob(Job* const job)
+{
+    WorkerQueue& queue = g_ThreadStates[g_ThreadIndex].m_Queue;
+
+    bool isQueued = false;
+    {
+        std::lock_guard lock(queue.m_Mutex);
+        if (queue.m_Bottom - queue.m_Top < MAX_QUEUED_JOBS_PER_THREAD)
+        {
+            queue.m_Jobs[queue.m_Bottom % MAX_QUEUED_JOBS_PER_THREAD] = job;
+            queue.m_Bottom++;
+            isQueued = true;
+        }
+    }
+
+    if (!isQueued)
+    {
+        ExecuteJob(job, g_ThreadIndex);
+        return;
+    }
+
+    // NOTE(sbalse): A worker going to sleep increments the sleeping count before it checks the queued count
+    // one last time under g_Mutex, so either it sees this job or we see it sleeping and wake it up.
+    g_NumQueuedJobs.fetch_add(1);
+    if (g_NumSleepingWorkers.load() > 0)
+    {
+        {
+            std::lock_guard lock(g_Mutex);
+        }
+        g_WakeCondition.notify_one();
+    }
+}
+
+// NOTE(sbalse): Take the newest job of the thread's own deque, or else steal the oldest job of another thread.
+static Job* FindJob(const int threadIndex)
+{
+    for (int i = 0; i < g_MaxThreadCount; i++)
+    {
+        const int victimIndex = (threadIndex + i) % g_MaxThreadCount;
+        WorkerQueue& queue = g_ThreadStates[victimIndex].m_Queue;
+
+        Job* job = nullptr;
+        {
+            std::lock_guard lock(queue.m_Mutex);
+            if (queue.m_Top == queue.m_Bottom)
+            {
+                continue;
+            }
+
+            if (victimIndex == threadIndex)
+            {
+                queue.m_Bottom--;
+                job = queue.m_Jobs[queue.m_Bottom % MAX_QUEUED_JOBS_PER_THREAD];
+            }
+            else
+            {
+                job = queue.m_Jobs[queue.m_Top % MAX_QUEUED_JOBS_PER_THREAD];
+                queue.m_Top++;
+            }
+        }
+
+        g_NumQueuedJobs.fetch_sub(1);
+        return job;
+    }
+
+    return nullptr;
+}
+
+// NOTE(sbalse): Remove a finished job from its counter. The last one queues the jobs that were waiting for
+// the counter and wakes up the threads sleeping in ThreadPoolWaitForCounter(). The counter lock is held while
+// decrementing so that a waiting thread can't destroy the counter before we're done with it.
+static void FinishCounterJob(JobCounter* const counter)
+{
+    bool isCounterDone = false;
+    Job* continuations = nullptr;
+    {
+        std::lock_guard lock(counter->m_Mutex);
+        if (counter->m_NumPending.fetch_sub(1) == 1)
+        {
+            isCounterDone = true;
+            continuations = counter->m_Continuations;
+            counter->m_Continuations = nullptr;
+        }
+    }
+
+    // NOTE(sbalse): Same as in QueueJob(), a thread that goes to sleep counts itself as sleeping before it
+    // checks the counter one last time. We don't know which of the sleeping threads waits for this counter so
+    // wake all of them.
+    if (isCounterDone && g_NumSleepingWorkers.load() > 0)
+    {
+        {
+            std::lock_guard lock(g_Mutex);
+        }
+        g_WakeCondition.notify_all();
+    }
+
+    while (continuations)
+    {
+        Job* const next = continuations->m_NextContinuation;
+        QueueJob(continuations);
+        continuations = next;
+    }
+}
+
+// NOTE(sbalse): Split off the upper half of the range as a job that other threads can steal, until what's
+// left is small enough to run here.
+static void RunParallelForRange(ParallelFor* const parallelFor, const int begin, int end, const int threadIndex)
+{
+    while (end - begin > parallelFor->m_Grain)
+    {
+        const int middle = begin + ((end - begin) / 2);
+
+        Job* const job = AllocateJob();
+        job->m_ParallelFor = parallelFor;
+        job->m_Begin = middle;
+        job->m_End = end;
+        job->m_Counter = &parallelFor->m_Counter;
+        parallelFor->m_Counter.m_NumPending.fetch_add(1);
+        QueueJob(job);
+
+        end = middle;
+    }
+
+    for (int i = begin; i < end; i++)
+    {
+        parallelFor->m_Func(parallelFor->m_UserData, i, threadIndex);
+    }
+}
+
+static void ExecuteJob(Job* const job, const int threadIndex)
+{
+    PROFILE_EVENT();
+
+    JobCounter* const counter = job->m_Counter;
+    if (job->m_ParallelFor)
+    {
+        RunParallelForRange(job->m_ParallelFor, job->m_Begin, job->m_End, threadIndex);
+    }
+    else
+    {
+        job->m_Func(job->m_UserData, threadIndex);
+    }
+
+    // NOTE(sbalse): Nothing reads the job after this, so its slot can be allocated again.
+    job->m_IsInUse->store(false, std::memory_order_release);
+
+    if (counter)
+    {
+        FinishCounterJob(counter);
+    }
+}
+
+static void WorkerThreadMain(const int threadIndex)
+{
+    g_ThreadIndex = threadIndex;
+
+    char threadName[32] = {};
+    std::snprintf(threadName, sizeof(threadName), "Worker %d", threadIndex);
+    PROFILE_THREAD_NAME(threadName);
+
+    while (true)
+    {
+        // NOTE(sbalse): Threads past the current thread count don't run jobs.
+        if (threadIndex < g_ThreadCount.load(std::memory_order_relaxed))
+        {
+            Job* const job = FindJob(threadIndex);
+            if (job)
+            {
+                ExecuteJob(job, threadIndex);
+                continue;
+            }
+        }
+
+        std::unique_lock lock(g_Mutex);
+        g_NumSleepingWorkers.fetch_add(1);
+        g_WakeCondition.wait(lock, [threadIndex]()
+        {
+            return g_ShuttingDown
+                || (threadIndex < g_ThreadCount.load(std::memory_order_relaxed) && g_NumQueuedJobs.load() > 0);
+        });
+        g_NumSleepingWorkers.fetch_sub(1);
+
+        if (g_ShuttingDown)
+        {
+            return;
+        }
+    }
+}
+
+void InitThreadPool(Arena* const persistentArena, const int numThreads, const size_t threadFrameArenaSize)
+{
+    int threadCount = numThreads;
+    if (threadCount <= 0)
+    {
+        threadCount = scast<int>(std::thread::hardware_concurrency());
+    }
+    threadCount = std::clamp(threadCount, 1, MAX_NUM_THREADS);
+
+    g_MaxThreadCount = threadCount;
+    g_ThreadCount = threadCount;
+    g_ShuttingDown = false;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        ThreadState& state = g_ThreadStates[i];
+        state.m_Jobs = PushArray(persistentArena, Job, MAX_JOBS_PER_THREAD);
+        state.m_IsJobInUse = PushArray(persistentArena, std::atomic<bool>, MAX_JOBS_PER_THREAD);
+        state.m_NextJob = 0;
+        state.m_Queue.m_Top = 0;
+        state.m_Queue.m_Bottom = 0;
+        ArenaInit(&state.m_FrameArena, PushArray(persistentArena, u8, threadFrameArenaSize), threadFrameArenaSize);
+    }
+
+    // NOTE(sbalse): Thread index 0 is the main thread so only create the remaining ones.
+    PROFILE_THREAD_NAME("Main");
+    g_ThreadIndex = 0;
+    for (int i = 1; i < threadCount; i++)
+    {
+        g_Workers[i] = std::thread(WorkerThreadMain, i);
+    }
+
+    LOG_INFO("Initialized thread pool with %d threads.", threadCount);
+}
+
+void DestroyThreadPool()
+{
+    {
+        std::unique_lock lock(g_Mutex);
+        g_ShuttingDown = true;
+    }
+    g_WakeCondition.notify_all();
+
+    for (int i = 1; i < g_MaxThreadCount; i++)
+    {
+        g_Workers[i].join();
+    }
+
+    g_MaxThreadCount = 1;
+    g_ThreadCount = 1;
+}
+
+int GetThreadPoolMaxThreadCount()
+{
+    return g_MaxThreadCount;
+}
+
+int GetThreadPoolThreadCount()
+{
+    return g_ThreadCount.load(std::memory_order_relaxed);
+}
+
+void SetThreadPoolThreadCount(const int numThreads)
+{
+    g_ThreadCount.store(std::clamp(numThreads, 1, g_MaxThreadCount), std::memory_order_relaxed);
+
+    // NOTE(sbalse): Let workers that were past the old thread count see the new one.
+    {
+        std::lock_guard lock(g_Mutex);
+    }
+    g_WakeCondition.notify_all();
+}
+
+void ThreadPoolParallelFor(const int count, const ParallelForFunc func, void* const userData)
+{
+    PROFILE_EVENT();
+
+    if (count <= 0)
+    {
+        return;
+    }
+
+    const int numThreads = std::min(GetThreadPoolThreadCount(), count);
+
+    // NOTE(sbalse): Not worth waking up the workers, just run everything on this thread.
+    if (numThreads == 1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            func(userData, i, g_ThreadIndex);
+        }
+        return;
+    }
+
+    ParallelFor parallelFor = {};
+    parallelFor.m_Func = func;
+    parallelFor.m_UserData = userData;
+    parallelFor.m_Grain = std::max(1, count / (numThreads * PARALLEL_FOR_RANGES_PER_THREAD));
+
+    // NOTE(sbalse): The calling thread starts on the whole range and helps out with the stolen ranges until
+    // they're all done.
+    RunParallelForRange(&parallelFor, 0, count, g_ThreadIndex);
+    ThreadPoolWaitForCounter(&parallelFor.m_Counter);
+}
+
+void ThreadPoolRunJob(
+    const JobFunc func,
+    void* const userData,
+    JobCounter* const counter,
+    JobCounter* const dependency
+)
+{
+    Job* const job = AllocateJob();
+    job->m_Func = func;
+    job->m_UserData = userData;
+    job->m_Counter = counter;
+
+    if (counter)
+    {
+        counter->m_NumPending.fetch_add(1);
+    }
+
+    if (dependency)
+    {
+        std::lock_guard lock(dependency->m_Mutex);
+        if (dependency->m_NumPending.load() > 0)
+        {
+            job->m_NextContinuation = dependency->m_Continuations;
+            dependency->m_Continuations = job;
+            return;
+        }
+    }
+
+    QueueJob(job);
+}
+
+void ThreadPoolWaitForCounter(JobCounter* const counter)
+{
+    PROFILE_EVENT();
+
+    while (counter->m_NumPending.load() > 0)
+    {
+        Job* const job = FindJob(g_ThreadIndex);
+        if (job)
+        {
+            ExecuteJob(job, g_ThreadIndex);
+            continue;
+        }
+
+        // NOTE(sbalse): Sleep like the workers do until either the counter is done or there are jobs to help with.
+        std::unique_lock lock(g_Mutex);
+        g_NumSleepingWorkers.fetch_add(1);
+        g_WakeCondition.wait(lock, [counter]()
+        {
+            return counter->m_NumPending.load() == 0 || g_NumQueuedJobs.load() > 0;
+        });
+        g_NumSleepingWorkers.fetch_sub(1);
+    }
+
+    // NOTE(sbalse): The thread that finished the last job might still hold the lock. Wait for it to let go so
+    // the caller can destroy the counter as soon as this returns.
+    std::lock_guard lock(counter->m_Mutex);
+}
+
+Arena* GetThreadFrameArena()
+{
+    return &g_ThreadStates[g_ThreadIndex].m_FrameArena;
+}
+
+void ResetThreadFrameArenas()
+{
+    for (int i = 0; i < g_MaxThreadCount; i++)
+    {
+        ArenaFree(&g_ThreadStates[i].m_FrameArena);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+
+#include "common.h"
+#include "arena.h"
+
+inline constexpr int MAX_NUM_THREADS = 64;
+
+// NOTE(sbalse): Function called once for every index of a ThreadPoolParallelFor(). threadIndex is 0
+// for the main thread and 1 to (thread count - 1) for the worker threads.
+using ParallelForFunc = void (*)(void* userData, const int index, const int threadIndex);
+
+// NOTE(sbalse): Function of a single job run with ThreadPoolRunJob().
+using JobFunc = void (*)(void* userData, const int threadIndex);
+
+struct Job;
+
+// NOTE(sbalse): Counts the jobs of a group that haven't finished yet. Jobs can be held back until a counter
+// reaches 0, which is how one group of jobs depends on another. Has to outlive the jobs that use it.
+struct JobCounter
+{
+    std::atomic<int> m_NumPending;
+
+    std::mutex m_Mutex; // NOTE(sbalse): Protects m_Continuations.
+    Job* m_Continuations; // NOTE(sbalse): Jobs waiting for this counter to reach 0.
+};
+
+// NOTE(sbalse): Create the worker threads. numThreads includes the main thread, so passing 1 means
+// everything runs on the main thread. Passing 0 uses the number of hardware threads. Every thread also gets
+// a frame arena of threadFrameArenaSize bytes from the persistent arena, see GetThreadFrameArena().
+void InitThreadPool(Arena* const persistentArena, const int numThreads, const size_t threadFrameArenaSize);
+void DestroyThreadPool();
+
+// NOTE(sbalse): Max number of threads (including the main thread) that the pool was created with.
+int GetThreadPoolMaxThreadCount();
+// NOTE(sbalse): Number of threads (including the main thread) that run jobs. Can be changed at runtime
+// between 1 and GetThreadPoolMaxThreadCount().
+int GetThreadPoolThreadCount();
+void SetThreadPoolThreadCount(const int numThreads);
+
+// NOTE(sbalse): Call func for every index in [0, count) spread over the pool threads. The range is split in
+// halves that idle threads steal from each other. The calling thread also takes part and the call only
+// returns once all indices have been processed.
+void ThreadPoolParallelFor(const int count, const ParallelForFunc func, void* const userData);
+
+// NOTE(sbalse): Queue func to run on any of the pool threads. The job is added to counter, when given, and
+// removed from it once it has run. It doesn't start before dependency, when given, has reached 0.
+void ThreadPoolRunJob(
+    const JobFunc func,
+    void* const userData,
+    JobCounter* const counter,
+    JobCounter* const dependency = nullptr
+);
+// NOTE(sbalse): Run queued jobs on the calling thread until all the jobs of the counter have finished.
+void ThreadPoolWaitForCounter(JobCounter* const counter);
+
+// NOTE(sbalse): The frame arena of the calling thread. Jobs can allocate from it without any locking, the
+// memory stays valid until the next ResetThreadFrameArenas().
+Arena* GetThreadFrameArena();
+// NOTE(sbalse): Free the frame arenas of all the threads. Only call it from the main thread while no jobs
+// are running, e.g. at the start of a frame.
+void ResetThreadFrameArenas();
@@ -1,459 +1,695 @@
 #include "triangle.h"
 
+#include <cassert>
+#include <algorithm>
 #include <cmath>
 
 #include "display.h"
+#include "pixelkernels.h"
+#include "stats.h"
 
-#define SWAP(Type, v1, v2) \
-do \
-{ \
-    Type temp = v2; \
-    v2 = v1; \
-    v1 = temp; \
-} while (0)
+// NOTE(sbalse): Vertex positions are snapped to a fixed point grid with this many bits of sub-pixel
+// precision before rasterizing. Doing the edge functions with integers makes the inside test exact,
+// so pixels on an edge shared by two triangles are always drawn exactly once.
+inline constexpr int SUBPIXEL_BITS = 4;
+inline constexpr i64 SUBPIXEL_ONE = i64(1) << SUBPIXEL_BITS;
+inline constexpr i64 SUBPIXEL_HALF = SUBPIXEL_ONE / 2;
+
+// NOTE(sbalse): Triangles with vertices further away from the origin than this (in pixels) are not
+// drawn. Keeps all the products of the edge function setup well inside 64 bits.
+inline constexpr float MAX_RASTER_COORDINATE = 16777216.0f;
 
 /*
-NOTE(sbalse): Return the barycentric weights alpha, beta and gamma for point P inside triangle ABC.
-
-         B
-        /|\
-       / |\
-      /  | \
-     /  (p) \
-    / /    \ \
-   A----------C
+NOTE(sbalse): A triangle set up for rasterizing with edge functions.
+
+For an edge going from vertex P to vertex Q, the edge function for a pixel center S is the 2D cross
+product (Q - P) x (S - P). It is 0 on the edge, and has the same sign for all the points on one side
+of the edge. The edge functions are linear in x and y, so moving one pixel to the right or one row down
+just adds a constant step to them.
+
+         V0
+        /  \
+  E1   /    \   E2        E0 = edge V1 -> V2
+      /  S   \            E1 = edge V2 -> V0
+    V2--------V1          E2 = edge V0 -> V1
+         E0
+
+The edge function of the edge opposite to a vertex divided by the area of the whole triangle is also the
+barycentric weight of that vertex.
 */
-static Vec3 BarycentricWeights(const Vec2 a, const Vec2 b, const Vec2 c, const Vec2 p)
+struct TriangleEdges
 {
-    // NOTE(sbalse): Find the vectors between the vertices ABC and point P.
-    const Vec2 ac = Vec2Sub(c, a);
-    const Vec2 ab = Vec2Sub(b, a);
-    const Vec2 ap = Vec2Sub(p, a);
-    const Vec2 pc = Vec2Sub(c, p);
-    const Vec2 pb = Vec2Sub(b, p);
-
-    // NOTE(sbalse): Compute the area of the full parallelogram formed by vectors AC and AB using 2D
-    // cross product.
-    const float areaParallelogramABC = (ac.m_X * ab.m_Y - ac.m_Y * ab.m_X); // || AC x AB ||
+    // NOTE(sbalse): Inclusive pixel bounds of the triangle after clipping them to the clip rect.
+    int m_MinX;
+    int m_MinY;
+    int m_MaxX;
+    int m_MaxY;
+
+    i64 m_RowStart[3]; // NOTE(sbalse): Edge function values at the center of pixel (m_MinX, m_MinY).
+    i64 m_StepX[3]; // NOTE(sbalse): Change of the edge function values when moving one pixel right.
+    i64 m_StepY[3]; // NOTE(sbalse): Change of the edge function values when moving one pixel down.
+
+    // NOTE(sbalse): A pixel is inside if all its edge function values are >= these. This is 0 for top
+    // and left edges and 1 for the others (the top-left fill rule).
+    i64 m_MinInside[3];
+
+    i64 m_Area; // NOTE(sbalse): Twice the area of the triangle in fixed point units.
+    float m_InvArea; // NOTE(sbalse): 1 / m_Area.
+};
+
+// NOTE(sbalse): Set up the edge functions of the triangle. Returns false if nothing needs to be drawn,
+// that is if the triangle has no area or doesn't touch any pixel inside the clip rect.
+static bool SetupTriangleEdges(const Vec4 points[3], const ScreenRect clipRect, TriangleEdges* const outEdges)
+{
+    // NOTE(sbalse): Written this way so that NaN positions are also rejected.
+    for (int i = 0; i < 3; i++)
+    {
+        if (!(std::abs(points[i].m_X) < MAX_RASTER_COORDINATE && std::abs(points[i].m_Y) < MAX_RASTER_COORDINATE))
+        {
+            return false;
+        }
+    }
 
-    // NOTE(sbalse): Alpha is the area of the small parallelogram PBC divided by the area of the full
-    // parallelogram ABC.
-    const float alpha = (pc.m_X * pb.m_Y - pc.m_Y * pb.m_X) / areaParallelogramABC;
+    // NOTE(sbalse): Snap the vertices to the sub-pixel grid.
+    i64 x[3] = {};
+    i64 y[3] = {};
+    for (int i = 0; i < 3; i++)
+    {
+        x[i] = std::llround(points[i].m_X * SUBPIXEL_ONE);
+        y[i] = std::llround(points[i].m_Y * SUBPIXEL_ONE);
+    }
 
-    // NOTE(sbalse): Beta is the area of the small parallelogram APC divided by the area of the full
-    // parallelogram ABC.
-    const float beta = (ac.m_X * ap.m_Y - ac.m_Y * ap.m_X) / areaParallelogramABC;
+    // NOTE(sbalse): Find the pixels whose centers are inside the bounding box of the triangle. A pixel
+    // center is at ((px * SUBPIXEL_ONE) + SUBPIXEL_HALF) in fixed point.
+    const i64 minX = std::min({ x[0], x[1], x[2] });
+    const i64 minY = std::min({ y[0], y[1], y[2] });
+    const i64 maxX = std::max({ x[0], x[1], x[2] });
+    const i64 maxY = std::max({ y[0], y[1], y[2] });
 
-    // NOTE(sbalse): Weight gamma is easily found since barycentric coordinates always add up to 1.
-    const float gamma = 1 - alpha - beta;
+    const i64 minPixelX = std::max<i64>((minX - SUBPIXEL_HALF + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, clipRect.m_MinX);
+    const i64 minPixelY = std::max<i64>((minY - SUBPIXEL_HALF + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS, clipRect.m_MinY);
+    const i64 maxPixelX = std::min<i64>((maxX - SUBPIXEL_HALF) >> SUBPIXEL_BITS, clipRect.m_MaxX - 1);
+    const i64 maxPixelY = std::min<i64>((maxY - SUBPIXEL_HALF) >> SUBPIXEL_BITS, clipRect.m_MaxY - 1);
 
-    const Vec3 result = { alpha, beta, gamma };
-    return result;
-}
+    if (minPixelX > maxPixelX || minPixelY > maxPixelY)
+    {
+        return false;
+    }
 
-// NOTE(sbalse): Draw a solid pixel at position (x, y) using depth interpolation.
-static void DrawTrianglePixel(
-    const int x, const int y,
-    const Vec4 pointA, const Vec4 pointB, const Vec4 pointC,
-    const u32 color)
-{
-    // NOTE(sbalse): Create three Vec2 to find the interpolation.
-    const Vec2 p = { scast<float>(x), scast<float>(y) };
-    const Vec2 a = Vec2FromVec4(pointA);
-    const Vec2 b = Vec2FromVec4(pointB);
-    const Vec2 c = Vec2FromVec4(pointC);
-
-    const Vec3 weights = BarycentricWeights(a, b, c, p);
-
-    const float alpha = weights.m_X;
-    const float beta = weights.m_Y;
-    const float gamma = weights.m_Z;
-
-    // NOTE(sbalse): Precompute the reciprocal values of W for points A, B and C along with their
-    // respective barycentric weights.
-    const float reciprocalWAlphaOfPointA = alpha / pointA.m_W;
-    const float reciprocalWBetaOfPointB = beta / pointB.m_W;
-    const float reciprocalWGammaPointC = gamma / pointC.m_W;
-
-    // NOTE(sbalse): Interpolate the value of 1/w.
-    float interpolatedReciprocalW =
-        (1.0f / pointA.m_W) * alpha
-        + (1.0f / pointB.m_W) * beta
-        + (1.0f / pointC.m_W) * gamma;
-
-    // NOTE(sbalse): Adjust 1/w so that pixels that are closer to the camera have smaller values.
-    interpolatedReciprocalW = 1.0f - interpolatedReciprocalW;
-
-    // NOTE(sbalse): Only draw the pixel if the depth value is less than the one previously stored
-    // in the z-buffer.
-    if (interpolatedReciprocalW < GetZBufferAt(x, y))
+    // NOTE(sbalse): Edge i goes from vertex (i + 1) to vertex (i + 2), which is the edge opposite to
+    // vertex i.
+    i64 a[3] = {};
+    i64 b[3] = {};
+    i64 c[3] = {};
+    for (int i = 0; i < 3; i++)
     {
-        DrawPixel(x, y, color);
+        const int p = (i + 1) % 3;
+        const int q = (i + 2) % 3;
+
+        // NOTE(sbalse): E(S) = (Q - P) x (S - P) = a * S.x + b * S.y + c.
+        a[i] = -(y[q] - y[p]);
+        b[i] = x[q] - x[p];
+        c[i] = -(a[i] * x[p]) - (b[i] * y[p]);
+    }
 
-        UpdateNormalizedZBufferAt(x, y, interpolatedReciprocalW);
+    // NOTE(sbalse): Twice the signed area of the triangle is the edge function of any edge evaluated
+    // at the opposite vertex.
+    i64 area = (a[0] * x[0]) + (b[0] * y[0]) + c[0];
+    if (area == 0)
+    {
+        return false;
+    }
 
-        if (GetRenderBufferMethod() == RenderBufferMethod::ZBuffer)
+    // NOTE(sbalse): Flip the edge functions of triangles with the other winding so that inside is
+    // always positive.
+    if (area < 0)
+    {
+        for (int i = 0; i < 3; i++)
         {
-            const u8 grayscale = scast<u8>(interpolatedReciprocalW * 255.0f);
-            const u32 zcolor = (grayscale << 16) | (grayscale << 8) | grayscale;
-            UpdateDisplayableZBufferAt(x, y, zcolor);
+            a[i] = -a[i];
+            b[i] = -b[i];
+            c[i] = -c[i];
         }
+        area = -area;
+    }
+
+    const i64 startX = (minPixelX * SUBPIXEL_ONE) + SUBPIXEL_HALF;
+    const i64 startY = (minPixelY * SUBPIXEL_ONE) + SUBPIXEL_HALF;
+
+    for (int i = 0; i < 3; i++)
+    {
+        outEdges->m_RowStart[i] = (a[i] * startX) + (b[i] * startY) + c[i];
+        outEdges->m_StepX[i] = a[i] * SUBPIXEL_ONE;
+        outEdges->m_StepY[i] = b[i] * SUBPIXEL_ONE;
+
+        // NOTE(sbalse): With y pointing down and inside being positive, an edge is a left edge when
+        // its normal points right (a > 0) and a top edge when it is horizontal with its normal
+        // pointing down (a == 0 and b > 0). Pixels exactly on those edges belong to this triangle.
+        const bool isTopLeftEdge = (a[i] > 0) || (a[i] == 0 && b[i] > 0);
+        outEdges->m_MinInside[i] = isTopLeftEdge ? 0 : 1;
     }
+
+    outEdges->m_MinX = scast<int>(minPixelX);
+    outEdges->m_MinY = scast<int>(minPixelY);
+    outEdges->m_MaxX = scast<int>(maxPixelX);
+    outEdges->m_MaxY = scast<int>(maxPixelY);
+    outEdges->m_Area = area;
+    outEdges->m_InvArea = 1.0f / scast<float>(area);
+
+    return true;
 }
 
-// NOTE(sbalse): Draw the the textured pixel at position X and Y using interpolation.
-// x, y - Pixels coordinates where the texture is to be drawn.
-// pointA, pointB, pointC - vertices of the triangle.
-// u0, v0, u1, v1, u2, v2 - The UV coordinate of the texture to draw on the triangle.
-// The function will figure out which texel to draw from the given parameters.
-static void DrawTriangleTexel(
-    const int x,
-    const int y,
-    const Vec4 pointA,
-    const Vec4 pointB,
-    const Vec4 pointC,
-    const Tex2 aUV,
-    const Tex2 bUV,
-    const Tex2 cUV,
-    const upng_t* const texture
-)
+// NOTE(sbalse): a / b rounded down, for b > 0.
+static i64 FloorDiv(const i64 a, const i64 b)
 {
-    const Vec2 p = { scast<float>(x), scast<float>(y) };
-    const Vec2 a = Vec2FromVec4(pointA);
-    const Vec2 b = Vec2FromVec4(pointB);
-    const Vec2 c = Vec2FromVec4(pointC);
-
-    const Vec3 weights = BarycentricWeights(a, b, c, p);
-
-    const float alpha = weights.m_X;
-    const float beta = weights.m_Y;
-    const float gamma = weights.m_Z;
-
-    // NOTE(sbalse): Calculating barycentric coordinates gives us the interpolated U/w and V/w values.
-    // The 1/w factor is what performs perspective correction on our texture. Perspective correction
-    // is necessary otherwise the texture will appear distorted.
-
-    // NOTE(sbalse): The formula for interpolated U/w is:
-    // (Ua/Wa * alpha) + (Ub/Wb * beta) + (Uc/Wc * gamma).
-    // Same for interpolated V.
-
-    // NOTE(sbalse): Precompute the reciprocal values of W for points A, B and C along with their
-    // respective barycentric weights.
-    const float reciprocalWAlphaOfPointA = alpha / pointA.m_W;
-    const float reciprocalWBetaOfPointB = beta / pointB.m_W;
-    const float reciprocalWGammaPointC = gamma / pointC.m_W;
-
-    // NOTE(sbalse): Interpolate the reciprocal of W.
-    float interpolatedReciprocalW =
-        reciprocalWAlphaOfPointA
-        + reciprocalWBetaOfPointB
-        + reciprocalWGammaPointC;
-
-    // NOTE(sbalse): Interpolate U and V using the precomputed reciprocals of W.
-    float interpolatedU =
-        (aUV.m_U * reciprocalWAlphaOfPointA)
-        + (bUV.m_U * reciprocalWBetaOfPointB)
-        + (cUV.m_U * reciprocalWGammaPointC);
-    float interpolatedV =
-        (aUV.m_V * reciprocalWAlphaOfPointA)
-        + (bUV.m_V * reciprocalWBetaOfPointB)
-        + (cUV.m_V * reciprocalWGammaPointC);
-
-    // NOTE(sbalse): Convert the interpolated U and V back into screen space by dividing them by
-    // the interpolated W.
-    interpolatedU /= interpolatedReciprocalW;
-    interpolatedV /= interpolatedReciprocalW;
-
-    // Get the mesh texture width and height.
-    const u32 textureWidth = upng_get_width(texture);
-    const u32 textureHeight = upng_get_height(texture);
-
-    // NOTE(sbalse): The interpolated value will be between 0 and 1 so we need to multiply it by the
-    // texture width and height to map the UV coordinates to the full texture width and height.
-    const int texelX = std::abs(scast<int>(interpolatedU * textureWidth)) % textureWidth;
-    const int texelY = std::abs(scast<int>(interpolatedV * textureHeight)) % textureHeight;
-
-    // NOTE(sbalse): Adjust 1/w so that pixels closer to the camera have smaller values of
-    // interpolated reciprocal W.
-    interpolatedReciprocalW = 1.0f - interpolatedReciprocalW;
-
-    // NOTE(sbalse): Only draw the pixel if the depth value is less than the one previously stored
-    // in the z-buffer.
-    if (interpolatedReciprocalW < GetZBufferAt(x, y))
-    {
-        // Get the buffer of colors from the texture.
-        const u32* textureColors = rcast<const u32*>(upng_get_buffer(texture));
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
 
-        // NOTE(sbalse): Draw the corresponding color from our texture.
-        const u32 color = textureColors[(textureWidth * texelY) + texelX];
-        DrawPixel(x, y, color);
+// NOTE(sbalse): a / b rounded up, for b > 0.
+static i64 CeilDiv(const i64 a, const i64 b)
+{
+    return -FloorDiv(-a, b);
+}
+
+// NOTE(sbalse): Find the run of pixels of a row that are inside all three edges. The edge functions are
+// linear so the pixels inside each edge are a single run, and so are the pixels inside all of them.
+// rowEdges are the edge function values at pixel m_MinX of the row. outStart is relative to m_MinX.
+static bool GetRowSpan(
+    const TriangleEdges& edges,
+    const i64 rowEdges[3],
+    int* const outStart,
+    int* const outCount)
+{
+    i64 start = 0;
+    i64 end = edges.m_MaxX - edges.m_MinX;
 
-        // NOTE(sbalse): Update the z-buffer value with the 1/w of this current pixel.
-        UpdateNormalizedZBufferAt(x, y, interpolatedReciprocalW);
+    for (int i = 0; i < 3; i++)
+    {
+        // NOTE(sbalse): Pixel x (relative to m_MinX) is inside when rowEdges + (x * step) >= m_MinInside,
+        // that is x * step >= missing.
+        const i64 step = edges.m_StepX[i];
+        const i64 missing = edges.m_MinInside[i] - rowEdges[i];
 
-        if (GetRenderBufferMethod() == RenderBufferMethod::ZBuffer)
+        if (step > 0)
+        {
+            start = std::max(start, CeilDiv(missing, step));
+        }
+        else if (step < 0)
         {
-            const u8 grayscale = scast<u8>(interpolatedReciprocalW * 255.0f);
-            const u32 zcolor = (grayscale << 16) | (grayscale << 8) | grayscale;
-            UpdateDisplayableZBufferAt(x, y, zcolor);
+            end = std::min(end, FloorDiv(-missing, -step));
         }
+        else if (missing > 0)
+        {
+            return false;
+        }
+    }
+
+    if (start > end)
+    {
+        return false;
     }
+
+    *outStart = scast<int>(start);
+    *outCount = scast<int>(end - start + 1);
+    return true;
 }
 
-void DrawTriangle(
-    const int x0,
-    const int y0,
-    const int x1,
-    const int y1,
-    const int x2,
-    const int y2,
-    const u32 color
-)
+// NOTE(sbalse): Fill in the parts of the span triangle that are the same for filled and textured
+// triangles.
+static void SetupSpanTriangle(
+    const TriangleEdges& edges,
+    const Vec4 points[3],
+    SpanTriangle* const outSpanTriangle)
 {
-    DrawLine(x0, y0, x1, y1, color);
-    DrawLine(x1, y1, x2, y2, color);
-    DrawLine(x2, y2, x0, y0, color);
+    for (int i = 0; i < 3; i++)
+    {
+        outSpanTriangle->m_EdgeStepX[i] = edges.m_StepX[i];
+    }
+    outSpanTriangle->m_InvArea = edges.m_InvArea;
+    outSpanTriangle->m_ReciprocalW = { 1.0f / points[0].m_W, 1.0f / points[1].m_W, 1.0f / points[2].m_W };
+    outSpanTriangle->m_DepthTestMethod = GetDepthTestMethod();
 }
 
-/*
-NOTE(sbalse): Draw a filled triangle with the flat-top/flat-bottom method.
-          (x0, y0)
-           / \
-          /   \
-         /     \
-        /       \
-       /         \
-(x1, y1)--------(Mx, My)
-       \          \
-         \        \
-           \       \
-             \      \
-               \     \
-                 \    \
-                   \  \
-                     \ \
-                       \
-                      (x2, y2)
-*/
-void DrawFilledTriangle(
-    int x0, int y0, float z0, float w0,
-    int x1, int y1, float z1, float w1,
-    int x2, int y2, float z2, float w2,
-    const u32 color
-)
+// NOTE(sbalse): Kernels used to draw the triangle. Falls back to the scalar kernels for triangles too big
+// for the vector ones.
+static PixelKernels GetTriangleKernels(const TriangleEdges& edges)
 {
-    // NOTE(sbalse): Sort vertices by y-coordinate ascending (y0 < y1 < y2);
-    if (y0 > y1)
+    PixelKernelMethod method = GetPixelKernelMethod();
+    if (edges.m_Area > MAX_VECTOR_KERNEL_TRIANGLE_AREA)
     {
-        SWAP(int, x0, x1);
-        SWAP(int, y0, y1);
-        SWAP(float, z0, z1);
-        SWAP(float, w0, w1);
+        method = PixelKernelMethod::Scalar;
     }
-    if (y1 > y2)
+
+    return GetPixelKernels(method);
+}
+
+// NOTE(sbalse): 1/w of the triangle as a plane over the screen, used to find the nearest depth the
+// triangle can have inside a hierarchical Z tile. 1/w is interpolated linearly in screen space so
+// 1/w(x, y) = m_Base + (m_StepX * (x - m_MinX)) + (m_StepY * (y - m_MinY)).
+struct ReciprocalWPlane
+{
+    double m_Base;
+    double m_StepX;
+    double m_StepY;
+    double m_MaxVertexValue; // NOTE(sbalse): No point inside the triangle is larger than this.
+};
+
+// NOTE(sbalse): The pixel kernels compute 1/w with float math so they can end up slightly above the exact
+// plane. The bound is pushed up by this much (relative) to stay conservative.
+inline constexpr double HIZ_RECIPROCAL_W_TOLERANCE = 1e-5;
+
+static ReciprocalWPlane SetupReciprocalWPlane(const TriangleEdges& edges, const SpanTriangle& spanTriangle)
+{
+    const double reciprocalW[3] =
     {
-        SWAP(int, x1, x2);
-        SWAP(int, y1, y2);
-        SWAP(float, z1, z2);
-        SWAP(float, w1, w2);
-    }
-    if (y0 > y1)
+        spanTriangle.m_ReciprocalW.m_X,
+        spanTriangle.m_ReciprocalW.m_Y,
+        spanTriangle.m_ReciprocalW.m_Z,
+    };
+
+    ReciprocalWPlane result = {};
+    for (int i = 0; i < 3; i++)
     {
-        SWAP(int, x0, x1);
-        SWAP(int, y0, y1);
-        SWAP(float, z0, z1);
-        SWAP(float, w0, w1);
+        // NOTE(sbalse): The barycentric weight of vertex i is its edge function divided by the area.
+        result.m_Base += reciprocalW[i] * scast<double>(edges.m_RowStart[i]);
+        result.m_StepX += reciprocalW[i] * scast<double>(edges.m_StepX[i]);
+        result.m_StepY += reciprocalW[i] * scast<double>(edges.m_StepY[i]);
     }
 
-    // NOTE(sbalse): Create three vector points after we sort the vertices.
-    const Vec4 pointA = { scast<float>(x0), scast<float>(y0), z0, w0 };
-    const Vec4 pointB = { scast<float>(x1), scast<float>(y1), z1, w1 };
-    const Vec4 pointC = { scast<float>(x2), scast<float>(y2), z2, w2 };
+    const double invArea = 1.0 / scast<double>(edges.m_Area);
+    result.m_Base *= invArea;
+    result.m_StepX *= invArea;
+    result.m_StepY *= invArea;
+    result.m_MaxVertexValue = std::max({ reciprocalW[0], reciprocalW[1], reciprocalW[2] });
 
-    // NOTE(sbalse): Use inverse slopes since we want to know how much our x changes with y (instead
-    // of the other way around).
-    float invSlope1 = (y1 - y0 != 0) ? (scast<float>(x1 - x0) / std::abs(y1 - y0)) : 0.0f;
-    float invSlope2 = (y2 - y0 != 0) ? (scast<float>(x2 - x0) / std::abs(y2 - y0)) : 0.0f;
+    return result;
+}
+
+// NOTE(sbalse): Whether the part of the triangle inside the pixel rectangle (inclusive) can pass the depth
+// test against the hierarchical Z tile.
+static bool IsTriangleVisibleInHiZTile(
+    const TriangleEdges& edges,
+    const ReciprocalWPlane& plane,
+    const int minX,
+    const int minY,
+    const int maxX,
+    const int maxY,
+    const int tileX,
+    const int tileY)
+{
+    // NOTE(sbalse): The largest 1/w (nearest depth) of a plane over a rectangle is at one of its corners.
+    const double dx0 = scast<double>(minX - edges.m_MinX);
+    const double dx1 = scast<double>(maxX - edges.m_MinX);
+    const double dy0 = scast<double>(minY - edges.m_MinY);
+    const double dy1 = scast<double>(maxY - edges.m_MinY);
+    const double planeMax = plane.m_Base
+        + std::max(plane.m_StepX * dx0, plane.m_StepX * dx1)
+        + std::max(plane.m_StepY * dy0, plane.m_StepY * dy1);
+
+    double maxReciprocalW = std::min(planeMax, plane.m_MaxVertexValue);
+    maxReciprocalW += std::abs(maxReciprocalW) * HIZ_RECIPROCAL_W_TOLERANCE;
+
+    // NOTE(sbalse): Pixels are only drawn when their depth is less than the one in the Z buffer.
+    const double nearestDepth = 1.0 - maxReciprocalW;
+    return nearestDepth < GetHiZTileMaxDepth(tileX, tileY);
+}
 
-    if (y1 - y0 != 0)
+// NOTE(sbalse): Pixels of a triangle that went through the depth test and the ones that passed it.
+struct SpanPixelCounts
+{
+    u64 m_NumTested;
+    u64 m_NumShaded;
+};
+
+// NOTE(sbalse): Draw the inside pixels of rows minY to maxY with drawSpan, but only the ones between
+// minX and maxX (inclusive).
+static void DrawTriangleRowSpans(
+    const TriangleEdges& edges,
+    const SpanTriangle& spanTriangle,
+    const DrawSpanFunc drawSpan,
+    const int minX,
+    const int minY,
+    const int maxX,
+    const int maxY,
+    SpanPixelCounts* const counts)
+{
+    const i64 rowsToSkip = minY - edges.m_MinY;
+    i64 rowEdges[3] = {};
+    for (int i = 0; i < 3; i++)
+    {
+        rowEdges[i] = edges.m_RowStart[i] + (edges.m_StepY[i] * rowsToSkip);
+    }
+
+    for (int y = minY; y <= maxY; y++)
     {
-        for (int y = y0; y <= y1; y++)
+        int start = 0;
+        int count = 0;
+        if (GetRowSpan(edges, rowEdges, &start, &count))
         {
-            /* NOTE(sbalse) : Explaination of this formula :
-            (y - y1) is the entire range from start to end of y. Then we multiply by the slope to
-            get the correct scaling factor to get where we want to be in the range. The first "x1 +"
-            is just to offset the range of values by the start value of x0. */
-            int xStart = scast<int>(x1 + (y - y1) * invSlope1);
-            int xEnd = scast<int>(x0 + (y - y0) * invSlope2);
-
-            if (xEnd < xStart)
-            {
-                // NOTE(sbalse): Swap if xStart is to the right of xEnd.
-                SWAP(int, xStart, xEnd);
-            }
+            // NOTE(sbalse): Cut the span down to [minX, maxX].
+            const int spanStart = std::max(start, minX - edges.m_MinX);
+            const int spanEnd = std::min(start + count - 1, maxX - edges.m_MinX);
 
-            for (int x = xStart; x < xEnd; x++)
+            if (spanStart <= spanEnd)
             {
-                // TODO(sbalse): Draw our pixel with the color that comes from the texture.
-                DrawTrianglePixel(x, y, pointA, pointB, pointC, color);
+                // NOTE(sbalse): The edges are clipped to the clip rect, which is inside the window, so the
+                // span can be written without any per pixel checks.
+                const int x = edges.m_MinX + spanStart;
+                const int spanCount = spanEnd - spanStart + 1;
+
+                Span span = {};
+                span.m_Colors = GetColorBufferSpan(x, y, spanCount);
+                span.m_Depths = GetZBufferSpan(x, y, spanCount);
+                span.m_Count = spanCount;
+                for (int i = 0; i < 3; i++)
+                {
+                    span.m_Edges[i] = rowEdges[i] + (edges.m_StepX[i] * spanStart);
+                }
+
+                counts->m_NumTested += scast<u64>(span.m_Count);
+                counts->m_NumShaded += scast<u64>(drawSpan(spanTriangle, span));
             }
         }
+
+        rowEdges[0] += edges.m_StepY[0];
+        rowEdges[1] += edges.m_StepY[1];
+        rowEdges[2] += edges.m_StepY[2];
     }
+}
 
-    /////////// NOTE(sbalse): Render the bottom part of the triangle (flat-top). /////////////////
+// NOTE(sbalse): Walk the triangle in bands of HIZ_TILE_SIZE rows. Each tile of a band is tested against the
+// hierarchical Z first, and only the runs of visible tiles are drawn. Tiles where the triangle is
+// completely hidden don't cost any per pixel work.
+static void DrawTriangleSpansHiZ(
+    const TriangleEdges& edges,
+    const SpanTriangle& spanTriangle,
+    const DrawSpanFunc drawSpan,
+    SpanPixelCounts* const counts)
+{
+    const ReciprocalWPlane plane = SetupReciprocalWPlane(edges, spanTriangle);
 
-    invSlope1 = (y2 - y1 != 0) ? (scast<float>(x2 - x1) / std::abs(y2 - y1)) : 0.0f;
-    invSlope2 = (y2 - y0 != 0) ? (scast<float>(x2 - x0) / std::abs(y2 - y0)) : 0.0f;
+    const int minTileX = edges.m_MinX / HIZ_TILE_SIZE;
+    const int maxTileX = edges.m_MaxX / HIZ_TILE_SIZE;
+    const int minTileY = edges.m_MinY / HIZ_TILE_SIZE;
+    const int maxTileY = edges.m_MaxY / HIZ_TILE_SIZE;
 
-    if (y2 - y1 != 0)
+    u64 numTilesTested = 0;
+    u64 numTilesRejected = 0;
+
+    for (int tileY = minTileY; tileY <= maxTileY; tileY++)
     {
-        for (int y = y1; y <= y2; y++)
-        {
-            int xStart = scast<int>(x1 + (y - y1) * invSlope1);
-            int xEnd = scast<int>(x2 + (y - y2) * invSlope2);
+        const int bandMinY = std::max(tileY * HIZ_TILE_SIZE, edges.m_MinY);
+        const int bandMaxY = std::min(((tileY + 1) * HIZ_TILE_SIZE) - 1, edges.m_MaxY);
 
-            if (xEnd < xStart)
+        // NOTE(sbalse): Find the runs of visible tiles in the band. Each run is drawn with one span per row
+        // so the vector kernels still get long spans.
+        int runStartTileX = -1;
+        for (int tileX = minTileX; tileX <= maxTileX + 1; tileX++)
+        {
+            bool isVisible = false;
+            if (tileX <= maxTileX)
             {
-                // NOTE(sbalse): Swap if xStart is to the right of xEnd.
-                SWAP(int, xStart, xEnd);
+                isVisible = IsTriangleVisibleInHiZTile(
+                    edges,
+                    plane,
+                    std::max(tileX * HIZ_TILE_SIZE, edges.m_MinX),
+                    bandMinY,
+                    std::min(((tileX + 1) * HIZ_TILE_SIZE) - 1, edges.m_MaxX),
+                    bandMaxY,
+                    tileX,
+                    tileY
+                );
+
+                numTilesTested++;
+                numTilesRejected += isVisible ? 0 : 1;
             }
 
-            for (int x = xStart; x < xEnd; x++)
+            if (isVisible && runStartTileX < 0)
+            {
+                runStartTileX = tileX;
+            }
+            else if (!isVisible && runStartTileX >= 0)
             {
-                DrawTrianglePixel(x, y, pointA, pointB, pointC, color);
+                DrawTriangleRowSpans(
+                    edges,
+                    spanTriangle,
+                    drawSpan,
+                    std::max(runStartTileX * HIZ_TILE_SIZE, edges.m_MinX),
+                    bandMinY,
+                    std::min((tileX * HIZ_TILE_SIZE) - 1, edges.m_MaxX),
+                    bandMaxY,
+                    counts
+                );
+
+                // NOTE(sbalse): The depths in the drawn tiles can only have gone down, so tighten their max.
+                for (int drawnTileX = runStartTileX; drawnTileX < tileX; drawnTileX++)
+                {
+                    UpdateHiZTile(drawnTileX, tileY);
+                }
+
+                runStartTileX = -1;
             }
         }
     }
+
+    AddThreadFrameCounter(FrameCounter_HiZTilesTested, numTilesTested);
+    AddThreadFrameCounter(FrameCounter_HiZTilesRejected, numTilesRejected);
+    if (numTilesRejected == numTilesTested)
+    {
+        AddThreadFrameCounter(FrameCounter_HiZTrianglesRejected, 1);
+    }
 }
 
-/*
-NOTE(sbalse): Draw a textured triangle with the flat-top/flat-bottom method.
-          (v0)
-           / \
-          /   \
-         /     \
-        /       \
-       /         \
-   (v1)-----------\
-       \          \
-         \        \
-           \       \
-             \      \
-               \     \
-                 \    \
-                   \  \
-                     \ \
-                       \
-                      (v2)
-*/
-void DrawTexturedTriangle(
-    int x0, int y0, float z0, float w0, float u0, float v0,
-    int x1, int y1, float z1, float w1, float u1, float v1,
-    int x2, int y2, float z2, float w2, float u2, float v2,
-    const upng_t* const texture
+// NOTE(sbalse): Walk the rows of the triangle and draw the inside pixels of each row with drawSpan.
+static SpanPixelCounts DrawTriangleSpans(
+    const TriangleEdges& edges,
+    const SpanTriangle& spanTriangle,
+    const DrawSpanFunc drawSpan)
+{
+    ClearStaleZBufferTiles(ScreenRect
+    {
+        .m_MinX = edges.m_MinX,
+        .m_MinY = edges.m_MinY,
+        .m_MaxX = edges.m_MaxX + 1,
+        .m_MaxY = edges.m_MaxY + 1,
+    });
+
+    SpanPixelCounts counts = {};
+    if (GetOcclusionCullMethod() == OcclusionCullMethod::HiZ)
+    {
+        DrawTriangleSpansHiZ(edges, spanTriangle, drawSpan, &counts);
+    }
+    else
+    {
+        DrawTriangleRowSpans(
+            edges,
+            spanTriangle,
+            drawSpan,
+            edges.m_MinX,
+            edges.m_MinY,
+            edges.m_MaxX,
+            edges.m_MaxY,
+            &counts
+        );
+    }
+
+    return counts;
+}
+
+void DrawTriangle(
+    const int x0,
+    const int y0,
+    const int x1,
+    const int y1,
+    const int x2,
+    const int y2,
+    const u32 color
 )
 {
-    // NOTE(sbalse): Loop all the pixels of the triangle to render them based on the color that
-    // comes from the texture.
+    DrawLine(x0, y0, x1, y1, color);
+    DrawLine(x1, y1, x2, y2, color);
+    DrawLine(x2, y2, x0, y0, color);
+}
 
-    // NOTE(sbalse): Sort vertices by y-coordinate ascending (y0 < y1 < y2);
-    if (y0 > y1)
+// NOTE(sbalse): Draw a filled triangle with edge functions. Every row of the triangle is drawn as a
+// single span by the current pixel kernels.
+void DrawFilledTriangle(
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC,
+    const u32 color
+)
+{
+    const Vec4 points[3] = { pointA, pointB, pointC };
+
+    TriangleEdges edges = {};
+    if (!SetupTriangleEdges(points, GetDrawClipRect(), &edges))
     {
-        SWAP(int, x0, x1);
-        SWAP(int, y0, y1);
-        SWAP(float, z0, z1);
-        SWAP(float, w0, w1);
-        SWAP(float, u0, u1);
-        SWAP(float, v0, v1);
+        return;
     }
-    if (y1 > y2)
+
+    SpanTriangle spanTriangle = {};
+    SetupSpanTriangle(edges, points, &spanTriangle);
+    spanTriangle.m_Color = color;
+
+    const PixelKernels kernels = GetTriangleKernels(edges);
+    const SpanPixelCounts counts = DrawTriangleSpans(edges, spanTriangle, kernels.m_DrawFilledSpan);
+
+    AddThreadFrameCounter(FrameCounter_PixelsDepthTested, counts.m_NumTested);
+    AddThreadFrameCounter(FrameCounter_PixelsShaded, counts.m_NumShaded);
+}
+
+// NOTE(sbalse): Fill in the range of mip levels the pixels of the triangle are sampled from, and the
+// derivatives the kernels pick the level of each pixel with.
+static void SetupSpanTriangleMipLevels(
+    const TriangleEdges& edges,
+    const Tex2 uvs[3],
+    const Texture* const texture,
+    SpanTriangle* const outSpanTriangle)
+{
+    const float textureWidth = scast<float>(texture->m_Mips[0].m_Width);
+    const float textureHeight = scast<float>(texture->m_Mips[0].m_Height);
+    const int maxLevel = texture->m_NumMips - 1;
+
+    switch (GetMipLevelMethod())
     {
-        SWAP(int, x1, x2);
-        SWAP(int, y1, y2);
-        SWAP(float, z1, z2);
-        SWAP(float, w1, w2);
-        SWAP(float, u1, u2);
-        SWAP(float, v1, v2);
-    }
-    if (y0 > y1)
+    case MipLevelMethod::None:
     {
-        SWAP(int, x0, x1);
-        SWAP(int, y0, y1);
-        SWAP(float, z0, z1);
-        SWAP(float, w0, w1);
-        SWAP(float, u0, u1);
-        SWAP(float, v0, v1);
+        outSpanTriangle->m_MinMipLevel = 0;
+        outSpanTriangle->m_MaxMipLevel = 0;
+    } break;
+
+    case MipLevelMethod::PerTriangle:
+    {
+        // NOTE(sbalse): Texels per pixel of the whole triangle, ignoring the perspective. Both areas are
+        // twice the real ones, which cancels out.
+        const float texelArea = std::abs(
+            ((uvs[1].m_U - uvs[0].m_U) * (uvs[2].m_V - uvs[0].m_V))
+            - ((uvs[2].m_U - uvs[0].m_U) * (uvs[1].m_V - uvs[0].m_V))
+        ) * textureWidth * textureHeight;
+        const float pixelArea = scast<float>(edges.m_Area) / scast<float>(SUBPIXEL_ONE * SUBPIXEL_ONE);
+
+        const int level = GetMipLevel(texelArea / pixelArea, 0, maxLevel);
+        outSpanTriangle->m_MinMipLevel = level;
+        outSpanTriangle->m_MaxMipLevel = level;
+    } break;
+
+    case MipLevelMethod::PerPixel:
+    {
+        outSpanTriangle->m_MinMipLevel = 0;
+        outSpanTriangle->m_MaxMipLevel = maxLevel;
+    } break;
     }
 
-    // NOTE(sbalse): Flip the V component to account for inverted UV-coordinates (V grows downwards).
-    v0 = 1.0f - v0;
-    v1 = 1.0f - v1;
-    v2 = 1.0f - v2;
-
-    // NOTE(sbalse): Create vectors for the 3 triangle vertices.
-    const Vec4 pointA = { scast<float>(x0), scast<float>(y0), z0, w0 };
-    const Vec4 pointB = { scast<float>(x1), scast<float>(y1), z1, w1 };
-    const Vec4 pointC = { scast<float>(x2), scast<float>(y2), z2, w2 };
-    const Tex2 aUV = { u0, v0 };
-    const Tex2 bUV = { u1, v1 };
-    const Tex2 cUV = { u2, v2 };
-
-    /////////// NOTE(sbalse): Render the upper part of the triangle (flat-bottom). ////////////////
-
-    // NOTE(sbalse): Use inverse slopes since we want to know how much our x changes with y (instead
-    // of the other way around).
-    float invSlope1 = (y1 - y0 != 0) ? (scast<float>(x1 - x0) / std::abs(y1 - y0)) : 0.0f;
-    float invSlope2 = (y2 - y0 != 0) ? (scast<float>(x2 - x0) / std::abs(y2 - y0)) : 0.0f;
-
-    if (y1 - y0 != 0)
+    // NOTE(sbalse): The barycentric weights change by the edge function step times 1/area per pixel, and
+    // U/w, V/w and 1/w are all the weighted sums of their vertex values.
+    const float reciprocalW[3] =
     {
-        for (int y = y0; y <= y1; y++)
-        {
-            /* NOTE(sbalse) : Explaination of this formula :
-            (y - y1) is the entire range from start to end of y. Then we multiply by the slope to
-            get the correct scaling factor to get where we want to be in the range. The first "x1 +"
-            is just to offset the range of values by the start value of x0. */
-            int xStart = scast<int>(x1 + (y - y1) * invSlope1);
-            int xEnd = scast<int>(x0 + (y - y0) * invSlope2);
-
-            if (xEnd < xStart)
-            {
-                // NOTE(sbalse): Swap if xStart is to the right of xEnd.
-                SWAP(int, xStart, xEnd);
-            }
+        outSpanTriangle->m_ReciprocalW.m_X,
+        outSpanTriangle->m_ReciprocalW.m_Y,
+        outSpanTriangle->m_ReciprocalW.m_Z,
+    };
+    for (int axis = 0; axis < 2; axis++)
+    {
+        const i64* const edgeSteps = (axis == 0) ? edges.m_StepX : edges.m_StepY;
 
-            for (int x = xStart; x < xEnd; x++)
-            {
-                // TODO(sbalse): Draw our pixel with the color that comes from the texture.
-                DrawTriangleTexel(x, y, pointA, pointB, pointC, aUV, bUV, cUV, texture);
-            }
+        float uOverWStep = 0.0f;
+        float vOverWStep = 0.0f;
+        float reciprocalWStep = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            const float weightStep = scast<float>(edgeSteps[i]) * edges.m_InvArea;
+            uOverWStep += outSpanTriangle->m_UVOverW[i].m_U * weightStep;
+            vOverWStep += outSpanTriangle->m_UVOverW[i].m_V * weightStep;
+            reciprocalWStep += reciprocalW[i] * weightStep;
         }
+
+        outSpanTriangle->m_TexelUOverWStep[axis] = uOverWStep * textureWidth;
+        outSpanTriangle->m_TexelVOverWStep[axis] = vOverWStep * textureHeight;
+        outSpanTriangle->m_ReciprocalWStepU[axis] = reciprocalWStep * textureWidth;
+        outSpanTriangle->m_ReciprocalWStepV[axis] = reciprocalWStep * textureHeight;
     }
+}
+
+// NOTE(sbalse): Draw a textured triangle with edge functions. Same as DrawFilledTriangle() but the color
+// of each pixel comes from the texture.
+void DrawTexturedTriangle(
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC,
+    const Tex2 aUV,
+    const Tex2 bUV,
+    const Tex2 cUV,
+    const Texture* const texture
+)
+{
+    assert(texture->m_NumMips > 0 && "ERROR: Drawing a textured triangle without a texture.");
 
-    /////////// NOTE(sbalse): Render the bottom part of the triangle (flat-top). /////////////////
+    const Vec4 points[3] = { pointA, pointB, pointC };
 
-    invSlope1 = (y2 - y1 != 0) ? (scast<float>(x2 - x1) / std::abs(y2 - y1)) : 0.0f;
-    invSlope2 = (y2 - y0 != 0) ? (scast<float>(x2 - x0) / std::abs(y2 - y0)) : 0.0f;
+    TriangleEdges edges = {};
+    if (!SetupTriangleEdges(points, GetDrawClipRect(), &edges))
+    {
+        return;
+    }
+
+    SpanTriangle spanTriangle = {};
+    SetupSpanTriangle(edges, points, &spanTriangle);
 
-    if (y2 - y1 != 0)
+    // NOTE(sbalse): Flip the V component to account for inverted UV-coordinates (V grows downwards).
+    // Also precompute U/w and V/w of each vertex since those are what we interpolate.
+    const Tex2 uvs[3] = { aUV, bUV, cUV };
+    const float reciprocalW[3] =
+    {
+        spanTriangle.m_ReciprocalW.m_X,
+        spanTriangle.m_ReciprocalW.m_Y,
+        spanTriangle.m_ReciprocalW.m_Z,
+    };
+    for (int i = 0; i < 3; i++)
     {
-        for (int y = y1; y <= y2; y++)
+        spanTriangle.m_UVOverW[i] =
         {
-            int xStart = scast<int>(x1 + (y - y1) * invSlope1);
-            int xEnd = scast<int>(x2 + (y - y2) * invSlope2);
+            uvs[i].m_U * reciprocalW[i],
+            (1.0f - uvs[i].m_V) * reciprocalW[i],
+        };
+    }
 
-            if (xEnd < xStart)
-            {
-                // NOTE(sbalse): Swap if xStart is to the right of xEnd.
-                SWAP(int, xStart, xEnd);
-            }
+    spanTriangle.m_Texture = texture;
+    SetupSpanTriangleMipLevels(edges, uvs, texture, &spanTriangle);
 
-            for (int x = xStart; x < xEnd; x++)
-            {
-                DrawTriangleTexel(x, y, pointA, pointB, pointC, aUV, bUV, cUV, texture);
-            }
-        }
+    const PixelKernels kernels = GetTriangleKernels(edges);
+    const DrawSpanFunc drawSpan = (GetTextureFilterMethod() == TextureFilterMethod::Bilinear)
+        ? kernels.m_DrawBilinearTexturedSpan
+        : kernels.m_DrawTexturedSpan;
+    const SpanPixelCounts counts = DrawTriangleSpans(edges, spanTriangle, drawSpan);
+
+    AddThreadFrameCounter(FrameCounter_PixelsDepthTested, counts.m_NumTested);
+    AddThreadFrameCounter(FrameCounter_PixelsShaded, counts.m_NumShaded);
+}
+
+// NOTE(sbalse): Draw only the depth of the triangle, for the depth pre-pass. Covers exactly the same pixels
+// with exactly the same depths as DrawFilledTriangle() and DrawTexturedTriangle().
+void DrawDepthTriangle(
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC
+)
+{
+    const Vec4 points[3] = { pointA, pointB, pointC };
+
+    TriangleEdges edges = {};
+    if (!SetupTriangleEdges(points, GetDrawClipRect(), &edges))
+    {
+        return;
     }
+
+    SpanTriangle spanTriangle = {};
+    SetupSpanTriangle(edges, points, &spanTriangle);
+
+    const PixelKernels kernels = GetTriangleKernels(edges);
+    const SpanPixelCounts counts = DrawTriangleSpans(edges, spanTriangle, kernels.m_DrawDepthSpan);
+
+    AddThreadFrameCounter(FrameCounter_PrepassPixelsDepthTested, counts.m_NumTested);
 }
 
 Vec3 GetTriangleNormal(const Vec4 vertices[3])
@@ -1,9 +1,4 @@
 #pragma once
-extern "C"
-{
-    #include <upng.h>
-}
-
 #include "vector.h"
 #include "common.h"
 #include "texture.h"
@@ -29,7 +24,7 @@ struct Triangle
     Vec4 m_Points[3];
     Tex2 m_TexCoords[3];
     u32 m_Color;
-    upng_t* m_Texture;
+    const Texture* m_Texture;
 };
 
 void DrawTriangle(
@@ -38,18 +33,29 @@ void DrawTriangle(
     const u32 color
 );
 
+// NOTE(sbalse): The points are in screen space, with the w component holding the w of the vertex before
+// the perspective divide.
 void DrawFilledTriangle(
-    int x0, int y0, float z0, float w0,
-    int x1, int y1, float z1, float w1,
-    int x2, int y2, float z2, float w2,
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC,
     const u32 color
 );
 
 void DrawTexturedTriangle(
-    int x0, int y0, float z0, float w0, float u0, float v0,
-    int x1, int y1, float z1, float w1, float u1, float v1,
-    int x2, int y2, float z2, float w2, float u2, float v2,
-    const upng_t* const texture
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC,
+    const Tex2 aUV,
+    const Tex2 bUV,
+    const Tex2 cUV,
+    const Texture* const texture
+);
+
+void DrawDepthTriangle(
+    const Vec4 pointA,
+    const Vec4 pointB,
+    const Vec4 pointC
 );
 
 Vec3 GetTriangleNormal(const Vec4 vertices[3]);
@@ -1,4 +1,11 @@
 #pragma once
+#include <cmath>
+#include <type_traits>
+#include <xmmintrin.h>
+
+// NOTE(sbalse): All the vector and matrix math is defined in the headers so every call is inlined. The
+// functions are constexpr where the standard library allows it, the Vec4 ones use SSE when not evaluated
+// at compile time.
 
 struct Vec2
 {
@@ -23,32 +30,294 @@ struct Vec4
 
 inline constexpr Vec3 ORIGIN = { 0, 0, 0 };
 
-// TODO(sbalse): Since I'm using C++, could use operator overloading for vector operations?
-
 /******** NOTE(sbalse): Vector 2 functions. ***********/
-float Vec2Length(const Vec2 value);
-Vec2 Vec2Add(const Vec2 v1, const Vec2 v2);
-Vec2 Vec2Sub(const Vec2 v1, const Vec2 v2);
-Vec2 Vec2Mul(const Vec2 v, const float factor);
-Vec2 Vec2Div(const Vec2 v, const float factor);
-float Vec2Dot(const Vec2 v1, const Vec2 v2);
-void Vec2Normalize(Vec2* const v);
+inline float Vec2Length(const Vec2 value)
+{
+    return std::sqrtf(value.m_X * value.m_X + value.m_Y * value.m_Y);
+}
+
+constexpr Vec2 Vec2Add(const Vec2 v1, const Vec2 v2)
+{
+    const Vec2 result =
+    {
+        .m_X = v1.m_X + v2.m_X,
+        .m_Y = v1.m_Y + v2.m_Y,
+    };
+    return result;
+}
+
+constexpr Vec2 Vec2Sub(const Vec2 v1, const Vec2 v2)
+{
+    const Vec2 result =
+    {
+        .m_X = v1.m_X - v2.m_X,
+        .m_Y = v1.m_Y - v2.m_Y,
+    };
+    return result;
+}
+
+constexpr Vec2 Vec2Mul(const Vec2 v, const float factor)
+{
+    const Vec2 result =
+    {
+        .m_X = v.m_X * factor,
+        .m_Y = v.m_Y * factor,
+    };
+    return result;
+}
+
+constexpr Vec2 Vec2Div(const Vec2 v, const float factor)
+{
+    const Vec2 result =
+    {
+        .m_X = v.m_X / factor,
+        .m_Y = v.m_Y / factor,
+    };
+    return result;
+}
+
+constexpr float Vec2Dot(const Vec2 v1, const Vec2 v2)
+{
+    return (v1.m_X * v2.m_X) + (v1.m_Y * v2.m_Y);
+}
+
+inline void Vec2Normalize(Vec2* const v)
+{
+    const float magnitude = Vec2Length(*v);
+    *v = Vec2Div(*v, magnitude);
+}
 
 /******** NOTE(sbalse): Vector 3 functions. ***********/
-float Vec3Length(const Vec3 value);
-Vec3 Vec3Add(const Vec3 v1, const Vec3 v2);
-Vec3 Vec3Sub(const Vec3 v1, const Vec3 v2);
-Vec3 Vec3Mul(const Vec3 v, const float factor);
-Vec3 Vec3Div(const Vec3 v, const float factor);
-Vec3 Vec3Cross(const Vec3 v1, const Vec3 v2);
-float Vec3Dot(const Vec3 v1, const Vec3 v2);
-void Vec3Normalize(Vec3* const v);
-
-Vec3 Vec3RotateX(const Vec3 value, const float angle);
-Vec3 Vec3RotateY(const Vec3 value, const float angle);
-Vec3 Vec3RotateZ(const Vec3 value, const float angle);
+inline float Vec3Length(const Vec3 value)
+{
+    return std::sqrtf(value.m_X * value.m_X + value.m_Y * value.m_Y + value.m_Z * value.m_Z);
+}
+
+constexpr Vec3 Vec3Add(const Vec3 v1, const Vec3 v2)
+{
+    const Vec3 result =
+    {
+        .m_X = v1.m_X + v2.m_X,
+        .m_Y = v1.m_Y + v2.m_Y,
+        .m_Z = v1.m_Z + v2.m_Z,
+    };
+    return result;
+}
+
+constexpr Vec3 Vec3Sub(const Vec3 v1, const Vec3 v2)
+{
+    const Vec3 result =
+    {
+        .m_X = v1.m_X - v2.m_X,
+        .m_Y = v1.m_Y - v2.m_Y,
+        .m_Z = v1.m_Z - v2.m_Z,
+    };
+    return result;
+}
+
+constexpr Vec3 Vec3Mul(const Vec3 v, const float factor)
+{
+    const Vec3 result =
+    {
+        .m_X = v.m_X * factor,
+        .m_Y = v.m_Y * factor,
+        .m_Z = v.m_Z * factor,
+    };
+    return result;
+}
+
+constexpr Vec3 Vec3Div(const Vec3 v, const float factor)
+{
+    const Vec3 result =
+    {
+        .m_X = v.m_X / factor,
+        .m_Y = v.m_Y / factor,
+        .m_Z = v.m_Z / factor,
+    };
+    return result;
+}
+
+constexpr Vec3 Vec3Cross(const Vec3 v1, const Vec3 v2)
+{
+    const Vec3 result =
+    {
+        .m_X = v1.m_Y * v2.m_Z - v1.m_Z * v2.m_Y,
+        .m_Y = v1.m_Z * v2.m_X - v1.m_X * v2.m_Z,
+        .m_Z = v1.m_X * v2.m_Y - v1.m_Y * v2.m_X,
+    };
+    return result;
+}
+
+constexpr float Vec3Dot(const Vec3 v1, const Vec3 v2)
+{
+    return (v1.m_X * v2.m_X) + (v1.m_Y * v2.m_Y) + (v1.m_Z * v2.m_Z);
+}
+
+inline void Vec3Normalize(Vec3* const v)
+{
+    const float magnitude = Vec3Length(*v);
+    *v = Vec3Div(*v, magnitude);
+}
+
+inline Vec3 Vec3RotateX(const Vec3 value, const float angle)
+{
+    const Vec3 result =
+    {
+        .m_X = value.m_X,
+        .m_Y = value.m_Y * std::cosf(angle) - value.m_Z * std::sinf(angle),
+        .m_Z = value.m_Y * std::sinf(angle) + value.m_Z * std::cosf(angle)
+    };
+
+    return result;
+}
+
+inline Vec3 Vec3RotateY(const Vec3 value, const float angle)
+{
+    const Vec3 result =
+    {
+        .m_X = value.m_X * std::cosf(angle) - value.m_Z * std::sinf(angle),
+        .m_Y = value.m_Y,
+        .m_Z = value.m_X * std::sinf(angle) + value.m_Z * std::cosf(angle)
+    };
+
+    return result;
+}
+
+inline Vec3 Vec3RotateZ(const Vec3 value, const float angle)
+{
+    const Vec3 result =
+    {
+        .m_X = value.m_X * std::cosf(angle) - value.m_Y * std::sinf(angle),
+        .m_Y = value.m_X * std::sinf(angle) + value.m_Y * std::cosf(angle),
+        .m_Z = value.m_Z
+    };
+
+    return result;
+}
+
+/******** NOTE(sbalse): Vector 4 functions. ***********/
+// NOTE(sbalse): Vec4 is 16 bytes but only 4 byte aligned, so it's moved in and out of the SSE registers
+// with unaligned loads and stores.
+inline __m128 Vec4Load(const Vec4 v)
+{
+    return _mm_loadu_ps(&v.m_X);
+}
+
+inline Vec4 Vec4Store(const __m128 v)
+{
+    Vec4 result;
+    _mm_storeu_ps(&result.m_X, v);
+    return result;
+}
+
+constexpr Vec4 Vec4Add(const Vec4 v1, const Vec4 v2)
+{
+    if (std::is_constant_evaluated())
+    {
+        return { v1.m_X + v2.m_X, v1.m_Y + v2.m_Y, v1.m_Z + v2.m_Z, v1.m_W + v2.m_W };
+    }
+    return Vec4Store(_mm_add_ps(Vec4Load(v1), Vec4Load(v2)));
+}
+
+constexpr Vec4 Vec4Sub(const Vec4 v1, const Vec4 v2)
+{
+    if (std::is_constant_evaluated())
+    {
+        return { v1.m_X - v2.m_X, v1.m_Y - v2.m_Y, v1.m_Z - v2.m_Z, v1.m_W - v2.m_W };
+    }
+    return Vec4Store(_mm_sub_ps(Vec4Load(v1), Vec4Load(v2)));
+}
+
+constexpr Vec4 Vec4Mul(const Vec4 v, const float factor)
+{
+    if (std::is_constant_evaluated())
+    {
+        return { v.m_X * factor, v.m_Y * factor, v.m_Z * factor, v.m_W * factor };
+    }
+    return Vec4Store(_mm_mul_ps(Vec4Load(v), _mm_set1_ps(factor)));
+}
+
+constexpr Vec4 Vec4Div(const Vec4 v, const float factor)
+{
+    if (std::is_constant_evaluated())
+    {
+        return { v.m_X / factor, v.m_Y / factor, v.m_Z / factor, v.m_W / factor };
+    }
+    return Vec4Store(_mm_div_ps(Vec4Load(v), _mm_set1_ps(factor)));
+}
+
+constexpr float Vec4Dot(const Vec4 v1, const Vec4 v2)
+{
+    return (v1.m_X * v2.m_X) + (v1.m_Y * v2.m_Y) + (v1.m_Z * v2.m_Z) + (v1.m_W * v2.m_W);
+}
 
 /******** NOTE(sbalse): Vector conversion functions. ***********/
-Vec4 Vec4FromVec3(const Vec3 v);
-Vec3 Vec3FromVec4(const Vec4 v);
-Vec2 Vec2FromVec4(const Vec4 v);
+constexpr Vec4 Vec4FromVec3(const Vec3 v)
+{
+    const Vec4 result =
+    {
+        .m_X = v.m_X,
+        .m_Y = v.m_Y,
+        .m_Z = v.m_Z,
+        .m_W = 1.0f,
+    };
+
+    return result;
+}
+
+constexpr Vec3 Vec3FromVec4(const Vec4 v)
+{
+    const Vec3 result =
+    {
+        .m_X = v.m_X,
+        .m_Y = v.m_Y,
+        .m_Z = v.m_Z,
+    };
+
+    return result;
+}
+
+constexpr Vec2 Vec2FromVec4(const Vec4 v)
+{
+    const Vec2 result =
+    {
+        .m_X = v.m_X,
+        .m_Y = v.m_Y,
+    };
+
+    return result;
+}
+
+/******** NOTE(sbalse): Vector operators. ***********/
+constexpr Vec2 operator+(const Vec2 v1, const Vec2 v2) { return Vec2Add(v1, v2); }
+constexpr Vec2 operator-(const Vec2 v1, const Vec2 v2) { return Vec2Sub(v1, v2); }
+constexpr Vec2 operator-(const Vec2 v) { return { -v.m_X, -v.m_Y }; }
+constexpr Vec2 operator*(const Vec2 v, const float factor) { return Vec2Mul(v, factor); }
+constexpr Vec2 operator*(const float factor, const Vec2 v) { return Vec2Mul(v, factor); }
+constexpr Vec2 operator/(const Vec2 v, const float factor) { return Vec2Div(v, factor); }
+constexpr Vec2& operator+=(Vec2& v1, const Vec2 v2) { return v1 = Vec2Add(v1, v2); }
+constexpr Vec2& operator-=(Vec2& v1, const Vec2 v2) { return v1 = Vec2Sub(v1, v2); }
+constexpr Vec2& operator*=(Vec2& v, const float factor) { return v = Vec2Mul(v, factor); }
+constexpr Vec2& operator/=(Vec2& v, const float factor) { return v = Vec2Div(v, factor); }
+
+constexpr Vec3 operator+(const Vec3 v1, const Vec3 v2) { return Vec3Add(v1, v2); }
+constexpr Vec3 operator-(const Vec3 v1, const Vec3 v2) { return Vec3Sub(v1, v2); }
+constexpr Vec3 operator-(const Vec3 v) { return { -v.m_X, -v.m_Y, -v.m_Z }; }
+constexpr Vec3 operator*(const Vec3 v, const float factor) { return Vec3Mul(v, factor); }
+constexpr Vec3 operator*(const float factor, const Vec3 v) { return Vec3Mul(v, factor); }
+constexpr Vec3 operator/(const Vec3 v, const float factor) { return Vec3Div(v, factor); }
+constexpr Vec3& operator+=(Vec3& v1, const Vec3 v2) { return v1 = Vec3Add(v1, v2); }
+constexpr Vec3& operator-=(Vec3& v1, const Vec3 v2) { return v1 = Vec3Sub(v1, v2); }
+constexpr Vec3& operator*=(Vec3& v, const float factor) { return v = Vec3Mul(v, factor); }
+constexpr Vec3& operator/=(Vec3& v, const float factor) { return v = Vec3Div(v, factor); }
+
+constexpr Vec4 operator+(const Vec4 v1, const Vec4 v2) { return Vec4Add(v1, v2); }
+constexpr Vec4 operator-(const Vec4 v1, const Vec4 v2) { return Vec4Sub(v1, v2); }
+constexpr Vec4 operator-(const Vec4 v) { return { -v.m_X, -v.m_Y, -v.m_Z, -v.m_W }; }
+constexpr Vec4 operator*(const Vec4 v, const float factor) { return Vec4Mul(v, factor); }
+constexpr Vec4 operator*(const float factor, const Vec4 v) { return Vec4Mul(v, factor); }
+constexpr Vec4 operator/(const Vec4 v, const float factor) { return Vec4Div(v, factor); }
+constexpr Vec4& operator+=(Vec4& v1, const Vec4 v2) { return v1 = Vec4Add(v1, v2); }
+constexpr Vec4& operator-=(Vec4& v1, const Vec4 v2) { return v1 = Vec4Sub(v1, v2); }
+constexpr Vec4& operator*=(Vec4& v, const float factor) { return v = Vec4Mul(v, factor); }
+constexpr Vec4& operator/=(Vec4& v, const float factor) { return v = Vec4Div(v, factor); }
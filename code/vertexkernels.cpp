@@ -0,0 +1,184 @@
+#include "vertexkernels.h"
+
+#include <immintrin.h>
+
+#include "clipping.h"
+#include "pixelkernels.h"
+
+inline constexpr size_t AVX_VERTEX_LANES = 8;
+
+// NOTE(sbalse): The vertex kernels only need AVX, which every CPU that can run the AVX2 pixel kernels has.
+static bool UseAVXVertexKernels()
+{
+    static const bool supportsAVX = IsPixelKernelMethodSupported(PixelKernelMethod::AVX2);
+    return supportsAVX;
+}
+
+// NOTE(sbalse): The AVX part of TransformPointStreamRows(), for the full groups of 8 points. Returns where it
+// stopped. Kept apart so that only this part is compiled for AVX.
+static TARGET_AVX size_t TransformPointStreamRowsAVX(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t end,
+    float* const outRows[4],
+    const int numRows)
+{
+    __m256 rows[4][4] = {};
+    for (int row = 0; row < numRows; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            rows[row][column] = _mm256_set1_ps(Mat4Get(matrix, row, column));
+        }
+    }
+
+    size_t i = first;
+    for (; i + AVX_VERTEX_LANES <= end; i += AVX_VERTEX_LANES)
+    {
+        const __m256 x = _mm256_loadu_ps(points.m_X + i);
+        const __m256 y = _mm256_loadu_ps(points.m_Y + i);
+        const __m256 z = _mm256_loadu_ps(points.m_Z + i);
+        for (int row = 0; row < numRows; row++)
+        {
+            __m256 result = _mm256_mul_ps(rows[row][0], x);
+            result = _mm256_add_ps(result, _mm256_mul_ps(rows[row][1], y));
+            result = _mm256_add_ps(result, _mm256_mul_ps(rows[row][2], z));
+            result = _mm256_add_ps(result, rows[row][3]);
+            _mm256_storeu_ps(outRows[row] + i, result);
+        }
+    }
+
+    return i;
+}
+
+// NOTE(sbalse): Multiply the points with the first numRows rows of the matrix. The products are summed in the
+// same order as in Mat4MulVec4(), and w being 1 the last one is the matrix value itself, so both kernels
+// give exactly the same results as it does.
+static void TransformPointStreamRows(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t count,
+    float* const outRows[4],
+    const int numRows)
+{
+    const size_t end = first + count;
+    size_t i = first;
+
+    if (UseAVXVertexKernels())
+    {
+        i = TransformPointStreamRowsAVX(matrix, points, first, end, outRows, numRows);
+    }
+
+    // NOTE(sbalse): The vertices left over after the last full group of 8, or all of them without AVX.
+    for (; i < end; i++)
+    {
+        for (int row = 0; row < numRows; row++)
+        {
+            outRows[row][i] = Mat4Get(matrix, row, 0) * points.m_X[i]
+                + Mat4Get(matrix, row, 1) * points.m_Y[i]
+                + Mat4Get(matrix, row, 2) * points.m_Z[i]
+                + Mat4Get(matrix, row, 3);
+        }
+    }
+}
+
+void TransformPointStreams(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t count,
+    const Vec3Streams& outPoints)
+{
+    float* const outRows[4] = { outPoints.m_X, outPoints.m_Y, outPoints.m_Z, nullptr };
+    TransformPointStreamRows(matrix, points, first, count, outRows, 3);
+}
+
+void ProjectPointStreams(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t count,
+    const Vec4Streams& outPoints)
+{
+    float* const outRows[4] = { outPoints.m_X, outPoints.m_Y, outPoints.m_Z, outPoints.m_W };
+    TransformPointStreamRows(matrix, points, first, count, outRows, 4);
+}
+
+// NOTE(sbalse): The AVX part of GetHomogeneousOutcodeStreams(), for the full groups of 8 vertices. Returns where
+// it stopped.
+static TARGET_AVX size_t GetHomogeneousOutcodeStreamsAVX(
+    const Vec4Streams& vertices,
+    const size_t first,
+    const size_t end,
+    const float sidePlaneScale,
+    u8* const outOutcodes)
+{
+    const __m256 scale = _mm256_set1_ps(sidePlaneScale);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 planeBits[FrustumPlane_Count] = {};
+    for (int plane = 0; plane < FrustumPlane_Count; plane++)
+    {
+        planeBits[plane] = _mm256_castsi256_ps(_mm256_set1_epi32(1 << plane));
+    }
+
+    size_t i = first;
+    for (; i + AVX_VERTEX_LANES <= end; i += AVX_VERTEX_LANES)
+    {
+        const __m256 x = _mm256_loadu_ps(vertices.m_X + i);
+        const __m256 y = _mm256_loadu_ps(vertices.m_Y + i);
+        const __m256 z = _mm256_loadu_ps(vertices.m_Z + i);
+        const __m256 w = _mm256_loadu_ps(vertices.m_W + i);
+        const __m256 sideW = _mm256_mul_ps(scale, w);
+
+        // NOTE(sbalse): The same plane distances as GetHomogeneousOutcode(), in FrustumPlane order.
+        const __m256 distances[FrustumPlane_Count] =
+        {
+            _mm256_add_ps(sideW, x),
+            _mm256_sub_ps(sideW, x),
+            _mm256_sub_ps(sideW, y),
+            _mm256_add_ps(sideW, y),
+            z,
+            _mm256_sub_ps(w, z),
+        };
+
+        // NOTE(sbalse): Not greater than, so that NaN distances count as outside like in the scalar version.
+        __m256 outcodes = zero;
+        for (int plane = 0; plane < FrustumPlane_Count; plane++)
+        {
+            const __m256 isOutside = _mm256_cmp_ps(distances[plane], zero, _CMP_NGT_UQ);
+            outcodes = _mm256_or_ps(outcodes, _mm256_and_ps(isOutside, planeBits[plane]));
+        }
+
+        alignas(32) u32 laneOutcodes[AVX_VERTEX_LANES];
+        _mm256_store_ps(rcast<float*>(laneOutcodes), outcodes);
+        for (size_t lane = 0; lane < AVX_VERTEX_LANES; lane++)
+        {
+            outOutcodes[i + lane] = scast<u8>(laneOutcodes[lane]);
+        }
+    }
+
+    return i;
+}
+
+void GetHomogeneousOutcodeStreams(
+    const Vec4Streams& vertices,
+    const size_t first,
+    const size_t count,
+    const float sidePlaneScale,
+    u8* const outOutcodes)
+{
+    const size_t end = first + count;
+    size_t i = first;
+
+    if (UseAVXVertexKernels())
+    {
+        i = GetHomogeneousOutcodeStreamsAVX(vertices, first, end, sidePlaneScale, outOutcodes);
+    }
+
+    for (; i < end; i++)
+    {
+        outOutcodes[i] = GetHomogeneousOutcode(GetVec4FromStreams(vertices, i), sidePlaneScale);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "common.h"
+#include "arena.h"
+#include "vector.h"
+#include "matrix.h"
+
+// NOTE(sbalse): Vectors stored as a structure of arrays, every component in its own stream. The vertex
+// kernels load 8 vertices per instruction from them without any shuffling.
+struct Vec3Streams
+{
+    float* m_X;
+    float* m_Y;
+    float* m_Z;
+};
+
+struct Vec4Streams
+{
+    float* m_X;
+    float* m_Y;
+    float* m_Z;
+    float* m_W;
+};
+
+// NOTE(sbalse): Every stream starts on its own 32 byte boundary, so a group of 8 vertices starting at a
+// multiple of 8 is one aligned AVX load.
+inline constexpr size_t VERTEX_STREAM_ALIGNMENT = 32;
+
+inline float* PushVertexStream(Arena* const arena, const size_t count)
+{
+    return rcast<float*>(ArenaAllocAligned(arena, sizeof(float) * count, VERTEX_STREAM_ALIGNMENT));
+}
+
+inline Vec3Streams PushVec3Streams(Arena* const arena, const size_t count)
+{
+    Vec3Streams result = {};
+    result.m_X = PushVertexStream(arena, count);
+    result.m_Y = PushVertexStream(arena, count);
+    result.m_Z = PushVertexStream(arena, count);
+    return result;
+}
+
+inline Vec4Streams PushVec4Streams(Arena* const arena, const size_t count)
+{
+    Vec4Streams result = {};
+    result.m_X = PushVertexStream(arena, count);
+    result.m_Y = PushVertexStream(arena, count);
+    result.m_Z = PushVertexStream(arena, count);
+    result.m_W = PushVertexStream(arena, count);
+    return result;
+}
+
+inline Vec3 GetVec3FromStreams(const Vec3Streams& streams, const size_t index)
+{
+    return { streams.m_X[index], streams.m_Y[index], streams.m_Z[index] };
+}
+
+inline Vec4 GetVec4FromStreams(const Vec4Streams& streams, const size_t index)
+{
+    return { streams.m_X[index], streams.m_Y[index], streams.m_Z[index], streams.m_W[index] };
+}
+
+// NOTE(sbalse): Multiply the points [first, first + count) with the matrix, taking their w as 1. The x, y
+// and z of the results go to outPoints. Gives exactly the same results as Mat4MulVec4().
+void TransformPointStreams(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t count,
+    const Vec3Streams& outPoints
+);
+// NOTE(sbalse): Same as TransformPointStreams() but keeps the w of the results, e.g. for projecting to clip
+// space.
+void ProjectPointStreams(
+    const Mat4& matrix,
+    const Vec3Streams& points,
+    const size_t first,
+    const size_t count,
+    const Vec4Streams& outPoints
+);
+// NOTE(sbalse): GetHomogeneousOutcode() of the clip space vertices [first, first + count).
+void GetHomogeneousOutcodeStreams(
+    const Vec4Streams& vertices,
+    const size_t first,
+    const size_t count,
+    const float sidePlaneScale,
+    u8* const outOutcodes
+);